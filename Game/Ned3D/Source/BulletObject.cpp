@@ -35,7 +35,6 @@
 
 
 #include <assert.h>
-#include "Common/RotationMatrix.h"
 #include "ObjectTypes.h"
 #include "BulletObject.h"
 
@@ -54,6 +53,16 @@ BulletObject::BulletObject(Model *m,float range) :
   updateRay();
 }
 
+void BulletObject::reset()
+{
+  ColorObject::reset();
+  m_fSpeed = 100.0f;
+  m_framesLeft = 70;
+  m_victim = NULL;
+  m_victimTime = 1.0f;
+  updateRay();
+}
+
 void BulletObject::process(float dt)
 {
   // Lasts only one frame
@@ -65,8 +74,8 @@ void BulletObject::process(float dt)
   if(dt != 0.0f)
   {
     --m_framesLeft;
-    // Anything to do?
-    //updateRay();
+    // The orientation is set after spawning, and the matrix is cached
+    updateRay();
   }
 
   ColorObject::process(dt);
@@ -76,7 +85,7 @@ void BulletObject::render()
 {
   if(m_framesLeft > 0)
   {
-	  GameObject::render();
+	  ColorObject::render();
   }
   // else Invisibullet
 }
@@ -85,6 +94,12 @@ bool BulletObject::checkForBoundingBoxCollision(GameObject *victim)
 {
   if(victim == NULL) return false;
   float t = victim->getBoundingBox().rayIntersect(m_v3Position[0],m_bulletRay);
+  return checkForBoundingBoxCollision(victim, t);
+}
+
+bool BulletObject::checkForBoundingBoxCollision(GameObject *victim, float t)
+{
+  if(victim == NULL) return false;
   if(t < m_victimTime)
   {
     m_victimTime = t;
@@ -99,11 +114,8 @@ GameObject *BulletObject::getVictim()
   return m_victim;
 }
 
+/// Bank turns about the forward axis, so it doesn't change the ray.
 void BulletObject::updateRay()
 {
-  EulerAngles lookEuler = getOrientation();
-  lookEuler.bank = 0.0f;
-  RotationMatrix look;
-  look.setup(lookEuler);
-  m_bulletRay = look.objectToInertial(Vector3(0.0f,0.0f,m_range));
+  m_bulletRay = rotateObjectToInertial(Vector3(0.0f,0.0f,m_range));
 }
\ No newline at end of file
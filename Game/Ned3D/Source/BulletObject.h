@@ -51,6 +51,8 @@ public:
   
   virtual void process(float dt); ///< Processes the bullet's game logic.
   virtual void render(); ///< Renders the bullet (in this case, does nothing.)
+  virtual bool isThreadSafe() const { return true; } ///< Bullets only update themselves.
+  virtual void reset(); ///< Resets a pooled bullet so that it can be fired again.
   
   /// \brief Checks whether the ray created by the bullet intersects the bounding box
   /// of the given object.
@@ -58,6 +60,12 @@ public:
   /// \return True if the bullet ray intersects the objects bounding box.
   bool checkForBoundingBoxCollision(GameObject *victim);
 
+  /// \brief Records a hit on an object found by a batched ray query.
+  /// \param victim Pointer to the GameObject that the ray hit.
+  /// \param t Parametric distance of the hit along the bullet ray.
+  /// \return True if the hit is nearer than any recorded so far.
+  bool checkForBoundingBoxCollision(GameObject *victim, float t);
+
   /// \brief Returns a pointer to the GameObject with which the bullet collided.
   /// \return The GameObject with which the bullet collided.
   GameObject *getVictim();
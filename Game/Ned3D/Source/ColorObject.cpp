@@ -18,11 +18,24 @@ ColorObject::~ColorObject() {
 }
 
 void ColorObject::process(float dt)
+{
+}
+
+// The model is shared by every object of a kind, so the color is applied
+// just before drawing rather than while processing.
+void ColorObject::render()
 {
   int numParts = m_pModel->getPartCount();
   for (int a = 0; a < numParts; a++)
     m_pModel->setPartTextureName(a,m_allTextures[m_color].c_str());
    m_pModel->cache();
+  GameObject::render();
+}
+
+void ColorObject::reset()
+{
+  GameObject::reset();
+  m_color = RED;
 }
 
 void ColorObject::changeColor(Color col) {// set texture 
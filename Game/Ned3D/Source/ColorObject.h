@@ -21,6 +21,8 @@ public:
 	Color m_color;
 
 	virtual void process(float dt);  ///< Performs internal logic updates.
+	virtual void render();  ///< Renders the object in its color.
+	virtual void reset();  ///< Resets the object for reuse.
 	void changeColor(Color col);
 	std::vector<std::string> m_allTextures; 
 };
@@ -56,6 +56,7 @@ EnemyObject::EnemyObject(Model *m):
   m_v3Velocity = Vector3::kZeroVector;
   m_className = "Enemy";
   m_type = ObjectTypes::ENEMY;
+  setSharedAnimation(true); // many crows on the same frames
 
   m_dyingFeatherTrail = -1;
 }
@@ -65,6 +66,19 @@ EnemyObject::~EnemyObject()
 {
 }
 
+void EnemyObject::reset()
+{
+  ColorObject::reset();
+  m_behavior = BS_CRUISING;
+  m_movement = MP_HOVER;
+  m_circleCenter = Vector3::kZeroVector;
+  m_circleLeft = true;
+  m_colorTimer = 0.0f;
+  m_fSpeed = 0.0f;
+  m_v3Velocity = Vector3::kZeroVector;
+  m_dyingFeatherTrail = -1;
+}
+
 void EnemyObject::process(float dt)
 {
   m_colorTimer += dt;
@@ -172,6 +186,11 @@ void EnemyObject::move(float dt)
   } // end behavior switch
 }
 
+bool EnemyObject::isThreadSafe() const
+{
+  return m_behavior == BS_CRUISING;
+}
+
 void EnemyObject::setMovementPattern(MovementPattern pattern)
 {
   m_movement = pattern;
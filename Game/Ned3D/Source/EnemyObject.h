@@ -66,6 +66,8 @@ public:
   
   virtual void process(float dt); ///< Processes enemy game logic.
   virtual void move(float dt); ///< Handles moving the enemy.
+  virtual bool isThreadSafe() const; ///< True while cruising; dying enemies drag a particle trail.
+  virtual void reset(); ///< Resets a pooled enemy so that it can be spawned again.
   
   
   // Enemy-specific functions
@@ -76,6 +76,12 @@ m_mustChangeGameState(false)
 /// \return True on success.  False on failure (application will terminate).
 bool Game::initiate()
 {
+  // vary the game from run to run; seeding both generators with a fixed
+  // value instead makes runs repeatable
+  unsigned int seed = GetTickCount();
+  Random.seed(seed);
+  gParticle.setSeed(seed);
+
   // Load all sounds
   gSoundManager.parseXML("sounds.xml");  
  
@@ -72,11 +72,28 @@ Ned3DObjectManager::Ned3DObjectManager() :
   m_plane(NULL),
   m_terrain(NULL),
   m_water(NULL),
-  m_startingEnemies(0)
+  m_enemys(LIST_USER),
+  m_bullets(LIST_USER + 1),
+  m_startingEnemies(0),
+  m_interactions(new UniformGridBroadphase())
 {
+  // Bullets and enemies come and go all the time; recycle them rather than
+  // reallocating.  Nobody looks bullets up by name, so don't name them.
+  setObjectPoolSize(ObjectTypes::BULLET, 256);
+  setObjectPoolSize(ObjectTypes::ENEMY, 64);
+  setAnonymous(ObjectTypes::BULLET, true);
 }
 
 Ned3DObjectManager::~Ned3DObjectManager() {
+  delete m_interactions;
+}
+
+void Ned3DObjectManager::setInteractionBroadphase(InteractionBroadphase *broadphase)
+{
+  if(broadphase == NULL || broadphase == m_interactions)
+    return;
+  delete m_interactions;
+  m_interactions = broadphase;
 }
 
 void Ned3DObjectManager::setModelManager(ModelManager &models)
@@ -122,18 +139,44 @@ void Ned3DObjectManager::handleInteractions()
 		break;
 	  }
   }
-  for(ObjectSetIter bit = m_bullets.begin(); bit != m_bullets.end(); ++bit)
-  {
-    BulletObject &bullet = (BulletObject &)**bit;
-    if(!bullet.isAlive()) continue;
-      
-    // Check for bullets hitting stuff
-    for(ObjectSetIter cit = m_enemys.begin(); cit != m_enemys.end(); ++cit)
+  // Bucket the live enemies so that only nearby objects get tested against each other
+  
+  m_interactions->clear();
+  m_rayBatch.clearBoxes();
+  m_rayTargets.clear();
+  for(unsigned int g = 0; g < m_enemys.getGroupCount(); ++g)
+    for(unsigned int i = 0; i < m_enemys.getGroup(g).size(); ++i)
+    {
+      EnemyObject *enemy = (EnemyObject *)m_enemys.getGroup(g)[i];
+      if(!enemy->isAlive()) continue;
+      m_interactions->insert(enemy, enemy->getBoundingBox());
+      m_rayBatch.addBox(enemy->getBoundingBox());
+      m_rayTargets.push_back(enemy);
+    }
+  m_interactions->build();
+
+  // Bullet rays are long, so rather than walking the broadphase, test every live
+  // bullet against every live enemy in one batch
+
+  m_rayBatch.clearRays();
+  m_rayBullets.clear();
+  for(unsigned int g = 0; g < m_bullets.getGroupCount(); ++g)
+    for(unsigned int b = 0; b < m_bullets.getGroup(g).size(); ++b)
     {
-      EnemyObject &enemy = (EnemyObject &)**cit;
-      if(!enemy.isAlive()) continue;
-      interactEnemyBullet(enemy, bullet);
+      BulletObject *bullet = (BulletObject *)m_bullets.getGroup(g)[b];
+      if(!bullet->isAlive()) continue;
+      m_rayBatch.addRay(bullet->getPosition(), bullet->m_bulletRay);
+      m_rayBullets.push_back(bullet);
     }
+  m_rayBatch.findNearestHits(m_rayHits);
+
+  for(unsigned int b = 0; b < m_rayBullets.size(); ++b)
+  {
+    BulletObject &bullet = *m_rayBullets[b];
+    
+    // Check for bullets hitting stuff
+    if(m_rayHits[b].box >= 0)
+      interactEnemyBullet(*m_rayTargets[m_rayHits[b].box], bullet, m_rayHits[b].t);
     GameObject *victim = bullet.getVictim();
     if(victim != NULL)
     {
@@ -148,23 +191,56 @@ void Ned3DObjectManager::handleInteractions()
     }
   }
   
-  // Handle enemy-enemy interactions (slow....) and enemy-plane interactions
+  // Handle enemy-plane, enemy-terrain and enemy-enemy interactions
   
-  for(ObjectSetIter cit1 = m_enemys.begin(); cit1 != m_enemys.end(); ++cit1)
+  m_interactions->queryBox(m_plane->getBoundingBox(), m_interactionCandidates);
+  for(unsigned int i = 0; i < m_interactionCandidates.size(); ++i)
   {
-    EnemyObject &enemy1 = (EnemyObject &)**cit1;
-    if(!enemy1.isAlive()) continue;
-    
-    interactPlaneEnemy(*m_plane,enemy1);
-    interactEnemyTerrain(enemy1,*m_terrain);
-    
-    ObjectSetIter cit2 = cit1;
-    for(++cit2; cit2 != m_enemys.end(); ++cit2)
-    {
-      EnemyObject &enemy2 = (EnemyObject &)**cit2;
-      if(!enemy2.isAlive()) continue;
+    EnemyObject &enemy = (EnemyObject &)*m_interactionCandidates[i];
+    if(enemy.isAlive())
+      interactPlaneEnemy(*m_plane, enemy);
+  }
+
+  // Sample the terrain under the enemies that the quadtree couldn't place
+  // above it, in one batch.  Gathered after the plane has pushed enemies
+  // around, so the heights are taken where the enemies are now.  Bounding
+  // boxes aren't recomputed until after this, so the enemies the plane may
+  // have moved skip the quadtree test.
+  std::sort(m_interactionCandidates.begin(), m_interactionCandidates.end());
+  m_terrainEnemies.clear();
+  m_terrainXs.clear();
+  m_terrainZs.clear();
+  Terrain *terr = m_terrain->getTerrain();
+  if(terr != NULL)
+    for(unsigned int g = 0; g < m_enemys.getGroupCount(); ++g)
+      for(unsigned int i = 0; i < m_enemys.getGroup(g).size(); ++i)
+      {
+        EnemyObject *enemy = (EnemyObject *)m_enemys.getGroup(g)[i];
+        if(!enemy->isAlive()) continue;
+        if(terr->isBoxAboveTerrain(enemy->getBoundingBox()) &&
+           !std::binary_search(m_interactionCandidates.begin(), m_interactionCandidates.end(), enemy))
+          continue;
+        m_terrainEnemies.push_back(enemy);
+        m_terrainXs.push_back(enemy->getPosition().x);
+        m_terrainZs.push_back(enemy->getPosition().z);
+      }
+  if(!m_terrainEnemies.empty())
+  {
+    m_terrainHeights.resize(m_terrainEnemies.size());
+    terr->getHeights(&m_terrainXs[0], &m_terrainZs[0], &m_terrainHeights[0],
+      (int)m_terrainEnemies.size());
+    for(unsigned int i = 0; i < m_terrainEnemies.size(); ++i)
+      if(m_terrainEnemies[i]->isAlive())
+        interactEnemyTerrain(*m_terrainEnemies[i], m_terrainHeights[i]);
+  }
+
+  m_interactions->findPairs(m_interactionPairs);
+  for(unsigned int i = 0; i < m_interactionPairs.size(); ++i)
+  {
+    EnemyObject &enemy1 = (EnemyObject &)*m_interactionPairs[i].first;
+    EnemyObject &enemy2 = (EnemyObject &)*m_interactionPairs[i].second;
+    if(enemy1.isAlive() && enemy2.isAlive())
       interactEnemyEnemy(enemy1, enemy2);
-    }
   }
   
 
@@ -295,7 +371,7 @@ unsigned int Ned3DObjectManager::spawnEnemy(const Vector3 &position, const Euler
     m_enemyModel = m_models->getModelPointer("Enemy"); // Cache enemy model
   if(m_enemyModel == NULL)
     return 0;  // Still NULL?  No such model
-  EnemyObject *enemy = new EnemyObject(m_enemyModel);
+  EnemyObject *enemy = newEnemy();
   enemy->setSpeed(speed);
   enemy->setPosition(position);
   enemy->setOrientation(orientation);
@@ -317,7 +393,7 @@ unsigned int Ned3DObjectManager::spawnEnemy(const Vector3 &position, const Vecto
     m_enemyModel = m_models->getModelPointer("Enemy"); // Cache enemy model
   if(m_enemyModel == NULL)
     return 0;  // Still NULL?  No such model
-  EnemyObject *enemy = new EnemyObject(m_enemyModel);
+  EnemyObject *enemy = newEnemy();
   enemy->setSpeed(speed);
   enemy->setPosition(position);
   enemy->setCirclingParameters(circleCenter, flyLeft);
@@ -333,13 +409,26 @@ unsigned int Ned3DObjectManager::spawnEnemy(const Vector3 &position, const Vecto
   return id;
 }
 
+EnemyObject *Ned3DObjectManager::newEnemy()
+{
+  EnemyObject *enemy = (EnemyObject *)reuseObject(ObjectTypes::ENEMY);
+  if(enemy == NULL)
+    return new EnemyObject(m_enemyModel);
+  enemy->reset();
+  return enemy;
+}
+
 unsigned int Ned3DObjectManager::spawnBullet(const Vector3 &position, const EulerAngles &orientation,const Color color)
 {
   if(m_bulletModel == NULL)
     m_bulletModel = m_models->getModelPointer("Bullet"); // Cache enemy model
   if(m_bulletModel == NULL)
     return 0;  // Still NULL?  No such model
-  BulletObject *bullet = new BulletObject(m_bulletModel);
+  BulletObject *bullet = (BulletObject *)reuseObject(ObjectTypes::BULLET);
+  if(bullet != NULL)
+    bullet->reset();
+  else
+    bullet = new BulletObject(m_bulletModel);
   bullet->changeColor(color);
   bullet->setPosition(position);
   bullet->setOrientation(orientation);
@@ -422,11 +511,11 @@ unsigned int Ned3DObjectManager::spawnWindmill(const Vector3 &position, const Eu
 // Returns a handle to the first enemy in the list
 unsigned int Ned3DObjectManager::getEnemy()
 {
-  ObjectSetIter cit = m_enemys.begin();
-  if (cit == m_enemys.end())
+  GameObject *enemy = m_enemys.front();
+  if (enemy == NULL)
     return - 1;
 
-  return (*cit)->getID();
+  return enemy->getID();
 }
 
 // Returns true if a enemy intersects the ray
@@ -434,16 +523,18 @@ bool Ned3DObjectManager::rayIntersectEnemy(const Vector3 &position, const Vector
 {
   
   // Check for bullets hitting enemys
-  for(ObjectSetIter cit = m_enemys.begin(); cit != m_enemys.end(); ++cit)
-  {
-    EnemyObject &enemy = (EnemyObject &)**cit;
-    if(!enemy.isAlive()) continue;
-    
-    float t = enemy.getBoundingBox().rayIntersect(position,direction);
-    if(t <= 1.0f) return true;        
-  }
+  m_rayBatch.clearBoxes();
+  m_rayTargets.clear();
+  for(unsigned int g = 0; g < m_enemys.getGroupCount(); ++g)
+    for(unsigned int i = 0; i < m_enemys.getGroup(g).size(); ++i)
+    {
+      EnemyObject *enemy = (EnemyObject *)m_enemys.getGroup(g)[i];
+      if(!enemy->isAlive()) continue;
+      m_rayBatch.addBox(enemy->getBoundingBox());
+      m_rayTargets.push_back(enemy);
+    }
 
-  return false;
+  return m_rayBatch.hitsAny(position, direction);
 }
 
 void Ned3DObjectManager::deleteObject(GameObject *object)
@@ -491,6 +582,9 @@ bool Ned3DObjectManager::interactPlaneTerrain(PlaneObject &plane, TerrainObject
   Terrain *terr = terrain.getTerrain();
   if(terr == NULL) return false;
 
+  // Nothing to do while the plane is clear of everything under it
+  if(terr->isBoxAboveTerrain(plane.getBoundingBox())) return false;
+
   //test for plane collision with terrain
   Vector3 planePos = plane.getPosition();
   EulerAngles planeOrient = plane.getOrientation();
@@ -576,9 +670,9 @@ bool Ned3DObjectManager::interactPlaneFurniture(PlaneObject &plane, GameObject &
   return enforcePosition(plane, silo);
 }
 
-bool Ned3DObjectManager::interactEnemyBullet(EnemyObject &enemy, BulletObject &bullet)
+bool Ned3DObjectManager::interactEnemyBullet(EnemyObject &enemy, BulletObject &bullet, float t)
 {
-  return bullet.checkForBoundingBoxCollision(&enemy);
+  return bullet.checkForBoundingBoxCollision(&enemy, t);
 }
 
 bool Ned3DObjectManager::interactEnemyEnemy(EnemyObject &enemy1, EnemyObject &enemy2)
@@ -587,15 +681,11 @@ bool Ned3DObjectManager::interactEnemyEnemy(EnemyObject &enemy1, EnemyObject &en
 }
 
 
-bool Ned3DObjectManager::interactEnemyTerrain(EnemyObject &enemy, TerrainObject &terrain)
+bool Ned3DObjectManager::interactEnemyTerrain(EnemyObject &enemy, float terrainHeight)
 {
-  Terrain *terr = terrain.getTerrain();
-  if(terr == NULL) return false;
-
   //test for enemy collision with terrain
   Vector3 enemyPos = enemy.getPosition();
     
-  float terrainHeight = terr->getHeight(enemyPos.x,enemyPos.z);
   if (enemyPos.y < terrainHeight)
   {
     enemyPos.y = terrainHeight;
@@ -37,7 +37,9 @@
 
 #include "Common/Vector3.h"
 #include "Common/EulerAngles.h"
+#include "Common/RayBoxBatch.h"
 #include "Objects/GameObjectManager.h"
+#include "Objects/InteractionBroadphase.h"
 #include "ObjectTypes.h"
 #include "ColorObject.h"
 
@@ -116,6 +118,14 @@ class Ned3DObjectManager : public GameObjectManager
     virtual void clear(); ///< Clears the object manager, removing all objects.
     virtual void handleInteractions(); ///< Handles the interactions between all the objects.
 
+    /// \brief Sets the broadphase used to cull enemy and bullet interaction tests.
+    /// \param broadphase The new broadphase.  The manager takes ownership of it.
+    void setInteractionBroadphase(InteractionBroadphase *broadphase);
+
+    /// \brief Returns the broadphase used to cull interaction tests.
+    /// \return Pointer to the broadphase; its statistics cover the last frame.
+    InteractionBroadphase *getInteractionBroadphase() { return m_interactions; }
+
 	bool importXml(const std::string &fileName, bool defaultDirectory=true);
 
     /// \brief Spawns a plane object.
@@ -195,12 +205,13 @@ class Ned3DObjectManager : public GameObjectManager
     bool interactPlaneWater(PlaneObject &plane, WaterObject &water); ///< Handles possible plane-water collision
     bool interactPlaneFurniture(PlaneObject &plane, GameObject &furniture); ///< Handles possible plane-furniture collision
     bool interactEnemyEnemy(EnemyObject &enemy1, EnemyObject &enemy2); ///< Handles enemy-enemy interactions, such as possible collision
-    bool interactEnemyTerrain(EnemyObject &enemy, TerrainObject &terrain); ///< Handles enemy-terrain interactions, such as possible collision
-    bool interactEnemyBullet(EnemyObject &enemy, BulletObject &bullet); ///< Handles possible enemy-bullet collision
+    bool interactEnemyTerrain(EnemyObject &enemy, float terrainHeight); ///< Handles enemy-terrain interactions, such as possible collision
+    bool interactEnemyBullet(EnemyObject &enemy, BulletObject &bullet, float t); ///< Handles an enemy-bullet hit found t along the bullet ray
     
 	void setNextBox(BoxObject* b, float wall); ///< Sets next wall
 
     void shootEnemy(EnemyObject &enemy); ///< Handles enemy-bullet collision
+    EnemyObject *newEnemy(); ///< Takes an enemy from the pool, or creates one.
     
     bool enforcePosition(GameObject &moving, GameObject &stationary); ///< Blocks a moving object from intersecting a stationary object.
     bool enforcePositions(GameObject &obj1, GameObject &obj2); ///< Blocks two moving objects from intersecting each other.
@@ -218,11 +229,24 @@ class Ned3DObjectManager : public GameObjectManager
     Model *m_windmillModel; ///< Pointer to the windmill model.
 
     PlaneObject *m_plane;  ///> Points to the sole plane object.
-    ObjectSet m_enemys;     ///> Tracks the very evil enemys
-    ObjectSet m_bullets;   ///> Tracks bullets
+    GameObjectList m_enemys;  ///> Tracks the very evil enemys
+    GameObjectList m_bullets; ///> Tracks bullets
     TerrainObject *m_terrain; ///> Points to the sole terrain object.  (not owned)
     WaterObject *m_water; ///> Points to the sole water object.  (not owned)
     ObjectSet m_furniture; ///> Silos, windmills, etc.
+
+    InteractionBroadphase *m_interactions; ///< Culls enemy-enemy, enemy-bullet and plane-enemy tests.
+    InteractionBroadphase::PairList m_interactionPairs; ///< Scratch list of overlapping enemy pairs.
+    InteractionBroadphase::ObjectList m_interactionCandidates; ///< Scratch list of enemies near a query.
+
+    RayBoxBatch m_rayBatch; ///< Enemy boxes and bullet rays, tested against each other in one go.
+    std::vector<RayBoxBatch::Hit> m_rayHits; ///< Nearest enemy hit by each bullet ray.
+    std::vector<EnemyObject *> m_rayTargets; ///< Enemy for each box in m_rayBatch.
+    std::vector<BulletObject *> m_rayBullets; ///< Bullet for each ray in m_rayBatch.
+    std::vector<EnemyObject *> m_terrainEnemies; ///< Enemies low enough to maybe touch the terrain.
+    std::vector<float> m_terrainXs; ///< X coordinate of each enemy in m_terrainEnemies.
+    std::vector<float> m_terrainZs; ///< Z coordinate of each enemy in m_terrainEnemies.
+    std::vector<float> m_terrainHeights; ///< Terrain height under each enemy in m_terrainEnemies.
 };
 
 
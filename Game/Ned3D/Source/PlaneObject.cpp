@@ -41,7 +41,6 @@
 #include "PlaneObject.h"
 #include "Input/Input.h"
 #include "ObjectTypes.h"
-#include "common/RotationMatrix.h"
 #include "Ned3DObjectManager.h"
 #include "Particle/ParticleEngine.h"
 #include "Sound/SoundManager.h"
@@ -149,16 +148,12 @@ void PlaneObject::renderReticle(float distance, float size)
 
     Vector3 bulletDir = Vector3(0, 0, 1);    
         
-    // set up a matrix to rotate points that are relative to the plane
-    RotationMatrix r1;
-    r1.setup(getOrientation());
-
     // transform points relative to the plane
-    bulletDir = r1.objectToInertial(bulletDir);
-    gunPos = r1.objectToInertial(gunPos);
-    reticlePos = r1.objectToInertial(reticlePos);    
-    right = r1.objectToInertial(right);
-    up = r1.objectToInertial(up);
+    bulletDir = rotateObjectToInertial(bulletDir);
+    gunPos = rotateObjectToInertial(gunPos);
+    reticlePos = rotateObjectToInertial(reticlePos);    
+    right = rotateObjectToInertial(right);
+    up = rotateObjectToInertial(up);
 
     // add position of the plane
     reticlePos += getPosition();
@@ -822,12 +817,9 @@ void PlaneObject::inputFire()
   Vector3 bulletDir = Vector3(0, 0, 1);
   Vector3 gunPos = m_gunPosition;
 
-  RotationMatrix r1;
-  r1.setup(getOrientation());
-  
-  bulletDir = r1.objectToInertial(bulletDir);
+  bulletDir = rotateObjectToInertial(bulletDir);
   gunPos.z += 5.0f;
-  gunPos = r1.objectToInertial(gunPos);
+  gunPos = rotateObjectToInertial(gunPos);
   gunPos += getPosition();
   Vector3 intersectPoint = Vector3::kZeroVector;
   
@@ -920,8 +912,7 @@ void PlaneObject::damage(int hp)
     m_planeState = PS_CRASHING;
     m_velocity = Vector3::kForwardVector;
     m_eaOrient[0].pitch = degToRad(20);
-    RotationMatrix r; r.setup(m_eaOrient[0]);
-    m_velocity = r.objectToInertial(m_velocity);
+    m_velocity = rotateObjectToInertial(m_velocity);
     m_velocity *= m_maxSpeed * m_speedRatio * 20.0f;
   }
 }
@@ -37,15 +37,22 @@
 #include "game.h"
 #include "input/input.h"
 #include <algorithm>
+#include <hash_set>
+#include <vector>
 #include "DirectoryManager/DirectoryManager.h"
+#include "Common/CommonStuff.h"
 #include "Common/MathUtil.h"
 #include "Common/Renderer.h"
 #include "Common/Random.h"
+#include "Common/RayBoxBatch.h"
 #include "Common/RotationMatrix.h"
 #include "Console/Console.h"
 #include "Graphics/ModelManager.h"
 #include "Input/Input.h"
+#include "Particle/Particle.h"
+#include "Particle/ParticleBillboards.h"
 #include "Particle/ParticleEngine.h"
+#include "Particle/ParticleSorter.h"
 #include "Sound/SoundManager.h"
 #include "Terrain/Terrain.h"
 #include "WindowsWrapper/WindowsWrapper.h"
@@ -92,6 +99,514 @@ bool StatePlaying::consoleGodMode(ParameterList* params,std::string* errorMessag
   return true;
 }
 
+bool StatePlaying::consoleBroadphase(ParameterList* params,std::string* errorMessage)
+{
+  InteractionBroadphase *broadphase = NULL;
+  if(params->Strings[0] == "grid")
+    broadphase = new UniformGridBroadphase();
+  else if(params->Strings[0] == "sap")
+    broadphase = new SweepAndPruneBroadphase();
+  else if(params->Strings[0] == "brute")
+    broadphase = new BruteForceBroadphase();
+  else
+  {
+    *errorMessage = "Unknown broadphase.  Use grid, sap or brute.";
+    return false;
+  }
+  gGame.m_statePlaying.m_objects->setInteractionBroadphase(broadphase);
+  return true;
+}
+
+bool StatePlaying::consoleBroadphaseStats(ParameterList* params,std::string* errorMessage)
+{
+  InteractionBroadphase *broadphase = gGame.m_statePlaying.m_objects->getInteractionBroadphase();
+  char text[256];
+  sprintf_s(text, sizeof(text), "%s: %u objects, %u pairs tested, %u candidates last frame",
+    broadphase->getName(), broadphase->getObjectCount(), broadphase->getPairsTested(), broadphase->getPairsFound());
+  gConsole.printLine(text);
+  return true;
+}
+
+bool StatePlaying::consoleUpdateThreads(ParameterList* params,std::string* errorMessage)
+{
+  if(params->Ints[0] < 0)
+  {
+    *errorMessage = "Thread count can't be negative.";
+    return false;
+  }
+  gGame.m_statePlaying.m_objects->setUpdateThreads((unsigned int)params->Ints[0]);
+  char text[64];
+  sprintf_s(text, sizeof(text), "Updating objects on %u thread(s)",
+    gGame.m_statePlaying.m_objects->getUpdateThreads());
+  gConsole.printLine(text);
+  return true;
+}
+
+bool StatePlaying::consoleParticleStats(ParameterList* params,std::string* errorMessage)
+{
+  int systems, particles, dropped, stolen;
+  gParticle.getPerformanceData(&systems, &particles, &dropped, &stolen);
+  char text[256];
+  sprintf_s(text, sizeof(text), "%d particle systems, %d particles, %d systems dropped, %d stolen",
+    systems, particles, dropped, stolen);
+  gConsole.printLine(text);
+  return true;
+}
+
+bool StatePlaying::consoleParticleThreads(ParameterList* params,std::string* errorMessage)
+{
+  if(params->Ints[0] < 0)
+  {
+    *errorMessage = "Thread count can't be negative.";
+    return false;
+  }
+  gParticle.setUpdateThreads((unsigned int)params->Ints[0]);
+  char text[64];
+  sprintf_s(text, sizeof(text), "Updating particle effects on %u thread(s)",
+    gParticle.getUpdateThreads());
+  gConsole.printLine(text);
+  return true;
+}
+
+/// Times 1000 random rays against 1000 random boxes, once with one AABB3::rayIntersect
+/// call per pair and once through RayBoxBatch, and prints both times.
+bool StatePlaying::consoleRayBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  const int kCount = 1000;
+  std::vector<AABB3> boxes(kCount);
+  std::vector<Vector3> origins(kCount), deltas(kCount);
+  RayBoxBatch batch;
+  for(int i = 0; i < kCount; ++i)
+  {
+    Vector3 center(Random.getFloat(-500.0f, 500.0f), Random.getFloat(-500.0f, 500.0f), Random.getFloat(-500.0f, 500.0f));
+    Vector3 halfSize(Random.getFloat(1.0f, 5.0f), Random.getFloat(1.0f, 5.0f), Random.getFloat(1.0f, 5.0f));
+    boxes[i].min = center - halfSize;
+    boxes[i].max = center + halfSize;
+    batch.addBox(boxes[i]);
+    origins[i] = Vector3(Random.getFloat(-500.0f, 500.0f), Random.getFloat(-500.0f, 500.0f), Random.getFloat(-500.0f, 500.0f));
+    deltas[i] = Vector3(Random.getFloat(-1000.0f, 1000.0f), Random.getFloat(-1000.0f, 1000.0f), Random.getFloat(-1000.0f, 1000.0f));
+    batch.addRay(origins[i], deltas[i]);
+  }
+
+  double start = getPerformanceTime();
+  int scalarHits = 0;
+  for(int r = 0; r < kCount; ++r)
+  {
+    float nearest = 1.0f;
+    bool hit = false;
+    for(int b = 0; b < kCount; ++b)
+    {
+      float t = boxes[b].rayIntersect(origins[r], deltas[r]);
+      if(t <= nearest)
+      {
+        nearest = t;
+        hit = true;
+      }
+    }
+    if(hit) ++scalarHits;
+  }
+  double middle = getPerformanceTime();
+  std::vector<RayBoxBatch::Hit> hits;
+  batch.findNearestHits(hits);
+  double end = getPerformanceTime();
+  int batchHits = 0;
+  for(unsigned int i = 0; i < hits.size(); ++i)
+    if(hits[i].box >= 0) ++batchHits;
+
+  char text[256];
+  sprintf_s(text, sizeof(text), "1000 rays x 1000 boxes:  rayIntersect %.2f ms (%d hits), batch%s %.2f ms (%d hits)",
+    middle - start, scalarHits,
+    RayBoxBatch::usesSSE() ? " (SSE)" : "",
+    end - middle, batchHits);
+  gConsole.printLine(text);
+  return true;
+}
+
+// The ray test Terrain::rayIntersect used to do:  check 300 evenly spaced
+// points along the ray, stopping at the first one below the terrain.
+static bool marchTerrainRay(Terrain* terrain, Vector3 pos, Vector3 dir, Vector3& outPos)
+{
+  const int numSteps = 300;
+  dir /= (float)numSteps;
+  bool foundFirstInBounds = false;
+  for(int i = 0; i < numSteps; ++i)
+  {
+    pos += dir;
+    if(terrain->isPointWithinBounds(pos.x, pos.z))
+    {
+      foundFirstInBounds = true;
+      float height = terrain->getHeight(pos.x, pos.z);
+      if(height > pos.y)
+      {
+        outPos = Vector3(pos.x, height, pos.z);
+        return true;
+      }
+    }
+    else if(foundFirstInBounds)
+      break;
+  }
+  return false;
+}
+
+/// Times 1000 random rays against the terrain, once by marching 300 steps
+/// along each ray and once through the batched grid traversal, and prints
+/// both times.
+bool StatePlaying::consoleTerrainRayBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  Terrain* terrain = gGame.m_statePlaying.terrain;
+  if(terrain == NULL)
+  {
+    *errorMessage = "No terrain loaded.";
+    return false;
+  }
+
+  const int kCount = 1000;
+  std::vector<Vector3> origins(kCount), deltas(kCount), points(kCount);
+  bool hits[kCount];
+  for(int i = 0; i < kCount; ++i)
+  {
+    float x, z;
+    do
+    {
+      x = Random.getFloat(-1000.0f, 1000.0f);
+      z = Random.getFloat(-1000.0f, 1000.0f);
+    } while(!terrain->isPointWithinBounds(x, z));
+    origins[i] = Vector3(x, terrain->getHeight(x, z) + Random.getFloat(5.0f, 100.0f), z);
+    deltas[i] = Vector3(Random.getFloat(-500.0f, 500.0f), Random.getFloat(-100.0f, 20.0f), Random.getFloat(-500.0f, 500.0f));
+  }
+
+  double start = getPerformanceTime();
+  int marchHits = 0;
+  for(int i = 0; i < kCount; ++i)
+    if(marchTerrainRay(terrain, origins[i], deltas[i], points[i])) ++marchHits;
+  double middle = getPerformanceTime();
+  int batchHits = terrain->rayIntersect(&origins[0], &deltas[0], kCount, hits, &points[0]);
+  double end = getPerformanceTime();
+
+  char text[256];
+  sprintf_s(text, sizeof(text), "1000 terrain rays:  300 step march %.2f ms (%d hits), grid traversal %.2f ms (%d hits)",
+    middle - start, marchHits,
+    end - middle, batchHits);
+  gConsole.printLine(text);
+  return true;
+}
+
+/// Sorts a cloud of particles back to front with each ParticleSorter mode
+/// while the camera orbits it, 2 degrees a frame for 180 frames, and prints
+/// the total time each mode took.
+bool StatePlaying::consoleParticleSortBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  int count = params->Ints[0];
+  if(count < 1)
+  {
+    *errorMessage = "Particle count must be positive.";
+    return false;
+  }
+
+  const int kFrames = 180;
+  const char* names[] = {"bubble", "insertion", "radix"};
+  const ParticleSorter::Mode modes[] = {ParticleSorter::SORT_BUBBLE,
+    ParticleSorter::SORT_INSERTION, ParticleSorter::SORT_RADIX};
+
+  std::vector<Vector3> positions(count);
+  std::vector<float> distance(count);
+  for(int i = 0; i < count; ++i)
+    positions[i] = Vector3(Random.getFloat(-50.0f, 50.0f), Random.getFloat(-50.0f, 50.0f), Random.getFloat(-50.0f, 50.0f));
+
+  char text[256];
+  int length = sprintf_s(text, sizeof(text), "%d particles, %d frames:", count, kFrames);
+  for(int m = 0; m < 3; ++m)
+  {
+    ParticleSorter sorter;
+    std::vector<int> order(count);
+    for(int i = 0; i < count; ++i)
+      order[i] = i;
+
+    double total = 0.0;
+    for(int frame = 0; frame < kFrames; ++frame)
+    {
+      float angle = degToRad(2.0f * frame);
+      Vector3 camera(200.0f * cos(angle), 20.0f, 200.0f * sin(angle));
+      for(int i = 0; i < count; ++i)
+        distance[i] = (positions[i] - camera).magnitudeSquared();
+
+      double start = getPerformanceTime();
+      sorter.sort(modes[m], &distance[0], &order[0], count);
+      total += getPerformanceTime() - start;
+    }
+    length += sprintf_s(text + length, sizeof(text) - length, "  %s %.2f ms", names[m], total);
+  }
+  gConsole.printLine(text);
+  return true;
+}
+
+/// Times one frame of particle deaths for a few patterns, removing the dead
+/// one at a time the way ParticleEffect used to and with a single compaction.
+bool StatePlaying::consoleParticleKillBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  int count = params->Ints[0];
+  if(count < 2)
+  {
+    *errorMessage = "Particle count must be at least 2.";
+    return false;
+  }
+
+  // which particles expire: all of them, every other one, the older half
+  const char* names[] = {"all", "alternate", "front half"};
+  const int kPatterns = 3;
+
+  ParticleArrays particles;
+  particles.allocate(count);
+
+  char text[256];
+  gConsole.printLine("Expiring particles, one at a time vs compacted:");
+  for(int pattern = 0; pattern < kPatterns; ++pattern)
+  {
+    double times[2];
+    int survivors[2];
+    for(int method = 0; method < 2; ++method)
+    {
+      for(int i = 0; i < count; ++i)
+      {
+        bool dies = pattern == 0 || (pattern == 1 && (i & 1) != 0) || (pattern == 2 && i < count / 2);
+        particles.lifeleft[i] = dies ? -1.0f : 1.0f;
+        particles.posX[i] = (float)i;
+      }
+
+      int live = count;
+      double start = getPerformanceTime();
+      if(method == 0)
+      {
+        for(int i = live - 1; i >= 0; --i)
+          if(particles.lifeleft[i] < 0.0f)
+            particles.remove(i, live--);
+      }
+      else
+        live = particles.removeExpired(live);
+      times[method] = getPerformanceTime() - start;
+      survivors[method] = live;
+    }
+
+    if(survivors[0] != survivors[1])
+    {
+      *errorMessage = "Kill methods disagree on the number of survivors.";
+      return false;
+    }
+    sprintf_s(text, sizeof(text), "  %s of %d: %.3f ms vs %.3f ms, %d left", names[pattern], count, times[0], times[1], survivors[1]);
+    gConsole.printLine(text);
+  }
+  return true;
+}
+
+/// Times ParticleBillboards::expand writing into plain memory, so the cost of
+/// building the quads can be seen apart from the cost of drawing them.
+bool StatePlaying::consoleBillboardBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  int count = params->Ints[0];
+  if(count < 1)
+  {
+    *errorMessage = "Particle count must be positive.";
+    return false;
+  }
+
+  const int kFrames = 60;
+  ParticleArrays particles;
+  particles.allocate(count);
+  for(int i = 0; i < count; ++i)
+  {
+    particles.posX[i] = Random.getFloat(-50.0f, 50.0f);
+    particles.posY[i] = Random.getFloat(-50.0f, 50.0f);
+    particles.posZ[i] = Random.getFloat(-50.0f, 50.0f);
+    particles.rotation[i] = Random.getFloat(-kPi, kPi);
+    particles.color[i] = 0xFFFFFFFF;
+  }
+
+  std::vector<BillboardVertex> vertices(4 * count);
+  double total = 0.0;
+  for(int frame = 0; frame < kFrames; ++frame)
+  {
+    float angle = degToRad(2.0f * frame);
+    Vector3 right(cos(angle), 0.0f, -sin(angle));
+    Vector3 up(0.0f, 1.0f, 0.0f);
+
+    double start = getPerformanceTime();
+    ParticleBillboards::expand(particles, count, right, up, 0.5f, &vertices[0]);
+    total += getPerformanceTime() - start;
+  }
+
+  char text[256];
+  sprintf_s(text, sizeof(text), "%d particles: %.3f ms per frame to build quads", count, total / kFrames);
+  gConsole.printLine(text);
+  return true;
+}
+
+// Object for consoleUpdateBenchmark:  turns and flies forward with no model,
+// so only the manager's passes and the basic movement code are timed.
+class BenchObject : public GameObject
+{
+public:
+  BenchObject(int type) : GameObject(NULL)
+  {
+    m_type = type;
+    m_fSpeed = 1.0f;
+    m_eaAngularVelocity[0].heading = 0.5f;
+  }
+  virtual bool isThreadSafe() const { return true; }
+  virtual void process(float dt) { m_fSpeed = 1.0f + 0.5f * sin(m_eaOrient[0].heading); }
+  virtual void move(float dt) { GameObject::move(dt, true); }
+};
+
+// Manager for consoleUpdateBenchmark.  The default handleInteractions() tests
+// every pair, which would swamp the timing, so interactions are skipped.
+class BenchObjectManager : public GameObjectManager
+{
+protected:
+  virtual void handleInteractions() {}
+};
+
+/// Fills a spare object manager with objects of a few types and times its
+/// update() over 60 frames.  For comparison it then times the same process,
+/// move and bounding box passes walking a stdext::hash_set of the objects,
+/// the way the manager stored them before it kept dense per-type arrays.
+bool StatePlaying::consoleUpdateBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  int count = params->Ints[0];
+  if(count < 1)
+  {
+    *errorMessage = "Object count must be positive.";
+    return false;
+  }
+
+  const int kFrames = 60;
+  const int kTypes = 4;
+  const float dt = 1.0f / 60.0f;
+  BenchObjectManager manager;
+  manager.setUpdateThreads(gGame.m_statePlaying.m_objects->getUpdateThreads());
+  stdext::hash_set<GameObject *> set;
+  for(int i = 0; i < count; ++i)
+  {
+    BenchObject *object = new BenchObject(i % kTypes);
+    object->setPosition(Vector3(Random.getFloat(-500.0f, 500.0f), 0.0f, Random.getFloat(-500.0f, 500.0f)));
+    manager.addObject(object, true, true, false);
+    set.insert(object);
+  }
+  manager.update(dt); // brings the new objects to life
+
+  double start = getPerformanceTime();
+  for(int frame = 0; frame < kFrames; ++frame)
+    manager.update(dt);
+  double dense = getPerformanceTime() - start;
+
+  start = getPerformanceTime();
+  for(int frame = 0; frame < kFrames; ++frame)
+  {
+    stdext::hash_set<GameObject *>::iterator it;
+    for(it = set.begin(); it != set.end(); ++it)
+      (*it)->process(dt);
+    for(it = set.begin(); it != set.end(); ++it)
+      (*it)->move(dt);
+    for(it = set.begin(); it != set.end(); ++it)
+      (*it)->computeBoundingBox();
+  }
+  double hashed = getPerformanceTime() - start;
+
+  char text[256];
+  sprintf_s(text, sizeof(text), "%d objects, %d frames:  update() %.3f ms per frame, hash_set passes %.3f ms per frame",
+    count, kFrames, dense / kFrames, hashed / kFrames);
+  gConsole.printLine(text);
+  return true;
+}
+
+/// Scatters enemy-sized boxes and bullet rays at random and times the
+/// interaction tests of one frame, averaged over 60 frames.  First every
+/// enemy pair and every bullet-enemy pair is tested directly, as
+/// handleInteractions used to; then each broadphase finds the enemy pairs
+/// while RayBoxBatch tests the bullets.  Prints the tests made and the time
+/// per frame for each.
+bool StatePlaying::consoleInteractionBenchmark(ParameterList* params,std::string* errorMessage)
+{
+  int enemies = params->Ints[0];
+  int bullets = params->Ints[1];
+  if(enemies < 1 || bullets < 0)
+  {
+    *errorMessage = "Need at least one enemy and a bullet count that isn't negative.";
+    return false;
+  }
+
+  const int kFrames = 60;
+  std::vector<AABB3> boxes(enemies);
+  std::vector<Vector3> origins(bullets), deltas(bullets);
+  for(int i = 0; i < enemies; ++i)
+  {
+    Vector3 center(Random.getFloat(-500.0f, 500.0f), Random.getFloat(0.0f, 100.0f), Random.getFloat(-500.0f, 500.0f));
+    Vector3 halfSize(Random.getFloat(2.0f, 5.0f), Random.getFloat(1.0f, 3.0f), Random.getFloat(2.0f, 5.0f));
+    boxes[i].min = center - halfSize;
+    boxes[i].max = center + halfSize;
+  }
+  for(int i = 0; i < bullets; ++i)
+  {
+    origins[i] = Vector3(Random.getFloat(-500.0f, 500.0f), Random.getFloat(0.0f, 100.0f), Random.getFloat(-500.0f, 500.0f));
+    float heading = Random.getFloat(-kPi, kPi);
+    deltas[i] = Vector3(sin(heading), 0.0f, cos(heading)) * 2000.0f;
+  }
+  double rayTests = (double)enemies * bullets;
+
+  double start = getPerformanceTime();
+  int hits = 0;
+  for(int frame = 0; frame < kFrames; ++frame)
+  {
+    for(int i = 0; i < enemies; ++i)
+      for(int j = i + 1; j < enemies; ++j)
+        if(AABB3::intersect(boxes[i], boxes[j])) ++hits;
+    for(int b = 0; b < bullets; ++b)
+      for(int i = 0; i < enemies; ++i)
+        if(boxes[i].rayIntersect(origins[b], deltas[b]) <= 1.0f) ++hits;
+  }
+  double allPairs = getPerformanceTime() - start;
+
+  char text[256];
+  sprintf_s(text, sizeof(text), "%d enemies, %d bullets:  all pairs %.0f tests, %.3f ms per frame",
+    enemies, bullets, (double)enemies * (enemies - 1) / 2 + rayTests, allPairs / kFrames);
+  gConsole.printLine(text);
+
+  InteractionBroadphase *broadphases[] = {new BruteForceBroadphase(),
+    new SweepAndPruneBroadphase(), new UniformGridBroadphase()};
+  InteractionBroadphase::PairList pairs;
+  RayBoxBatch batch;
+  std::vector<RayBoxBatch::Hit> rayHits;
+  for(int p = 0; p < 3; ++p)
+  {
+    InteractionBroadphase *broadphase = broadphases[p];
+    double pairTests = 0.0;
+    start = getPerformanceTime();
+    for(int frame = 0; frame < kFrames; ++frame)
+    {
+      broadphase->clear();
+      batch.clearBoxes();
+      for(int i = 0; i < enemies; ++i)
+      {
+        broadphase->insert(NULL, boxes[i]);
+        batch.addBox(boxes[i]);
+      }
+      broadphase->build();
+      broadphase->findPairs(pairs);
+      pairTests += broadphase->getPairsTested();
+
+      batch.clearRays();
+      for(int b = 0; b < bullets; ++b)
+        batch.addRay(origins[b], deltas[b]);
+      batch.findNearestHits(rayHits);
+    }
+    double elapsed = getPerformanceTime() - start;
+
+    sprintf_s(text, sizeof(text), "  %s + ray batch:  %.0f tests, %.3f ms per frame",
+      broadphase->getName(), pairTests / kFrames + rayTests, elapsed / kFrames);
+    gConsole.printLine(text);
+    delete broadphase;
+  }
+  return true;
+}
+
 StatePlaying::StatePlaying():
 terrain(NULL),
 water(NULL),
@@ -157,6 +672,18 @@ void StatePlaying::initiate()
   gConsole.addFunction("cameratarget","s",consoleSetCameraTarget);
   gConsole.addFunction("godmode","b",consoleGodMode);
   gConsole.addFunction("allrange","b",consoleAllRange);
+  gConsole.addFunction("broadphase","s",consoleBroadphase);
+  gConsole.addFunction("broadphasestats","",consoleBroadphaseStats);
+  gConsole.addFunction("updatethreads","i",consoleUpdateThreads);
+  gConsole.addFunction("particlethreads","i",consoleParticleThreads);
+  gConsole.addFunction("particlestats","",consoleParticleStats);
+  gConsole.addFunction("raybench","",consoleRayBenchmark);
+  gConsole.addFunction("terrainraybench","",consoleTerrainRayBenchmark);
+  gConsole.addFunction("particlesortbench","i",consoleParticleSortBenchmark);
+  gConsole.addFunction("particlekillbench","i",consoleParticleKillBenchmark);
+  gConsole.addFunction("billboardbench","i",consoleBillboardBenchmark);
+  gConsole.addFunction("updatebench","i",consoleUpdateBenchmark);
+  gConsole.addFunction("interactbench","ii",consoleInteractionBenchmark);
 
 }
 
@@ -73,6 +73,18 @@ public:
   static bool consoleSetCameraTarget(ParameterList* params,std::string* errorMessage);
   static bool consoleAllRange(ParameterList* params,std::string* errorMessage);
   static bool consoleGodMode(ParameterList* params,std::string* errorMessage);
+  static bool consoleBroadphase(ParameterList* params,std::string* errorMessage);
+  static bool consoleBroadphaseStats(ParameterList* params,std::string* errorMessage);
+  static bool consoleUpdateThreads(ParameterList* params,std::string* errorMessage);
+  static bool consoleParticleThreads(ParameterList* params,std::string* errorMessage);
+  static bool consoleParticleStats(ParameterList* params,std::string* errorMessage);
+  static bool consoleRayBenchmark(ParameterList* params,std::string* errorMessage);
+  static bool consoleTerrainRayBenchmark(ParameterList* params,std::string* errorMessage);
+  static bool consoleParticleSortBenchmark(ParameterList* params,std::string* errorMessage);
+  static bool consoleParticleKillBenchmark(ParameterList* params,std::string* errorMessage);
+  static bool consoleBillboardBenchmark(ParameterList* params,std::string* errorMessage);
+  static bool consoleUpdateBenchmark(ParameterList* params,std::string* errorMessage);
+  static bool consoleInteractionBenchmark(ParameterList* params,std::string* errorMessage);
 
   void resetGame();
 
@@ -49,6 +49,7 @@ public:
   
   virtual void process(float dt);
   virtual void move(float dt);
+  virtual bool isThreadSafe() const { return true; }
 
 protected:
 };
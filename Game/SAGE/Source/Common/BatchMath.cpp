@@ -0,0 +1,286 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file BatchMath.cpp
+/// \brief Code for the BatchMath class.
+
+#include "BatchMath.h"
+#include "Vector3.h"
+#include "Matrix4x3.h"
+#include "Quaternion.h"
+#include "AABB3.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define BATCHMATH_SSE
+#include <emmintrin.h>
+#endif
+
+/// \return The vector i strides past v.
+static inline const Vector3 *at(const Vector3 *v, int stride, int i)
+{
+  return (const Vector3 *)((const char *)v + i * stride);
+}
+
+/// \return The vector i strides past v.
+static inline Vector3 *at(Vector3 *v, int stride, int i)
+{
+  return (Vector3 *)((char *)v + i * stride);
+}
+
+#ifdef BATCHMATH_SSE
+/// \brief Loads x, y and z into the first three lanes, without reading past z.
+static inline __m128 load3(const Vector3 *v)
+{
+  __m128 xy = _mm_castpd_ps(_mm_load_sd((const double *)&v->x));
+  return _mm_movelh_ps(xy, _mm_load_ss(&v->z));
+}
+
+/// \brief Stores the first three lanes into x, y and z.
+static inline void store3(Vector3 *v, __m128 a)
+{
+  _mm_store_sd((double *)&v->x, _mm_castps_pd(a));
+  _mm_store_ss(&v->z, _mm_movehl_ps(a, a));
+}
+
+/// \brief Loads a matrix row, with a zero in the last lane.
+static inline __m128 loadRow(float a, float b, float c)
+{
+  return _mm_setr_ps(a, b, c, 0.0f);
+}
+
+/// \brief Multiplies a vector by three rows, adding them in the same order
+/// as operator*(const Vector3 &, const Matrix4x3 &).
+static inline __m128 rotate(__m128 p, __m128 r1, __m128 r2, __m128 r3)
+{
+  __m128 x = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0,0,0,0));
+  __m128 y = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1,1,1,1));
+  __m128 z = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2,2,2,2));
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r1), _mm_mul_ps(y, r2)), _mm_mul_ps(z, r3));
+}
+#endif
+
+/// \param in First point to transform
+/// \param inStride Bytes from one input point to the next
+/// \param out Receives the first transformed point, may equal in
+/// \param outStride Bytes from one output point to the next
+/// \param count Number of points
+/// \param m Matrix to multiply by, as in p * m
+void BatchMath::transformPoints(const Vector3 *in, int inStride,
+  Vector3 *out, int outStride, int count, const Matrix4x3 &m)
+{
+#ifdef BATCHMATH_SSE
+  __m128 r1 = loadRow(m.m11, m.m12, m.m13);
+  __m128 r2 = loadRow(m.m21, m.m22, m.m23);
+  __m128 r3 = loadRow(m.m31, m.m32, m.m33);
+  __m128 t = loadRow(m.tx, m.ty, m.tz);
+  for(int i = 0; i < count; i++)
+    store3(at(out, outStride, i), _mm_add_ps(rotate(load3(at(in, inStride, i)), r1, r2, r3), t));
+#else
+  for(int i = 0; i < count; i++)
+    *at(out, outStride, i) = *at(in, inStride, i) * m;
+#endif
+}
+
+/// Only the 3x3 portion of m is used, so the translation is ignored.  The
+/// results are not normalized.
+/// \param in First direction to transform
+/// \param inStride Bytes from one input direction to the next
+/// \param out Receives the first transformed direction, may equal in
+/// \param outStride Bytes from one output direction to the next
+/// \param count Number of directions
+/// \param m Matrix to multiply by
+void BatchMath::transformNormals(const Vector3 *in, int inStride,
+  Vector3 *out, int outStride, int count, const Matrix4x3 &m)
+{
+#ifdef BATCHMATH_SSE
+  __m128 r1 = loadRow(m.m11, m.m12, m.m13);
+  __m128 r2 = loadRow(m.m21, m.m22, m.m23);
+  __m128 r3 = loadRow(m.m31, m.m32, m.m33);
+  for(int i = 0; i < count; i++)
+    store3(at(out, outStride, i), rotate(load3(at(in, inStride, i)), r1, r2, r3));
+#else
+  for(int i = 0; i < count; i++)
+  {
+    const Vector3 &v = *at(in, inStride, i);
+    Vector3 r(
+      v.x*m.m11 + v.y*m.m21 + v.z*m.m31,
+      v.x*m.m12 + v.y*m.m22 + v.z*m.m32,
+      v.x*m.m13 + v.y*m.m23 + v.z*m.m33);
+    *at(out, outStride, i) = r;
+  }
+#endif
+}
+
+/// The transformed points are not stored, only added to the box.  The box
+/// is not emptied first, so several arrays can be added to one box.
+/// \param in First point to transform
+/// \param inStride Bytes from one point to the next
+/// \param count Number of points
+/// \param m Matrix to multiply by, as in p * m
+/// \param box Box to expand
+void BatchMath::transformAndBound(const Vector3 *in, int inStride, int count,
+  const Matrix4x3 &m, AABB3 &box)
+{
+#ifdef BATCHMATH_SSE
+  __m128 r1 = loadRow(m.m11, m.m12, m.m13);
+  __m128 r2 = loadRow(m.m21, m.m22, m.m23);
+  __m128 r3 = loadRow(m.m31, m.m32, m.m33);
+  __m128 t = loadRow(m.tx, m.ty, m.tz);
+  __m128 lo = load3(&box.min);
+  __m128 hi = load3(&box.max);
+  for(int i = 0; i < count; i++)
+  {
+    __m128 p = _mm_add_ps(rotate(load3(at(in, inStride, i)), r1, r2, r3), t);
+    lo = _mm_min_ps(lo, p);
+    hi = _mm_max_ps(hi, p);
+  }
+  store3(&box.min, lo);
+  store3(&box.max, hi);
+#else
+  for(int i = 0; i < count; i++)
+    box.add(*at(in, inStride, i) * m);
+#endif
+}
+
+/// The box is not emptied first.
+/// \param in First point
+/// \param inStride Bytes from one point to the next
+/// \param count Number of points
+/// \param box Box to expand
+void BatchMath::bound(const Vector3 *in, int inStride, int count, AABB3 &box)
+{
+#ifdef BATCHMATH_SSE
+  __m128 lo = load3(&box.min);
+  __m128 hi = load3(&box.max);
+  for(int i = 0; i < count; i++)
+  {
+    __m128 p = load3(at(in, inStride, i));
+    lo = _mm_min_ps(lo, p);
+    hi = _mm_max_ps(hi, p);
+  }
+  store3(&box.min, lo);
+  store3(&box.max, hi);
+#else
+  for(int i = 0; i < count; i++)
+    box.add(*at(in, inStride, i));
+#endif
+}
+
+/// Computes (1 - t)*a + t*b for each pair.
+/// \param a First vector at t = 0
+/// \param aStride Bytes from one vector of a to the next
+/// \param b First vector at t = 1
+/// \param bStride Bytes from one vector of b to the next
+/// \param out Receives the first interpolated vector, may equal a or b
+/// \param outStride Bytes from one output vector to the next
+/// \param count Number of vectors
+/// \param t Fraction of the way from a to b
+void BatchMath::lerp(const Vector3 *a, int aStride, const Vector3 *b, int bStride,
+  Vector3 *out, int outStride, int count, float t)
+{
+#ifdef BATCHMATH_SSE
+  __m128 s = _mm_set1_ps(1.0f - t);
+  __m128 u = _mm_set1_ps(t);
+  for(int i = 0; i < count; i++)
+  {
+    __m128 va = load3(at(a, aStride, i));
+    __m128 vb = load3(at(b, bStride, i));
+    store3(at(out, outStride, i), _mm_add_ps(_mm_mul_ps(s, va), _mm_mul_ps(u, vb)));
+  }
+#else
+  for(int i = 0; i < count; i++)
+    *at(out, outStride, i) = (1.0f - t) * *at(a, aStride, i) + t * *at(b, bStride, i);
+#endif
+}
+
+/// Gives the same matrices as Matrix4x3::fromQuaternion, with zero
+/// translation.  Four quaternions are converted at once.
+/// \param q First quaternion, which should be normalized
+/// \param out Receives count matrices
+/// \param count Number of quaternions
+void BatchMath::quaternionsToMatrices(const Quaternion *q, Matrix4x3 *out, int count)
+{
+  int i = 0;
+
+#ifdef BATCHMATH_SSE
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+
+  for(; i + 4 <= count; i += 4)
+  {
+    // four quaternions are sixteen floats; transposing gives w, x, y and z
+    __m128 w = _mm_loadu_ps(&q[i].w);
+    __m128 x = _mm_loadu_ps(&q[i+1].w);
+    __m128 y = _mm_loadu_ps(&q[i+2].w);
+    __m128 z = _mm_loadu_ps(&q[i+3].w);
+    _MM_TRANSPOSE4_PS(w, x, y, z);
+
+    __m128 ww = _mm_add_ps(w, w);
+    __m128 xx = _mm_add_ps(x, x);
+    __m128 yy = _mm_add_ps(y, y);
+    __m128 zz = _mm_add_ps(z, z);
+
+    // each register holds one element of all four matrices
+    __m128 m11 = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(yy, y)), _mm_mul_ps(zz, z));
+    __m128 m12 = _mm_add_ps(_mm_mul_ps(xx, y), _mm_mul_ps(ww, z));
+    __m128 m13 = _mm_sub_ps(_mm_mul_ps(xx, z), _mm_mul_ps(ww, x));
+    __m128 m21 = _mm_sub_ps(_mm_mul_ps(xx, y), _mm_mul_ps(ww, z));
+    __m128 m22 = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(xx, x)), _mm_mul_ps(zz, z));
+    __m128 m23 = _mm_add_ps(_mm_mul_ps(yy, z), _mm_mul_ps(ww, x));
+    __m128 m31 = _mm_add_ps(_mm_mul_ps(xx, z), _mm_mul_ps(ww, y));
+    __m128 m32 = _mm_sub_ps(_mm_mul_ps(yy, z), _mm_mul_ps(ww, x));
+    __m128 m33 = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(xx, x)), _mm_mul_ps(yy, y));
+    __m128 t0 = zero, t1 = zero, t2 = zero;
+
+    // a matrix is twelve consecutive floats, so transposing each group of
+    // four elements gives three full stores per matrix
+    _MM_TRANSPOSE4_PS(m11, m12, m13, m21);
+    _MM_TRANSPOSE4_PS(m22, m23, m31, m32);
+    _MM_TRANSPOSE4_PS(m33, t0, t1, t2);
+
+    float *r = &out[i].m11;
+    _mm_storeu_ps(r, m11); _mm_storeu_ps(r + 4, m22); _mm_storeu_ps(r + 8, m33);
+    _mm_storeu_ps(r + 12, m12); _mm_storeu_ps(r + 16, m23); _mm_storeu_ps(r + 20, t0);
+    _mm_storeu_ps(r + 24, m13); _mm_storeu_ps(r + 28, m31); _mm_storeu_ps(r + 32, t1);
+    _mm_storeu_ps(r + 36, m21); _mm_storeu_ps(r + 40, m32); _mm_storeu_ps(r + 44, t2);
+  }
+#endif
+
+  for(; i < count; i++)
+    out[i].fromQuaternion(q[i]);
+}
+
+bool BatchMath::usesSSE()
+{
+#ifdef BATCHMATH_SSE
+  return true;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,78 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file BatchMath.h
+/// \brief Interface for the BatchMath class.
+
+#ifndef __BATCHMATH_H_INCLUDED__
+#define __BATCHMATH_H_INCLUDED__
+
+class Vector3;
+class Matrix4x3;
+class Quaternion;
+class AABB3;
+
+//-----------------------------------------------------------------------------
+/// \brief Runs the common vector and matrix operations on many values at once.
+///
+/// Vectors are read and written through byte strides, so the kernels work
+/// straight on the positions or normals of a vertex array, such as
+/// RenderVertex::p with a stride of sizeof(RenderVertex).  A stride of
+/// sizeof(Vector3) means a packed array.  Input and output may be the same
+/// array, but must not otherwise overlap.
+///
+/// Each kernel does the same arithmetic, in the same order, as the scalar
+/// operators in Vector3, Matrix4x3 and AABB3, so results agree with them to
+/// within rounding of the floating point unit.  Builds with SSE2 do one
+/// vector per instruction instead of one component; other builds use the
+/// scalar code.
+class BatchMath
+{
+public:
+  static void transformPoints(const Vector3 *in, int inStride,
+    Vector3 *out, int outStride, int count, const Matrix4x3 &m); ///< Multiplies points by a matrix.
+
+  static void transformNormals(const Vector3 *in, int inStride,
+    Vector3 *out, int outStride, int count, const Matrix4x3 &m); ///< Multiplies directions by the 3x3 portion of a matrix.
+
+  static void transformAndBound(const Vector3 *in, int inStride, int count,
+    const Matrix4x3 &m, AABB3 &box); ///< Adds points multiplied by a matrix to a box.
+
+  static void bound(const Vector3 *in, int inStride, int count, AABB3 &box); ///< Adds points to a box.
+
+  static void lerp(const Vector3 *a, int aStride, const Vector3 *b, int bStride,
+    Vector3 *out, int outStride, int count, float t); ///< Interpolates between two arrays of vectors.
+
+  static void quaternionsToMatrices(const Quaternion *q, Matrix4x3 *out, int count); ///< Converts rotations to matrices.
+
+  static bool usesSSE(); ///< Returns true iff this build runs the SSE2 kernels.
+};
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,211 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file BatchMathBenchmark.cpp
+/// \brief Code for the BatchMathBenchmark class.
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include "BatchMathBenchmark.h"
+#include "BatchMath.h"
+#include "Vector3.h"
+#include "Matrix4x3.h"
+#include "Quaternion.h"
+#include "EulerAngles.h"
+#include "AABB3.h"
+#include "Random.h"
+#include "CommonStuff.h"
+
+using namespace std;
+
+namespace
+{
+  /// Laid out like RenderVertex, so the kernels run with the same stride
+  /// as they do on models.
+  struct BenchVertex
+  {
+    Vector3 p; ///< Position
+    Vector3 n; ///< Normal
+    float u, v; ///< Texture mapping coordinates
+  };
+
+  /// Roughly how many elements each kernel processes per timing.
+  const int kElementsPerTiming = 4000000;
+
+  /// \brief Times a function.
+  /// \param f Function to run
+  /// \param repeats Number of times to run it
+  /// \param count Number of elements it processes per run
+  /// \return Nanoseconds per element.
+  template<class Function>
+  double timePerElement(Function f, int repeats, int count)
+  {
+    double start = getPerformanceTime();
+    for(int r = 0; r < repeats; r++)
+      f();
+    double ns = (getPerformanceTime() - start) * 1000000.0;
+    return ns / ((double)repeats * count);
+  }
+
+  /// \return The largest difference of any component.
+  float maxDifference(const Vector3 &a, const Vector3 &b)
+  {
+    float d = fabs(a.x - b.x);
+    if(fabs(a.y - b.y) > d) d = fabs(a.y - b.y);
+    if(fabs(a.z - b.z) > d) d = fabs(a.z - b.z);
+    return d;
+  }
+
+  /// \brief Adds one line to the report.
+  void addLine(vector<string> &report, const char *name, double scalarNs, double batchNs, float difference)
+  {
+    char line[160];
+    sprintf_s(line, "%-22s scalar %6.2f ns  batch %6.2f ns  x%5.2f  max diff %g",
+      name, scalarNs, batchNs, batchNs > 0.0 ? scalarNs / batchNs : 0.0, difference);
+    report.push_back(line);
+  }
+}
+
+/// \param count Number of elements given to each kernel
+/// \param report Receives one line per kernel, after a header line
+void BatchMathBenchmark::run(int count, vector<string> &report)
+{
+  if(count < 1)
+    count = 1;
+  int repeats = kElementsPerTiming / count;
+  if(repeats < 1)
+    repeats = 1;
+
+  char header[128];
+  sprintf_s(header, "%d elements, %d repeats, %s", count, repeats,
+    BatchMath::usesSSE() ? "SSE2" : "scalar");
+  report.push_back(header);
+
+  // random data, the same every run
+  CRandom random;
+  random.seed(1234);
+  vector<BenchVertex> a(count), b(count);
+  for(int i = 0; i < count; i++)
+  {
+    a[i].p = Vector3(random.getFloat(-100.0f, 100.0f), random.getFloat(-100.0f, 100.0f), random.getFloat(-100.0f, 100.0f));
+    a[i].n = Vector3(random.getFloat(-1.0f, 1.0f), random.getFloat(-1.0f, 1.0f), random.getFloat(-1.0f, 1.0f));
+    b[i].p = Vector3(random.getFloat(-100.0f, 100.0f), random.getFloat(-100.0f, 100.0f), random.getFloat(-100.0f, 100.0f));
+  }
+  Matrix4x3 m;
+  m.setupLocalToParent(Vector3(10.0f, -20.0f, 30.0f), EulerAngles(0.3f, -0.7f, 1.1f));
+
+  vector<Vector3> scalarOut(count), batchOut(count);
+  float difference;
+  double scalarNs, batchNs;
+
+  // transformPoints
+
+  scalarNs = timePerElement([&]() {
+    for(int i = 0; i < count; i++)
+      scalarOut[i] = a[i].p * m;
+  }, repeats, count);
+  batchNs = timePerElement([&]() {
+    BatchMath::transformPoints(&a[0].p, sizeof(BenchVertex), &batchOut[0], sizeof(Vector3), count, m);
+  }, repeats, count);
+  difference = 0.0f;
+  for(int i = 0; i < count; i++)
+    difference = std::max(difference, maxDifference(scalarOut[i], batchOut[i]));
+  addLine(report, "transformPoints", scalarNs, batchNs, difference);
+
+  // transformNormals
+
+  Matrix4x3 rotation = m;
+  rotation.zeroTranslation();
+  scalarNs = timePerElement([&]() {
+    for(int i = 0; i < count; i++)
+      scalarOut[i] = a[i].n * rotation;
+  }, repeats, count);
+  batchNs = timePerElement([&]() {
+    BatchMath::transformNormals(&a[0].n, sizeof(BenchVertex), &batchOut[0], sizeof(Vector3), count, m);
+  }, repeats, count);
+  difference = 0.0f;
+  for(int i = 0; i < count; i++)
+    difference = std::max(difference, maxDifference(scalarOut[i], batchOut[i]));
+  addLine(report, "transformNormals", scalarNs, batchNs, difference);
+
+  // transformAndBound
+
+  AABB3 scalarBox, batchBox;
+  scalarNs = timePerElement([&]() {
+    scalarBox.empty();
+    for(int i = 0; i < count; i++)
+      scalarBox.add(a[i].p * m);
+  }, repeats, count);
+  batchNs = timePerElement([&]() {
+    batchBox.empty();
+    BatchMath::transformAndBound(&a[0].p, sizeof(BenchVertex), count, m, batchBox);
+  }, repeats, count);
+  difference = std::max(maxDifference(scalarBox.min, batchBox.min), maxDifference(scalarBox.max, batchBox.max));
+  addLine(report, "transformAndBound", scalarNs, batchNs, difference);
+
+  // lerp
+
+  const float t = 0.37f;
+  scalarNs = timePerElement([&]() {
+    for(int i = 0; i < count; i++)
+      scalarOut[i] = (1.0f - t) * a[i].p + t * b[i].p;
+  }, repeats, count);
+  batchNs = timePerElement([&]() {
+    BatchMath::lerp(&a[0].p, sizeof(BenchVertex), &b[0].p, sizeof(BenchVertex),
+      &batchOut[0], sizeof(Vector3), count, t);
+  }, repeats, count);
+  difference = 0.0f;
+  for(int i = 0; i < count; i++)
+    difference = std::max(difference, maxDifference(scalarOut[i], batchOut[i]));
+  addLine(report, "lerp", scalarNs, batchNs, difference);
+
+  // quaternionsToMatrices
+
+  vector<Quaternion> q(count);
+  for(int i = 0; i < count; i++)
+    q[i].setToRotateObjectToInertial(EulerAngles(random.getFloat(-3.0f, 3.0f),
+      random.getFloat(-1.5f, 1.5f), random.getFloat(-3.0f, 3.0f)));
+  vector<Matrix4x3> scalarMatrices(count), batchMatrices(count);
+  scalarNs = timePerElement([&]() {
+    for(int i = 0; i < count; i++)
+      scalarMatrices[i].fromQuaternion(q[i]);
+  }, repeats, count);
+  batchNs = timePerElement([&]() {
+    BatchMath::quaternionsToMatrices(&q[0], &batchMatrices[0], count);
+  }, repeats, count);
+  difference = 0.0f;
+  for(int i = 0; i < count; i++)
+  {
+    const float *s = &scalarMatrices[i].m11, *r = &batchMatrices[i].m11;
+    for(int j = 0; j < 12; j++)
+      difference = std::max(difference, (float)fabs(s[j] - r[j]));
+  }
+  addLine(report, "quaternionsToMatrices", scalarNs, batchNs, difference);
+}
@@ -0,0 +1,53 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file BatchMathBenchmark.h
+/// \brief Interface for the BatchMathBenchmark class.
+
+#ifndef __BATCHMATHBENCHMARK_H_INCLUDED__
+#define __BATCHMATHBENCHMARK_H_INCLUDED__
+
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+/// \brief Times each BatchMath kernel against the scalar operators.
+///
+/// Every kernel is run on the same random data as a plain loop over the
+/// scalar operator it replaces.  The report gives nanoseconds per element
+/// for both, the speedup, and the largest difference between their results.
+/// The "mathbench" console command prints the report.
+class BatchMathBenchmark
+{
+public:
+  static void run(int count, std::vector<std::string> &report); ///< Times every kernel on count elements.
+};
+//-----------------------------------------------------------------------------
+
+#endif
@@ -212,3 +212,17 @@ int distSquared(int x1, int y1, int x2, int y2)
   int dx = x1-x2, dy = y1-y2;
   return dx*dx + dy*dy;
 }
+
+double getPerformanceTime()
+{
+  static double msPerTick = 0.0;
+  LARGE_INTEGER clock;
+  if(msPerTick == 0.0)
+  {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    msPerTick = 1000.0 / (double)frequency.QuadPart;
+  }
+  QueryPerformanceCounter(&clock);
+  return (double)clock.QuadPart * msPerTick;
+}
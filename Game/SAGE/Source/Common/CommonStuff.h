@@ -71,6 +71,11 @@ unsigned int atocolor(const char* strcolor);
 /// \return The distance squared of points (x1,y1) and (x2,y2)
 int distSquared(int x1, int y1, int x2, int y2);
 
+/// \brief Reads the high-resolution performance counter, for timing code.
+/// \return Time in milliseconds from an arbitrary starting point.  Only the
+///     difference between two readings is meaningful.
+double getPerformanceTime();
+
 // Standard min and max functions (note: not needed thanks to std::min(), std::max())
 template <class Type>
 inline const Type &(min)(const Type &a, const Type &b) {
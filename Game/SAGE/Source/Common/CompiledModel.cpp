@@ -0,0 +1,319 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file CompiledModel.cpp
+/// \brief Code for the CompiledModel class.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <windows.h>
+
+#include "CompiledModel.h"
+#include "Model.h"
+#include "TriMesh.h"
+#include "common/renderer.h"
+
+namespace
+{
+  const char kMagic[4] = { 'S', '3', 'D', 'C' }; ///< First four bytes of every compiled model.
+  const unsigned int kVersion = 1; ///< Changes whenever the layout of the file changes.
+  const unsigned int kAlignment = 16; ///< Alignment of the arrays in the file.
+
+  /// Start of a compiled model.  The part headers follow it, and then the
+  /// arrays of every part, each aligned to kAlignment bytes.
+  struct Header
+  {
+    char magic[4]; ///< Always kMagic.
+    unsigned int version; ///< Always kVersion.
+    unsigned int vertexSize; ///< sizeof(RenderVertex).
+    unsigned int triSize; ///< sizeof(RenderTri), which depends on INDEX_BUFFER_32.
+    unsigned int partSize; ///< sizeof(PartHeader).
+    int partCount; ///< Number of parts.
+    int totalVertices; ///< Number of vertices in all parts.
+    int totalTris; ///< Number of triangles in all parts.
+    DWORD sourceSizeLow; ///< Size of the S3D file, low 32 bits.
+    DWORD sourceSizeHigh; ///< Size of the S3D file, high 32 bits.
+    FILETIME sourceTime; ///< Last write time of the S3D file.
+  };
+
+  /// Describes one part of a compiled model.
+  struct PartHeader
+  {
+    char textureName[kMaxTextureNameChars]; ///< Name of the part's texture.
+    float boxMin[3]; ///< Minimum corner of the part's bounding box.
+    float boxMax[3]; ///< Maximum corner of the part's bounding box.
+    int vertexCount; ///< Number of RenderVertex structures.
+    int triCount; ///< Number of RenderTri structures.
+    int hullCount; ///< Number of convex hull vertices, or 0 if the hull isn't stored.
+    unsigned int vertexOffset; ///< Offset of the vertices from the start of the file.
+    unsigned int triOffset; ///< Offset of the triangles from the start of the file.
+    unsigned int hullOffset; ///< Offset of the hull vertices from the start of the file.
+  };
+
+  /// \return The offset rounded up to a multiple of kAlignment.
+  unsigned int align(unsigned int offset)
+  {
+    return (offset + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  /// \return True if count elements at offset lie within the file.
+  bool inFile(unsigned int offset, int count, size_t elementSize, size_t fileSize)
+  {
+    if(count < 0) return false;
+    if(count == 0) return true;
+    return offset <= fileSize && (size_t)count <= (fileSize - offset) / elementSize;
+  }
+
+  /// \brief Writes an array at an offset, padding with zeros up to it.
+  /// \return True if the write succeeded.
+  bool writeAt(FILE *f, unsigned int offset, const void *data, size_t bytes)
+  {
+    static const char zeros[kAlignment] = { 0 };
+    long position = ftell(f);
+    if(position < 0 || (unsigned int)position > offset)
+      return false;
+    size_t padding = offset - (unsigned int)position;
+    if(padding > kAlignment || fwrite(zeros, 1, padding, f) != padding)
+      return false;
+    return bytes == 0 || fwrite(data, 1, bytes, f) == bytes;
+  }
+}
+
+/// The compiled model sits next to the S3D file, with the extension .s3c.
+/// \param s3dFilename Specifies the name of the S3D file.
+/// \param compiledFilename Buffer for the name of the compiled model.
+/// \param size Size of the buffer.
+void CompiledModel::getFileName(const char *s3dFilename, char *compiledFilename, size_t size)
+{
+  strcpy_s(compiledFilename, size, s3dFilename);
+  char *extension = strrchr(compiledFilename, '.');
+  if(extension != NULL && strpbrk(extension, "/\\") == NULL)
+    *extension = '\0';
+  strcat_s(compiledFilename, size, ".s3c");
+}
+
+/// \param compiledFilename Specifies the name of the compiled model.
+/// \param s3dFilename Specifies the name of the S3D file it was compiled from.
+/// \param model Specifies the model to load into.  It is left alone on failure.
+/// \return True if the compiled model exists, is current, and was loaded.
+bool CompiledModel::load(const char *compiledFilename, const char *s3dFilename, Model &model)
+{
+  HANDLE file = CreateFileA(compiledFilename, GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+
+  // map the whole file; the arrays are copied straight out of the view
+
+  LARGE_INTEGER fileSize;
+  HANDLE mapping = NULL;
+  const unsigned char *data = NULL;
+  if(GetFileSizeEx(file, &fileSize) && fileSize.HighPart == 0 && fileSize.LowPart >= sizeof(Header))
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(mapping != NULL)
+    data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+  bool loaded = data != NULL && read(data, fileSize.LowPart, s3dFilename, model);
+
+  if(data != NULL)
+    UnmapViewOfFile(data);
+  if(mapping != NULL)
+    CloseHandle(mapping);
+  CloseHandle(file);
+  return loaded;
+}
+
+/// Every count and offset is checked against the file before the model
+/// is changed, so a damaged file is rejected rather than half loaded.
+/// \param data Specifies the mapped file.
+/// \param size Specifies the size of the file in bytes.
+/// \param s3dFilename Specifies the name of the S3D file it was compiled from.
+/// \param model Specifies the model to load into.
+/// \return True if the model was loaded.
+bool CompiledModel::read(const unsigned char *data, size_t size, const char *s3dFilename, Model &model)
+{
+  const Header &header = *(const Header*)data;
+  if(memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+    header.vertexSize != sizeof(RenderVertex) || header.triSize != sizeof(RenderTri) ||
+    header.partSize != sizeof(PartHeader) || header.partCount < 1)
+    return false;
+
+  // out of date if the S3D file has changed since it was compiled
+
+  WIN32_FILE_ATTRIBUTE_DATA source;
+  if(GetFileAttributesExA(s3dFilename, GetFileExInfoStandard, &source) &&
+    (source.nFileSizeLow != header.sourceSizeLow || source.nFileSizeHigh != header.sourceSizeHigh ||
+    CompareFileTime(&source.ftLastWriteTime, &header.sourceTime) != 0))
+    return false;
+
+  if(!inFile(sizeof(Header), header.partCount, sizeof(PartHeader), size))
+    return false;
+  const PartHeader *parts = (const PartHeader*)(data + sizeof(Header));
+
+  // the totals size the model's buffers, so they must match the parts
+
+  long long totalVertices = 0, totalTris = 0;
+  for(int i = 0; i < header.partCount; i++)
+  {
+    const PartHeader &part = parts[i];
+    if(!inFile(part.vertexOffset, part.vertexCount, sizeof(RenderVertex), size) ||
+      !inFile(part.triOffset, part.triCount, sizeof(RenderTri), size) ||
+      !inFile(part.hullOffset, part.hullCount, sizeof(Vector3), size) ||
+      part.vertexCount > 65536 ||
+      memchr(part.textureName, '\0', sizeof(part.textureName)) == NULL)
+      return false;
+
+    // every index must name one of the part's own vertices
+    const RenderTri *tris = (const RenderTri*)(data + part.triOffset);
+    for(int t = 0; t < part.triCount; t++)
+      for(int k = 0; k < 3; k++)
+        if((unsigned int)tris[t].index[k] >= (unsigned int)part.vertexCount)
+          return false;
+
+    totalVertices += part.vertexCount;
+    totalTris += part.triCount;
+  }
+  if(totalVertices != header.totalVertices || totalTris != header.totalTris)
+    return false;
+
+  // copy the parts out
+
+  model.allocateMemory(header.partCount);
+  for(int i = 0; i < header.partCount; i++)
+  {
+    const PartHeader &part = parts[i];
+    TriMesh &mesh = model.m_partMeshList[i];
+
+    mesh.allocateMemory(part.vertexCount, part.triCount);
+    memcpy(mesh.vertexList, data + part.vertexOffset, part.vertexCount * sizeof(RenderVertex));
+    memcpy(mesh.triList, data + part.triOffset, part.triCount * sizeof(RenderTri));
+
+    mesh.boundingBox.min = Vector3(part.boxMin[0], part.boxMin[1], part.boxMin[2]);
+    mesh.boundingBox.max = Vector3(part.boxMax[0], part.boxMax[1], part.boxMax[2]);
+    if(part.hullCount > 0)
+    {
+      mesh.hullCount = part.hullCount;
+      mesh.hullList = new Vector3[part.hullCount];
+      memcpy(mesh.hullList, data + part.hullOffset, part.hullCount * sizeof(Vector3));
+    }
+
+    model.setPartTextureName(i, part.textureName);
+  }
+  model.m_totalVertices = (int)totalVertices;
+  model.m_totalTris = (int)totalTris;
+
+  return true;
+}
+
+/// The file is written under a temporary name and then renamed, so that a
+/// reader never maps half a file.
+/// \param compiledFilename Specifies the name of the compiled model.
+/// \param s3dFilename Specifies the name of the S3D file the model was imported from.
+/// \param model Specifies the model to compile.
+/// \return True if the compiled model was written.
+bool CompiledModel::save(const char *compiledFilename, const char *s3dFilename, const Model &model)
+{
+  if(model.m_partCount < 1)
+    return false;
+
+  WIN32_FILE_ATTRIBUTE_DATA source;
+  if(!GetFileAttributesExA(s3dFilename, GetFileExInfoStandard, &source))
+    return false;
+
+  // lay out the file
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.vertexSize = sizeof(RenderVertex);
+  header.triSize = sizeof(RenderTri);
+  header.partSize = sizeof(PartHeader);
+  header.partCount = model.m_partCount;
+  header.totalVertices = model.m_totalVertices;
+  header.totalTris = model.m_totalTris;
+  header.sourceSizeLow = source.nFileSizeLow;
+  header.sourceSizeHigh = source.nFileSizeHigh;
+  header.sourceTime = source.ftLastWriteTime;
+
+  std::vector<PartHeader> parts(model.m_partCount);
+  unsigned int offset = align(sizeof(Header) + model.m_partCount * sizeof(PartHeader));
+  for(int i = 0; i < model.m_partCount; i++)
+  {
+    const TriMesh &mesh = model.m_partMeshList[i];
+    PartHeader &part = parts[i];
+    memset(&part, 0, sizeof(part));
+
+    strcpy_s(part.textureName, sizeof(part.textureName), model.m_partTextureList[i].name);
+    const AABB3 &box = mesh.getBoundingBox();
+    part.boxMin[0] = box.min.x; part.boxMin[1] = box.min.y; part.boxMin[2] = box.min.z;
+    part.boxMax[0] = box.max.x; part.boxMax[1] = box.max.y; part.boxMax[2] = box.max.z;
+
+    part.vertexCount = mesh.vertexCount;
+    part.triCount = mesh.triCount;
+    part.hullCount = mesh.hullCount;
+
+    part.vertexOffset = offset;
+    offset = align(offset + part.vertexCount * sizeof(RenderVertex));
+    part.triOffset = offset;
+    offset = align(offset + part.triCount * sizeof(RenderTri));
+    part.hullOffset = offset;
+    offset = align(offset + part.hullCount * sizeof(Vector3));
+  }
+
+  // write it
+
+  char tempFilename[MAX_PATH];
+  sprintf_s(tempFilename, "%s.tmp", compiledFilename);
+
+  FILE *f = NULL;
+  if(fopen_s(&f, tempFilename, "wb") != 0 || f == NULL)
+    return false;
+
+  bool written = fwrite(&header, sizeof(header), 1, f) == 1 &&
+    fwrite(&parts[0], sizeof(PartHeader), parts.size(), f) == parts.size();
+  for(int i = 0; written && i < model.m_partCount; i++)
+  {
+    const TriMesh &mesh = model.m_partMeshList[i];
+    const PartHeader &part = parts[i];
+    written = writeAt(f, part.vertexOffset, mesh.vertexList, part.vertexCount * sizeof(RenderVertex)) &&
+      writeAt(f, part.triOffset, mesh.triList, part.triCount * sizeof(RenderTri)) &&
+      writeAt(f, part.hullOffset, mesh.hullList, part.hullCount * sizeof(Vector3));
+  }
+  if(fclose(f) != 0)
+    written = false;
+
+  if(!written || !MoveFileExA(tempFilename, compiledFilename, MOVEFILE_REPLACE_EXISTING))
+  {
+    remove(tempFilename);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,66 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file CompiledModel.h
+/// \brief Interface for the CompiledModel class.
+
+#ifndef __COMPILEDMODEL_H_INCLUDED__
+#define __COMPILEDMODEL_H_INCLUDED__
+
+#include <stddef.h>
+
+class Model;
+
+//-----------------------------------------------------------------------------
+/// \brief Reads and writes compiled models.
+///
+/// A compiled model (.s3c) holds a Model's parts exactly as they are after
+/// importing and optimizing an S3D file: the RenderVertex and RenderTri arrays,
+/// the texture name, bounding box and convex hull of each part.  Loading one
+/// maps the file into memory and copies the arrays out, with no parsing and
+/// none of the EditTriMesh work.
+///
+/// The header holds a version number and the sizes of the stored structures,
+/// so a file written by a different build is ignored rather than misread.  It
+/// also records the size and time of the S3D file it was compiled from; when
+/// the S3D changes, the compiled model is out of date and is rebuilt.  A
+/// compiled model without its S3D file is always loaded.
+class CompiledModel
+{
+public:
+  static void getFileName(const char *s3dFilename, char *compiledFilename, size_t size); ///< Gets the name of the compiled model for an S3D file.
+  static bool load(const char *compiledFilename, const char *s3dFilename, Model &model); ///< Loads the parts of a model from a compiled model.
+  static bool save(const char *compiledFilename, const char *s3dFilename, const Model &model); ///< Writes the parts of a model to a compiled model.
+
+private:
+  static bool read(const unsigned char *data, size_t size, const char *s3dFilename, Model &model); ///< Copies the parts of a mapped compiled model into a model.
+};
+//-----------------------------------------------------------------------------
+
+#endif
@@ -23,6 +23,7 @@
 #include "CommonStuff.h"
 #include "Matrix4x3.h"
 #include "AABB3.h"
+#include "BatchMath.h"
 #include "directorymanager/DirectoryManager.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1545,8 +1546,8 @@ void	EditTriMesh::detachAllFaces() {
 
 /// \param m Matrix by which to transform all the vertices in the mesh
 void	EditTriMesh::transformVertices(const Matrix4x3 &m) {
-	for (int i = 0 ; i < vertexCount() ; ++i) {
-		vertex(i).p *= m;
+	if (vertexCount() > 0) {
+		BatchMath::transformPoints(&vertex(0).p, sizeof(Vertex), &vertex(0).p, sizeof(Vertex), vertexCount(), m);
 	}
 }
 
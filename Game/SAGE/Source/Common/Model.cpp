@@ -22,6 +22,8 @@
 #include "common/renderer.h"
 #include "TriMesh.h"
 #include "EditTriMesh.h"
+#include "CompiledModel.h"
+#include "directorymanager/DirectoryManager.h"
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -311,6 +313,17 @@ void	Model::fromEditMesh(EditTriMesh &mesh) {
 	}
 	assert(destPartIndex == getPartCount());
 
+  createBuffers();
+
+	// Free uindividual part meshes
+
+	delete [] partMeshes;
+}
+
+/// Fills the buffers from the part meshes, which must already be set up.
+void	Model::createBuffers() {
+  int i;
+
   if(m_bufferUsage == StaticBuffers)
   {
     assert(m_vertexBuffer == NULL);
@@ -375,11 +388,6 @@ void	Model::fromEditMesh(EditTriMesh &mesh) {
 
     m_indexBuffer = new IndexBuffer(m_totalTris);
   }
-
-
-	// Free uindividual part meshes
-
-	delete [] partMeshes;
 }
 
 /// \param mesh Specifies the mesh to be replaced by this model.
@@ -396,6 +404,19 @@ void	Model::importS3d(const char *s3dFilename, bool defaultDirectory) {
 
 	char	text[256];
 
+	// Use the compiled model if it is current; it needs no parsing or
+	// optimizing
+
+	if (defaultDirectory)
+		gDirectoryManager.setDirectory(eDirectoryModels);
+	char	compiledFilename[256];
+	CompiledModel::getFileName(s3dFilename, compiledFilename, sizeof(compiledFilename));
+	if (CompiledModel::load(compiledFilename, s3dFilename, *this)) {
+		createBuffers();
+		m_isValid = true;
+		return;
+	}
+
 	// Load up the S3D into an EditTriMesh
 
 	EditTriMesh editMesh;
@@ -411,17 +432,23 @@ void	Model::importS3d(const char *s3dFilename, bool defaultDirectory) {
 
 	fromEditMesh(editMesh);
 
+	// Compile it, so the next import can skip all of the above
+
+	CompiledModel::save(compiledFilename, s3dFilename, *this);
+
   m_isValid = true;
 }
 
 /// \param m Specifies the transformation matrix applied to the model.
+/// \param exact Specifies whether to compute the smallest box, or a quicker
+/// box made from the parts' local bounding boxes.
 /// \return The bounding box of the model in transformed space.
-AABB3 Model::getBoundingBox(const Matrix4x3 &m) const
+AABB3 Model::getBoundingBox(const Matrix4x3 &m, bool exact) const
 {
   AABB3 bb;
   bb.empty();
   for(int i = 0; i < m_partCount; ++i)
-    bb.add(m_partMeshList[i].getBoundingBox(m));
+    bb.add(m_partMeshList[i].getBoundingBox(m, exact));
   return bb;
 }
 
@@ -434,8 +461,10 @@ const AABB3 &Model::getPartBoundingBox(int part) const
 
 /// \param part Specifies the number of the part.
 /// \param m Specifies the transformation matrix applied to the part.
+/// \param exact Specifies whether to compute the smallest box, or a quicker
+/// box made from the part's local bounding box.
 /// \return The bounding box of the part in transformed space.
-AABB3 Model::getPartBoundingBox(int part, const Matrix4x3 &m) const
+AABB3 Model::getPartBoundingBox(int part, const Matrix4x3 &m, bool exact) const
 {
-  return m_partMeshList[part].getBoundingBox(m);
+  return m_partMeshList[part].getBoundingBox(m, exact);
 }
\ No newline at end of file
@@ -44,6 +44,7 @@ class AABB3;
 class Model
 {
   friend class AnimatedModel;
+  friend class CompiledModel;
   typedef std::vector<int> PartOffsetArray;
 
 public:
@@ -97,18 +98,21 @@ public:
 	void	fromEditMesh(EditTriMesh &mesh);  ///< Converts an EditTriMesh to a Model.
 	void	toEditMesh(EditTriMesh &mesh) const;  ///< Converts the model to an EditTriMesh.
 
-	// Shorthand for importing an S3D.  (Uses EditTriMesh)
+	// Shorthand for importing an S3D.  (Uses EditTriMesh, or the compiled
+	// model if there is a current one.)
 
 	void	importS3d(const char *s3dFilename, bool defaultDirectory = true);  ///< Imports a model from an S3D file (.S3D).
 
-  AABB3 getBoundingBox(const Matrix4x3 &m) const;  ///< Queries a model for its bounding box.
+  AABB3 getBoundingBox(const Matrix4x3 &m, bool exact = true) const;  ///< Queries a model for its bounding box.
   const AABB3 &getPartBoundingBox(int part) const;  ///< Queries a model for the bounding box of one of its parts.
-  AABB3 getPartBoundingBox(int part, const Matrix4x3 &m) const;  ///< Queries a model for the bounding box of one of its parts.
+  AABB3 getPartBoundingBox(int part, const Matrix4x3 &m, bool exact = true) const;  ///< Queries a model for the bounding box of one of its parts.
 
   bool isValid() { return m_isValid; } ///< Returns true if the model is valid, false otherwise.
 
 protected:
 
+  void createBuffers();  ///< Creates the vertex and index buffers that the buffer usage calls for.
+
 	// Parts and textures
 
   int m_partCount;                     ///< Specifies the number of parts
@@ -4,24 +4,65 @@
 //Copyright Ian Parberry, 1998
 //Last updated July 3, 1998
 
-#include <windows.h>
-
 #include "common/random.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define RANDOM_SSE
+#include <emmintrin.h>
+#endif
+
 CRandom Random; //random number generator
 
+/// Scale that maps the top 24 bits of an output onto [0,1)
+static const float kOutputToFloat = 1.0f / 16777216.0f;
+
+/// \param x Specifies the value to rotate.
+/// \param k Specifies how many bits to rotate left by.
+/// \return The rotated value.
+static inline unsigned int rotl(unsigned int x, int k){
+  return (x << k) | (x >> (32 - k));
+}
+
 CRandom::CRandom(){ //constructor
   seed(); //seed random number generator
 }
 
+/// The sixteen words of state are filled from the seed with splitmix32, so
+/// nearby seeds still give unrelated sequences.
 /// \param seed Specifies the seed value
 void CRandom::seed(unsigned int seed){ //seed random number generator
-  srand(seed); m_nCount=0;
+  for(int word = 0; word < 4; ++word)
+    for(int lane = 0; lane < 4; ++lane){
+      unsigned int z = (seed += 0x9E3779B9);
+      z = (z ^ (z >> 16)) * 0x85EBCA6B;
+      z = (z ^ (z >> 13)) * 0xC2B2AE35;
+      m_state[word][lane] = z ^ (z >> 16);
+    }
+  m_nBuffered = 0;
+  m_nCount = 0;
+}
+
+/// \param out Receives one output from each generator.
+void CRandom::step(unsigned int out[4]){
+  for(int lane = 0; lane < 4; ++lane){
+    unsigned int *s0 = &m_state[0][lane], *s1 = &m_state[1][lane];
+    unsigned int *s2 = &m_state[2][lane], *s3 = &m_state[3][lane];
+    out[lane] = rotl(*s1 * 5, 7) * 9;
+    unsigned int t = *s1 << 9;
+    *s2 ^= *s0; *s3 ^= *s1; *s1 ^= *s2; *s0 ^= *s3;
+    *s2 ^= t;
+    *s3 = rotl(*s3, 11);
+  }
 }
 
 /// \return A random 32-bit signed integer.
 int CRandom::getInt(){
-  unsigned int sample = (rand() << 17) | (rand() << 2) | (rand() & 3); // random 32-bit unsigned value
+  if(m_nBuffered == 0){
+    step(m_buffer);
+    m_nBuffered = 4;
+  }
+  ++m_nCount;
+  unsigned int sample = m_buffer[4 - m_nBuffered--]; // random 32-bit unsigned value
   return (int &)sample; // Reinterpret it as a signed integer
 }
 
@@ -36,12 +77,10 @@ int CRandom::getInt(int minVal, int maxVal){
   return sample%(maxVal - minVal + 1) + minVal;
 }
 
-/// \return A random float in the interval [0.0,1.0]
+/// \return A random float in the interval [0.0,1.0)
 float CRandom::getFloat(){  
-  // ASSUME:  float and int are same size (32-bit)
-  static const double factor = 1.0 / 2147483647.0; // Maps from [0,2^31-1] to [0,1]
-  int sample = getInt() & 0x7FFFFFFF; // Strip sign bit; random nonnegative 31-bit value
-  return (float)((double)sample * factor);
+  unsigned int sample = (unsigned int)getInt() >> 8; // 24 bits, exactly representable
+  return (float)sample * kOutputToFloat;
 }
 
 /// \param minVal Specifies the minimum value.
@@ -59,5 +98,52 @@ float CRandom::getFloat(float minVal, float maxVal)
 /// \return true or false, with roughly equal probability.
 bool CRandom::getBool()
 {
-  return ((rand() & 1) == 0);
+  return getInt() < 0;
+}
+
+/// Draws the same values, in the same order, as calling getFloat() count
+/// times, but whole steps of the four generators are converted at once.
+/// \param out Receives the random floats.
+/// \param count Specifies how many floats to write.
+void CRandom::fillUniform(float *out, int count)
+{
+  int i = 0;
+
+  // hand out what is left of the last step first
+  for(; i < count && m_nBuffered > 0; ++i)
+    out[i] = getFloat();
+
+#ifdef RANDOM_SSE
+  __m128i s0 = _mm_loadu_si128((__m128i*)m_state[0]);
+  __m128i s1 = _mm_loadu_si128((__m128i*)m_state[1]);
+  __m128i s2 = _mm_loadu_si128((__m128i*)m_state[2]);
+  __m128i s3 = _mm_loadu_si128((__m128i*)m_state[3]);
+  const __m128 scale = _mm_set1_ps(kOutputToFloat);
+  int first = i;
+
+  for(; i + 4 <= count; i += 4){
+    // SSE2 has no 32-bit multiply, so *5 and *9 become shifts and adds
+    __m128i x = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+    x = _mm_or_si128(_mm_slli_epi32(x, 7), _mm_srli_epi32(x, 25));
+    x = _mm_add_epi32(_mm_slli_epi32(x, 3), x);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), scale));
+
+    __m128i t = _mm_slli_epi32(s1, 9);
+    s2 = _mm_xor_si128(s2, s0);
+    s3 = _mm_xor_si128(s3, s1);
+    s1 = _mm_xor_si128(s1, s2);
+    s0 = _mm_xor_si128(s0, s3);
+    s2 = _mm_xor_si128(s2, t);
+    s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+  }
+
+  _mm_storeu_si128((__m128i*)m_state[0], s0);
+  _mm_storeu_si128((__m128i*)m_state[1], s1);
+  _mm_storeu_si128((__m128i*)m_state[2], s2);
+  _mm_storeu_si128((__m128i*)m_state[3], s3);
+  m_nCount += i - first;
+#endif
+
+  for(; i < count; ++i)
+    out[i] = getFloat();
 }
\ No newline at end of file
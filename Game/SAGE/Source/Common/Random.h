@@ -8,18 +8,29 @@
 #define __RANDOM__
 
 /// \brief A random number generator.
+///
+/// Runs four xoshiro128** generators side by side and hands out their
+/// outputs in turn, so that fillUniform() can step all four at once with
+/// SSE2. The sequence depends only on the seed, never on which calls were
+/// used to draw from it. Each instance has its own state; give every thread
+/// (or every independently updated object) its own CRandom.
 /// \note This class assumes that integers and floats are both 32-bit.
 class CRandom{
   private:
     int m_nCount; ///< Tracks the number of times the generator is used.
+    unsigned int m_state[4][4]; ///< Generator state, word by word, one lane per generator.
+    unsigned int m_buffer[4]; ///< Outputs of the last step.
+    int m_nBuffered; ///< Outputs of the last step not handed out yet, taken from the back.
+    void step(unsigned int out[4]); ///< Advances all four generators.
   public:
     CRandom(); ///< Constructor.
     int getInt(); ///< Returns a random 32-bit integer.
     int getInt(int minVal,int maxVal); ///< Returns a random number in [i,j).
     void seed(unsigned int seed = 99); ///< Seed the random number generator.
-    float getFloat(); ///< Returns a random float in [0,1].
-    float getFloat(float minVal, float maxVal); ///< Returns a random float in [i,j].
+    float getFloat(); ///< Returns a random float in [0,1).
+    float getFloat(float minVal, float maxVal); ///< Returns a random float in [i,j).
     bool getBool(); ///< Returns a random Boolean value.
+    void fillUniform(float *out, int count); ///< Fills an array with random floats in [0,1).
 };
 
 #endif
@@ -0,0 +1,213 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file RayBoxBatch.cpp
+/// \brief Code for the RayBoxBatch class.
+
+#include <math.h>
+#include "RayBoxBatch.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define RAYBOXBATCH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+  /// Padding boxes sit on a point so far away that no ray segment reaches it.
+  const float kFarAway = 1e30f;
+
+  /// Keeps reciprocals finite, so that no slab test multiplies zero by infinity.
+  const float kTinyDelta = 1e-20f;
+}
+
+RayBoxBatch::RayBoxBatch() :
+  m_boxCount(0)
+{
+}
+
+void RayBoxBatch::clearBoxes()
+{
+  m_minX.clear(); m_minY.clear(); m_minZ.clear();
+  m_maxX.clear(); m_maxY.clear(); m_maxZ.clear();
+  m_boxCount = 0;
+}
+
+/// \param box Specifies the box.
+/// \return The index of the box, as reported in Hit::box.
+unsigned int RayBoxBatch::addBox(const AABB3 &box)
+{
+  if(m_boxCount % 4 == 0)
+  {
+    // Start a new group of four, filled with padding
+    m_minX.resize(m_boxCount + 4, kFarAway); m_minY.resize(m_boxCount + 4, kFarAway); m_minZ.resize(m_boxCount + 4, kFarAway);
+    m_maxX.resize(m_boxCount + 4, kFarAway); m_maxY.resize(m_boxCount + 4, kFarAway); m_maxZ.resize(m_boxCount + 4, kFarAway);
+  }
+  m_minX[m_boxCount] = box.min.x; m_minY[m_boxCount] = box.min.y; m_minZ[m_boxCount] = box.min.z;
+  m_maxX[m_boxCount] = box.max.x; m_maxY[m_boxCount] = box.max.y; m_maxZ[m_boxCount] = box.max.z;
+  return m_boxCount++;
+}
+
+void RayBoxBatch::clearRays()
+{
+  m_rays.clear();
+}
+
+/// \param rayOrg Specifies the origin of the ray.
+/// \param rayDelta Specifies the length and direction of the ray.
+/// \return The index of the ray, which is also its index in findNearestHits() results.
+unsigned int RayBoxBatch::addRay(const Vector3 &rayOrg, const Vector3 &rayDelta)
+{
+  m_rays.push_back(makeRay(rayOrg, rayDelta));
+  return (unsigned int)m_rays.size() - 1;
+}
+
+void RayBoxBatch::findNearestHits(std::vector<Hit> &hits) const
+{
+  hits.resize(m_rays.size());
+  for(unsigned int i = 0; i < m_rays.size(); ++i)
+    hits[i] = intersect(m_rays[i], false);
+}
+
+/// \param rayOrg Specifies the origin of the ray.
+/// \param rayDelta Specifies the length and direction of the ray.
+/// \return The nearest box hit, if any.
+RayBoxBatch::Hit RayBoxBatch::findNearestHit(const Vector3 &rayOrg, const Vector3 &rayDelta) const
+{
+  return intersect(makeRay(rayOrg, rayDelta), false);
+}
+
+/// \param rayOrg Specifies the origin of the ray.
+/// \param rayDelta Specifies the length and direction of the ray.
+/// \return True iff the ray hits at least one box.  Stops at the first box found.
+bool RayBoxBatch::hitsAny(const Vector3 &rayOrg, const Vector3 &rayDelta) const
+{
+  return intersect(makeRay(rayOrg, rayDelta), true).box >= 0;
+}
+
+bool RayBoxBatch::usesSSE()
+{
+#ifdef RAYBOXBATCH_SSE
+  return true;
+#else
+  return false;
+#endif
+}
+
+RayBoxBatch::Ray RayBoxBatch::makeRay(const Vector3 &rayOrg, const Vector3 &rayDelta)
+{
+  Ray ray;
+  ray.org = rayOrg;
+  ray.invDelta.x = 1.0f / (fabs(rayDelta.x) < kTinyDelta ? kTinyDelta : rayDelta.x);
+  ray.invDelta.y = 1.0f / (fabs(rayDelta.y) < kTinyDelta ? kTinyDelta : rayDelta.y);
+  ray.invDelta.z = 1.0f / (fabs(rayDelta.z) < kTinyDelta ? kTinyDelta : rayDelta.z);
+  return ray;
+}
+
+/// Slab test:  along each axis, the ray is between the box's planes for an interval
+/// of t.  The ray hits the box where the three intervals and [0,1] overlap, and the
+/// hit distance is the start of the overlap.  Boxes are only accepted if they are
+/// closer than the best hit so far, which also shrinks the search as it goes.
+/// \param ray Specifies the ray.
+/// \param stopAtFirst True to return as soon as any box is hit, nearest or not.
+/// \return The nearest box hit, or the first one found if stopAtFirst is true.
+RayBoxBatch::Hit RayBoxBatch::intersect(const Ray &ray, bool stopAtFirst) const
+{
+  Hit hit;
+  hit.box = -1;
+  hit.t = 1.0f;
+  unsigned int paddedCount = (unsigned int)m_minX.size();
+
+#ifdef RAYBOXBATCH_SSE
+  const __m128 orgX = _mm_set1_ps(ray.org.x), orgY = _mm_set1_ps(ray.org.y), orgZ = _mm_set1_ps(ray.org.z);
+  const __m128 invX = _mm_set1_ps(ray.invDelta.x), invY = _mm_set1_ps(ray.invDelta.y), invZ = _mm_set1_ps(ray.invDelta.z);
+  const __m128 zero = _mm_setzero_ps();
+  __m128 best = _mm_set1_ps(hit.t);
+
+  for(unsigned int i = 0; i < paddedCount; i += 4)
+  {
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_minX[i]), orgX), invX);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_maxX[i]), orgX), invX);
+    __m128 tNear = _mm_max_ps(zero, _mm_min_ps(t1, t2));
+    __m128 tFar = _mm_min_ps(best, _mm_max_ps(t1, t2));
+
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_minY[i]), orgY), invY);
+    t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_maxY[i]), orgY), invY);
+    tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+    tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_minZ[i]), orgZ), invZ);
+    t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_maxZ[i]), orgZ), invZ);
+    tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+    tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+
+    int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+    if(mask == 0)
+      continue;
+
+    float t[4];
+    _mm_storeu_ps(t, tNear);
+    for(int lane = 0; lane < 4; ++lane)
+      if((mask & (1 << lane)) && (hit.box < 0 || t[lane] < hit.t))
+      {
+        hit.box = (int)(i + lane);
+        hit.t = t[lane];
+      }
+    if(stopAtFirst)
+      return hit;
+    best = _mm_set1_ps(hit.t);
+  }
+#else
+  for(unsigned int i = 0; i < paddedCount; ++i)
+  {
+    float t1 = (m_minX[i] - ray.org.x) * ray.invDelta.x, t2 = (m_maxX[i] - ray.org.x) * ray.invDelta.x;
+    float tNear = t1 < t2 ? t1 : t2, tFar = t1 < t2 ? t2 : t1;
+    if(tNear < 0.0f) tNear = 0.0f;
+    if(tFar > hit.t) tFar = hit.t;
+
+    t1 = (m_minY[i] - ray.org.y) * ray.invDelta.y; t2 = (m_maxY[i] - ray.org.y) * ray.invDelta.y;
+    if((t1 < t2 ? t1 : t2) > tNear) tNear = t1 < t2 ? t1 : t2;
+    if((t1 < t2 ? t2 : t1) < tFar) tFar = t1 < t2 ? t2 : t1;
+
+    t1 = (m_minZ[i] - ray.org.z) * ray.invDelta.z; t2 = (m_maxZ[i] - ray.org.z) * ray.invDelta.z;
+    if((t1 < t2 ? t1 : t2) > tNear) tNear = t1 < t2 ? t1 : t2;
+    if((t1 < t2 ? t2 : t1) < tFar) tFar = t1 < t2 ? t2 : t1;
+
+    if(tNear <= tFar && (hit.box < 0 || tNear < hit.t))
+    {
+      hit.box = (int)i;
+      hit.t = tNear;
+      if(stopAtFirst)
+        return hit;
+    }
+  }
+#endif
+
+  return hit;
+}
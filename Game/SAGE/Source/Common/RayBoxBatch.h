@@ -0,0 +1,97 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file RayBoxBatch.h
+/// \brief Interface for the RayBoxBatch class.
+
+#ifndef __RAYBOXBATCH_H_INCLUDED__
+#define __RAYBOXBATCH_H_INCLUDED__
+
+#include <vector>
+#include "Common/AABB3.h"
+#include "Common/Vector3.h"
+
+/// \brief Intersects many ray segments with many boxes at once.
+///
+/// Boxes are stored structure-of-arrays (all min x's together, and so on), padded
+/// to a multiple of four, so that the slab test runs on four boxes per SSE
+/// instruction.  Rays use the same convention as AABB3::rayIntersect():  a ray is
+/// an origin plus a delta, and hits are reported as a parametric distance in
+/// [0,1] along the delta, 0 if the origin is inside a box.
+///
+/// Typical use is to add every box and every ray for a frame, then call
+/// findNearestHits() once.  Single rays can be tested with findNearestHit() and
+/// hitsAny() without adding them.  Builds without SSE use an equivalent scalar loop.
+class RayBoxBatch
+{
+  public:
+    /// \brief The nearest box hit by a ray.
+    struct Hit
+    {
+      int box;  ///< Index of the box hit, in the order added, or -1 if none.
+      float t;  ///< Parametric distance of the hit along the ray delta.
+    };
+
+    RayBoxBatch();
+
+    void clearBoxes();  ///< Removes all boxes.
+    unsigned int addBox(const AABB3 &box);  ///< Adds a box and returns its index.
+    unsigned int getBoxCount() const { return m_boxCount; }  ///< Queries the number of boxes.
+
+    void clearRays();  ///< Removes all rays.
+    unsigned int addRay(const Vector3 &rayOrg, const Vector3 &rayDelta);  ///< Adds a ray and returns its index.
+    unsigned int getRayCount() const { return (unsigned int)m_rays.size(); }  ///< Queries the number of rays.
+
+    /// \brief Finds the nearest box hit by each added ray.
+    /// \param hits Receives one Hit per ray, in the order added.
+    void findNearestHits(std::vector<Hit> &hits) const;
+
+    Hit findNearestHit(const Vector3 &rayOrg, const Vector3 &rayDelta) const;  ///< Finds the nearest box hit by one ray.
+    bool hitsAny(const Vector3 &rayOrg, const Vector3 &rayDelta) const;  ///< Tests whether one ray hits any box.
+
+    static bool usesSSE();  ///< Returns true iff this build runs the SSE slab test.
+
+  private:
+    /// \brief A ray, set up for slab tests.
+    struct Ray
+    {
+      Vector3 org;      ///< Origin of the ray.
+      Vector3 invDelta; ///< Reciprocal of the ray delta, with zero components nudged away from zero.
+    };
+
+    static Ray makeRay(const Vector3 &rayOrg, const Vector3 &rayDelta);  ///< Sets up a ray for slab tests.
+    Hit intersect(const Ray &ray, bool stopAtFirst) const;  ///< Runs one ray against all boxes.
+
+    std::vector<float> m_minX, m_minY, m_minZ; ///< Minimum corners of the boxes, padded to a multiple of four.
+    std::vector<float> m_maxX, m_maxY, m_maxZ; ///< Maximum corners of the boxes, padded to a multiple of four.
+    unsigned int m_boxCount;  ///< Number of boxes, not counting padding.
+    std::vector<Ray> m_rays;  ///< Added rays.
+};
+
+#endif
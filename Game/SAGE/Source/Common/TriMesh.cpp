@@ -19,6 +19,9 @@
 #include "TriMesh.h"
 #include "common/renderer.h"
 #include "EditTriMesh.h"
+#include "Matrix4x3.h"
+#include "BatchMath.h"
+#include "../../Bullet/src/LinearMath/btConvexHullComputer.h"
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -37,6 +40,8 @@ TriMesh::TriMesh() {
 	triCount = 0;
 	triList = NULL;
 	boundingBox.empty();
+	hullCount = 0;
+	hullList = NULL;
 }
 
 //---------------------------------------------------------------------------
@@ -97,6 +102,8 @@ void	TriMesh::freeMemory() {
 	triList = NULL;
 	vertexCount = 0;
 	triCount = 0;
+
+	freeHull();
 }
 
 //---------------------------------------------------------------------------
@@ -121,19 +128,78 @@ void	TriMesh::computeBoundingBox() {
 
 	// Add in vertex locations
 
-	for (int i = 0 ; i < vertexCount ; ++i) {
-		boundingBox.add(vertexList[i].p);
+	if (vertexCount > 0) {
+		BatchMath::bound(&vertexList[0].p, sizeof(RenderVertex), vertexCount, boundingBox);
+	}
+
+	// The extreme points in any direction are on the hull, so the hull
+	// gives the same transformed bounds as the whole vertex list
+
+	computeHull();
+}
+
+//---------------------------------------------------------------------------
+// TriMesh::computeHull
+//
+// Compute the convex hull of the vertex list.  The hull is only kept if it
+// has fewer vertices than the mesh.
+
+void	TriMesh::computeHull() {
+
+	freeHull();
+
+	if (vertexCount < 4) {
+		return;
+	}
+
+	btConvexHullComputer hull;
+	hull.compute(&vertexList[0].p.x, sizeof(RenderVertex), vertexCount, 0.0f, 0.0f);
+
+	int n = hull.vertices.size();
+	if (n == 0 || n >= vertexCount) {
+		return;
+	}
+
+	hullCount = n;
+	hullList = new Vector3[hullCount];
+	for (int i = 0 ; i < hullCount ; ++i) {
+		const btVector3 &v = hull.vertices[i];
+		hullList[i] = Vector3(v.getX(), v.getY(), v.getZ());
 	}
 }
 
+//---------------------------------------------------------------------------
+// TriMesh::freeHull
+//
+// Free the convex hull
+
+void	TriMesh::freeHull() {
+	delete [] hullList;
+	hullList = NULL;
+	hullCount = 0;
+}
+
+/// The exact box is the box of the transformed hull vertices (or of all
+/// the vertices, if the hull isn't stored).  The fast box transforms the
+/// corners of the local bounding box, which costs the same for every mesh
+/// but can be larger than the exact box when the mesh is rotated.
 /// \param m Specifies the transformation matrix to be applied.
+/// \param exact Specifies whether to compute the smallest box or a
+/// quicker box that contains it.
 /// \return The bounding box for the mesh under m.
-AABB3 TriMesh::getBoundingBox(const Matrix4x3 &m) const
+AABB3 TriMesh::getBoundingBox(const Matrix4x3 &m, bool exact) const
 {
   AABB3 bb;
+  if (!exact && !boundingBox.isEmpty())
+  {
+    bb.setToTransformedBox(boundingBox, m);
+    return bb;
+  }
   bb.empty();
-  for (int i = 0; i < vertexCount; ++i)
-    bb.add(vertexList[i].p * m);
+  if (hullList != NULL)
+    BatchMath::transformAndBound(hullList, sizeof(Vector3), hullCount, m, bb);
+  else if (vertexCount > 0)
+    BatchMath::transformAndBound(&vertexList[0].p, sizeof(RenderVertex), vertexCount, m, bb);
   return bb;
 }
 
@@ -226,4 +292,11 @@ void TriMesh::moveVertices(Vector3 v){ //move all vertices by this amount
   for(int i = 0; i<vertexCount; i++){
     vertexList[i].p += v;
   }
+  for(int i = 0; i<hullCount; i++){
+    hullList[i] += v;
+  }
+  if(!boundingBox.isEmpty()){
+    boundingBox.min += v;
+    boundingBox.max += v;
+  }
 }
@@ -36,6 +36,8 @@ class EditTriMesh;
 /// Stores a triangular mesh in a format optimized for real-time operations,
 /// such as rendering and collision detection.
 class TriMesh {
+  friend class CompiledModel;
+
 public:
 
 	TriMesh();  ///< Constructs an empty mesh.
@@ -70,13 +72,17 @@ public:
 
 	// Bounding box
 
-	void		computeBoundingBox();  ///< Computes and internally stores the mesh's bounding box.
+	void		computeBoundingBox();  ///< Computes and internally stores the mesh's bounding box and convex hull.
 	
 	/// \brief Queries the mesh for its bounding box.
 	/// \return The last bounding box computed for the mesh.
 	const AABB3	&getBoundingBox() const { return boundingBox; }
 
-  AABB3 getBoundingBox(const Matrix4x3 &m) const;  ///< Queries the mesh for its bounding box, given a transformation matrix.
+  AABB3 getBoundingBox(const Matrix4x3 &m, bool exact = true) const;  ///< Queries the mesh for its bounding box, given a transformation matrix.
+
+  /// \brief Queries the mesh for the number of vertices on its convex hull.
+  /// \return The number of hull vertices, or 0 if the hull isn't stored.
+  int getHullVertexCount() const { return hullCount; }
 
 	// Conversion to/from an "edit" mesh.  Note that this class
 	// doesn't know anything about parts or materials, so the
@@ -99,6 +105,13 @@ protected:
 	AABB3	boundingBox;          ///< Stores the last computed bounding box.
 	                            ///< Must be recomputed if the vertex list
 	                            ///< is modified.
+
+	int		hullCount;            ///< Specifies the number of hull vertices.
+	Vector3	*hullList;          ///< Contains the vertices of the convex hull.
+	                            ///< Computed with the bounding box.
+
+	void	computeHull();        ///< Computes the convex hull of the vertex list.
+	void	freeHull();           ///< Frees the convex hull.
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,162 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file WorkerPool.cpp
+/// \brief Code for the WorkerPool class.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <windows.h>
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int threadCount) :
+  m_job(NULL),
+  m_count(0),
+  m_chunkSize(1),
+  m_nextIndex(0),
+  m_busy(0),
+  m_quit(false)
+{
+  if(threadCount == 0)
+  {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    threadCount = info.dwNumberOfProcessors;
+  }
+  if(threadCount < 1)
+    threadCount = 1;
+
+  m_wake = CreateSemaphore(NULL, 0, (LONG)threadCount, NULL);
+  m_finished = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+  // The start-up data must not move once the threads are running
+  m_starts.resize(threadCount - 1);
+  for(unsigned int i = 1; i < threadCount; ++i)
+  {
+    m_starts[i - 1].pool = this;
+    m_starts[i - 1].worker = i;
+    HANDLE thread = CreateThread(NULL, 0, threadMain, &m_starts[i - 1], 0, NULL);
+    if(thread == NULL)
+      break;
+    m_threads.push_back(thread);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  m_quit = true;
+  if(!m_threads.empty())
+    ReleaseSemaphore(m_wake, (LONG)m_threads.size(), NULL);
+  for(unsigned int i = 0; i < m_threads.size(); ++i)
+  {
+    WaitForSingleObject(m_threads[i], INFINITE);
+    CloseHandle(m_threads[i]);
+  }
+  CloseHandle(m_wake);
+  CloseHandle(m_finished);
+}
+
+/// Every index is run exactly once, but in no particular order and on no particular
+/// thread, so the job must not rely on either.  Loops with only one chunk, or pools
+/// with only one thread, run entirely on the calling thread.
+/// \param job Specifies the loop body.
+/// \param count Specifies the number of indices.
+/// \param chunkSize Specifies how many indices a thread takes at a time.
+void WorkerPool::parallelFor(Job &job, unsigned int count, unsigned int chunkSize)
+{
+  if(count == 0)
+    return;
+  if(chunkSize == 0)
+    chunkSize = 1;
+  if(m_threads.empty() || count <= chunkSize)
+  {
+    job.run(0, count, 0);
+    return;
+  }
+
+  assert(m_busy == 0); // Loops can't be nested
+  m_job = &job;
+  m_count = count;
+  m_chunkSize = chunkSize;
+  m_nextIndex = 0;
+  m_busy = (LONG)m_threads.size();
+
+  // Releasing the semaphore is a full barrier, so the workers see the fields above
+  ReleaseSemaphore(m_wake, (LONG)m_threads.size(), NULL);
+
+  runChunks(0);
+
+  WaitForSingleObject(m_finished, INFINITE);
+  m_job = NULL;
+}
+
+/// Every thread gets its own copy of the CRT rand() state, starting from the
+/// same default seed, so each worker reseeds its copy; otherwise jobs calling
+/// rand() would draw the same numbers on every thread.
+/// \param start Points to the thread's WorkerStart.
+/// \return Always 0.
+DWORD WINAPI WorkerPool::threadMain(LPVOID start)
+{
+  WorkerStart *s = (WorkerStart*)start;
+  srand(GetTickCount() ^ (s->worker * 0x9E3779B9u));
+  s->pool->workerMain(s->worker);
+  return 0;
+}
+
+/// Each loop releases the semaphore once per worker.  A worker that finishes early
+/// may take a second count of the same loop and find no chunks left; the loop still
+/// ends only after every count has been taken and given back through m_busy.
+/// \param worker Specifies the index of the worker thread.
+void WorkerPool::workerMain(unsigned int worker)
+{
+  for(;;)
+  {
+    WaitForSingleObject(m_wake, INFINITE);
+    if(m_quit)
+      return;
+
+    runChunks(worker);
+
+    if(InterlockedDecrement(&m_busy) == 0)
+      SetEvent(m_finished);
+  }
+}
+
+/// \param worker Specifies the index of the running thread.
+void WorkerPool::runChunks(unsigned int worker)
+{
+  for(;;)
+  {
+    unsigned int begin = (unsigned int)InterlockedExchangeAdd(&m_nextIndex, (LONG)m_chunkSize);
+    if(begin >= m_count)
+      return;
+    unsigned int end = m_count - begin < m_chunkSize ? m_count : begin + m_chunkSize;
+    m_job->run(begin, end, worker);
+  }
+}
@@ -0,0 +1,99 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file WorkerPool.h
+/// \brief Interface for the WorkerPool class.
+
+#ifndef __WORKERPOOL_H_INCLUDED__
+#define __WORKERPOOL_H_INCLUDED__
+
+#include <vector>
+
+/// \brief A small pool of threads that splits loops into chunks.
+///
+/// The pool runs one loop at a time.  parallelFor() cuts the index range into
+/// chunks, hands them out to the worker threads and the calling thread alike,
+/// and returns once every chunk is done.  Threads sleep between loops.
+/// Built on Win32 threads; the handles are kept as void pointers so that
+/// this header doesn't pull in windows.h.
+class WorkerPool
+{
+  public:
+    /// \brief A loop body run by parallelFor().
+    class Job
+    {
+      public:
+        virtual ~Job() {}
+        /// \brief Runs the loop body over indices [begin,end).
+        /// \param begin Specifies the first index of the chunk.
+        /// \param end Specifies one past the last index of the chunk.
+        /// \param worker Specifies which thread runs the chunk, from 0 (the calling thread)
+        ///     to getThreadCount()-1.  Handy for indexing per-thread buffers.
+        virtual void run(unsigned int begin, unsigned int end, unsigned int worker) = 0;
+    };
+
+    /// \brief Starts the pool.
+    /// \param threadCount Specifies the total number of threads, counting the caller
+    ///     of parallelFor().  Zero picks one per hardware thread.
+    explicit WorkerPool(unsigned int threadCount = 0);
+    ~WorkerPool();  ///< Stops and joins the worker threads.
+
+    unsigned int getThreadCount() const { return (unsigned int)m_threads.size() + 1; }  ///< Queries the number of threads, counting the caller.
+
+    /// \brief Runs a job over indices [0,count), in chunks, on all threads.
+    /// \param job Specifies the loop body.
+    /// \param count Specifies the number of indices.
+    /// \param chunkSize Specifies how many indices a thread takes at a time.
+    void parallelFor(Job &job, unsigned int count, unsigned int chunkSize);
+
+  private:
+    /// \brief Start-up data for one worker thread.
+    struct WorkerStart
+    {
+      WorkerPool *pool;     ///< Pool the thread belongs to.
+      unsigned int worker;  ///< Index of the thread.
+    };
+
+    static unsigned long __stdcall threadMain(void *start);  ///< Entry point of each worker thread.
+    void workerMain(unsigned int worker);  ///< Body of each worker thread.
+    void runChunks(unsigned int worker);   ///< Takes and runs chunks until there are none left.
+
+    std::vector<void*> m_threads;          ///< Worker threads; worker i is m_threads[i-1].
+    std::vector<WorkerStart> m_starts;     ///< Start-up data of the worker threads.
+    void *m_wake;                          ///< Semaphore released once per worker when a loop starts, or to quit.
+    void *m_finished;                      ///< Event set by the last worker to leave a loop.
+    Job *m_job;                            ///< Job of the current loop.
+    unsigned int m_count;                  ///< Index count of the current loop.
+    unsigned int m_chunkSize;              ///< Chunk size of the current loop.
+    volatile long m_nextIndex;             ///< First index not yet handed out.
+    volatile long m_busy;                  ///< Workers still in the current loop.
+    volatile bool m_quit;                  ///< Tells the workers to exit.
+};
+
+#endif
@@ -41,6 +41,7 @@
 #include <iostream>
 #include "tinyxml/tinyxml.h"
 #include "ConsoleCommentEntry.h"
+#include <stdio.h>
 
 using namespace std;
 
@@ -51,13 +52,6 @@ Console gConsole;
 /// prototype for function that adds all the engine commands to the console
 void AddEngineConsoleCommands();
 
-
-/// \brief hashtable pair typedef
-typedef pair<string, int> hashIntPair;
-
-/// \brief hashtable pair iterator typedef
-typedef pair<HashTableInt::const_iterator, HashTableInt::const_iterator> hashIntIteratorPair;
-
 // constructor initiate member variables
 Console::Console()
 {
@@ -68,6 +62,8 @@ Console::Console()
 	m_consoleActivating = 0;
 	m_consoleDeactivating = 0;
 
+	m_executingScript = false;
+
 	m_consoleHeight = 0;
 	m_consoleWidth = 0;
 	
@@ -385,67 +381,68 @@ void Console::shutdown()
 /// \param line processes a line as if the user typed it in the console.
 /// \param printToConsole True indicates that the line parameter should
 /// be printed to the console.
-void Console::processLine(std::string line, bool printToConsole)
+void Console::processLine(const std::string& line, bool printToConsole)
+{
+	processLine(line.c_str(), (int)line.length(), printToConsole);
+}
+
+/// The command is processed as if it were typed on the console.
+/// The parser and parameter list are members that are reused for every
+/// line, so this doesn't allocate memory unless something is printed.
+/// \param line Characters of the line, need not be zero terminated
+/// \param length Number of characters in line
+/// \param printToConsole True indicates that the line parameter should
+/// be printed to the console.
+void Console::processLine(const char* line, int length, bool printToConsole)
 {
 
 
 	// Variables
-	ParameterList paramList; // used to store parameters passed to functions
-	TextParser tp; // used to parse the texted passed in
 	bool result = 0; // stores the result of text parsing
-	string command; // holds the command aka the first word in line
 	ConsoleFunctionEntry* entry = NULL; // pointer used to access items in m_vectorCommands
 	
 	string errorMessage; // used to hold an error message from a user defined function
 
 	// check if the command should be printed to the console
 	if (printToConsole) 
-		printLine(line);
+		printLine(string(line, length));
 
 	
 
-	// peel off the command
-	int i = 0;
-	string s = line;
-	i = (int)s.find_first_of(' ');
-	if (i == -1)
-	{
-		command = s;
-		s = "";
+	// peel off the command, the parameters start after the first space
+	int commandLength = 0;
+	while (commandLength < length && line[commandLength] != ' ')
+		commandLength++;
+	int parametersStart = commandLength < length ? commandLength + 1 : length;
 
-	}
-	else
-	{
-		command = s.substr(0, i);
-		s = s.substr(i+1, s.length());
-	}
-	
-
-	result = tp.parse(s);
+	result = m_parser.parse(line + parametersStart, length - parametersStart);
 
 
 	// if the text parsing failed print the error to the console and return
 	if (result == false)
 	{
 		// print what the error was to the console and then leave
-		printLine(tp.errorMessage);
+		printLine(m_parser.errorMessage);
 		return;
 	}
 		 	
 
+	// commands are registered by now, so make lookups constant time
+	m_commandTable.build();
+
 	// get a pointer to the entry if it exists
-	entry = getMatchingEntry(command);
+	entry = getMatchingEntry(line, commandLength);
 		
 	// if it exists
 	if (entry != NULL) 
 	{
-		if (entry->getParameters() == tp.getTypes())
+		if (entry->getParameters() == m_parser.getTypes())
 		{
 		// feed in parameters into structure
-		tp.feedParameterList(&paramList);
+		m_parser.feedParameterList(&m_parameters);
 
 		// call the function
-		result = entry->callFunction(&paramList, &errorMessage);
+		result = entry->callFunction(&m_parameters, &errorMessage);
 
 		// if custom function returns false then print the errorMessage
 		if (result == false)
@@ -455,7 +452,7 @@ void Console::processLine(std::string line, bool printToConsole)
 		{
 			// parameters mismatch, print out the prototype
 			printLine("parameter mismatch");
-			printLine("Prototype: " + command + " " + 
+			printLine("Prototype: " + string(line, commandLength) + " " + 
 				getParameterListFromString(entry->getParameters()));
 		}
 	}
@@ -468,6 +465,67 @@ void Console::processLine(std::string line, bool printToConsole)
 	return;
 }
 
+/// Runs every line of a text file through processLine, as if each one
+/// had been typed on the console.  Empty lines and lines starting with
+/// "//" are skipped.  The file is read into a buffer that is kept for the
+/// next script, and the lines are parsed where they are.
+/// \param fileName Name of the script file
+/// \return Number of commands executed, or -1 if the file couldn't be read
+int Console::executeScript(const std::string& fileName)
+{
+	// the script buffer can't be replaced while it is being executed
+	if (m_executingScript)
+	{
+		printLine("Scripts can't execute other scripts");
+		return -1;
+	}
+
+	FILE* file = NULL;
+	if (fopen_s(&file, fileName.c_str(), "rb") != 0 || file == NULL)
+	{
+		printLine("Failed to open script: '" + fileName + "'");
+		return -1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	m_scriptBuffer.resize(size > 0 ? size : 1);
+	size_t bytesRead = size > 0 ? fread(&m_scriptBuffer[0], 1, size, file) : 0;
+	fclose(file);
+
+	m_executingScript = true;
+
+	const char* text = &m_scriptBuffer[0];
+	int textLength = (int)bytesRead;
+	int numCommands = 0;
+	int lineStart = 0;
+	while (lineStart < textLength)
+	{
+		// find the end of the line and drop a trailing carriage return
+		int lineEnd = lineStart;
+		while (lineEnd < textLength && text[lineEnd] != '\n')
+			lineEnd++;
+		int lineLength = lineEnd - lineStart;
+		if (lineLength > 0 && text[lineEnd - 1] == '\r')
+			lineLength--;
+
+		const char* line = text + lineStart;
+		bool comment = lineLength >= 2 && line[0] == '/' && line[1] == '/';
+		if (lineLength > 0 && !comment)
+		{
+			processLine(line, lineLength);
+			numCommands++;
+		}
+
+		lineStart = lineEnd + 1;
+	}
+
+	m_executingScript = false;
+
+	return numCommands;
+}
+
 
 // prints a line to the console with wrapping
 /// \param line Text to print to the console
@@ -564,7 +622,7 @@ void Console::pressedChar(char input)
 	if (input == 13) // enter pressed
 	{
 		// process line
-		processLine(m_inputLine.c_str(), true);
+		processLine(m_inputLine, true);
 		
 		// clear user input
 		m_inputLine = "";
@@ -896,17 +954,13 @@ void Console::helpCommand(std::string command)
     // print a space 
 			printLine("");
 
-		// search hashtable for the command
-		hashIntIteratorPair p = m_hashTable.equal_range(command);
-		// go through every entry with that name
-		for (HashTableInt::const_iterator i = p.first; i != p.second; ++i)
+		// search the table for the command
+		entry = getMatchingEntry(command);
+		if (entry != NULL)
 		{	  
 			// mark that the command was found
 			commandFound = true;
 
-			// get a pointer to the command entry
-			entry = m_vectorCommands[i->second];	
-
 			// tell the entry to print its detailed information
 			entry->printDetailedInformation();						
 				
@@ -934,31 +988,27 @@ ConsoleFunctionEntry* Console::createEntry(std::string commandName)
 	// push cfe onto the end
 	m_vectorCommands.push_back(cfe);
 
-	// create a pair object with the key (FunctionName) and the index into
-	// the vector (index)
-	hashIntPair htp(commandName,index);
-
-	// put it in the hashtable
-	m_hashTable.insert(htp);
+	// map the key (FunctionName) to the index into the vector (index)
+	m_commandTable.insert(commandName, index);
 
 	// return a pointer to the entry
 	return cfe;
 }
 
  ///< returns a pointer to an entry if it exists
-ConsoleFunctionEntry* Console::getMatchingEntry(std::string commandName)
+ConsoleFunctionEntry* Console::getMatchingEntry(const char* commandName, int length)
 {
 
 			
 	// find the key
-	HashTableInt::const_iterator p = m_hashTable.find(commandName);	
+	int index = m_commandTable.find(commandName, length);	
 	
 	// if the key is not there leave
-    if ( p == m_hashTable.end( ) ) 
+    if ( index < 0 ) 
 		return NULL;
 	  
 	// return a pointer to the ConsoleFunctionEntry
-	return m_vectorCommands[p->second];
+	return m_vectorCommands[index];
 		
 
 	}
@@ -37,19 +37,15 @@
 #include "common/eulerangles.h"
 #include "common/rectangle.h"
 #include "ConsoleFunctionEntry.h"
+#include "ConsoleCommandTable.h"
+#include "textParser.h"
 #include <string>
+#include <vector>
 #include <iostream>
-#include <hash_map>
 
 
 #include "ParameterList.h"
 
-
-
-// this template is kind of messy to declare so a typedef is
-// in order
-typedef stdext::hash_map<const std::string,int> HashTableInt;
-
 //-------------------------------------------------------------------------
 /// \class Console
 /// \brief Provides a console allowing the user to type commands at 
@@ -143,7 +139,13 @@ public:
 	//@{
 
 	/// \brief Process the string passed as a command	
-	void processLine(std::string line, bool printToConsole = false); 
+	void processLine(const std::string& line, bool printToConsole = false); 
+
+	/// \brief Process the characters passed as a command	
+	void processLine(const char* line, int length, bool printToConsole = false); 
+
+	/// \brief Processes every line of a file as a command
+	int executeScript(const std::string& fileName);
 	
 	
 	/// \brief Inserts a line into the console	
@@ -272,10 +274,14 @@ private:
 	ConsoleFunctionEntry* createEntry(std::string commandName);
 
 	/// \brief Returns a pointer to an entry if it exists
-	ConsoleFunctionEntry* getMatchingEntry(std::string commandName); 
+	ConsoleFunctionEntry* getMatchingEntry(const char* commandName, int length); 
+	
+	/// \brief Returns a pointer to an entry if it exists
+	ConsoleFunctionEntry* getMatchingEntry(const std::string& commandName) 
+		{return getMatchingEntry(commandName.c_str(), (int)commandName.length());}
 	
-	/// \brief Indexes to function data is stored in this hashtable
-	HashTableInt m_hashTable; 
+	/// \brief Indexes to function data is stored in this table
+	ConsoleCommandTable m_commandTable; 
 	
 	/// \brief All the functions and comments are stored in this vector
 	std::vector<ConsoleFunctionEntry*> m_vectorCommands; 
@@ -283,6 +289,21 @@ private:
 	//@}
 	//-------------------------------------------------------------------------
 
+	//-------------------------------------------------------------------------
+	/// \name Command Processing Members
+	/// \brief Reused for every line so that processing a command
+	/// doesn't allocate memory
+	/// 
+	//@{
+
+	TextParser m_parser; ///< Splits lines into parameters
+	ParameterList m_parameters; ///< Parameters passed to the command functions
+	std::vector<char> m_scriptBuffer; ///< Contents of the script being executed
+	bool m_executingScript; ///< True while executeScript is running
+
+	//@}
+	//-------------------------------------------------------------------------
+
 	void processInput(); ///< Process input since last call
 
 	/// \brief Set if the console is down, coming down or going up
@@ -0,0 +1,205 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file ConsoleCommandTable.cpp
+/// \brief Code for the ConsoleCommandTable class.
+
+#include "ConsoleCommandTable.h"
+#include <string.h>
+#include <algorithm>
+using namespace std;
+
+/// Number of displacements to try for a bucket before growing the table
+static const unsigned int kMaxDisplacement = 4096;
+
+ConsoleCommandTable::ConsoleCommandTable()
+{
+	m_dirty = false;
+}
+
+/// \param name Command name.  The caller makes sure it isn't already in
+/// the table.
+/// \param value Value that find returns for the name, must not be negative
+void ConsoleCommandTable::insert(const std::string& name, int value)
+{
+	m_names.push_back(name);
+	m_hashes.push_back(hashName(name.c_str(), (int)name.length()));
+	m_values.push_back(value);
+	m_dirty = true;
+}
+
+/// \param name Characters of the name, need not be zero terminated
+/// \param length Number of characters in name
+/// \return Value that was inserted with the name, or -1 if there is none
+int ConsoleCommandTable::find(const char* name, int length)
+{
+	unsigned int hash = hashName(name, length);
+
+	// names added since the last build have no slot yet, and names whose
+	// hashes collide can't be given slots at all
+	if (m_dirty || m_slots.empty())
+	{
+		for (int i = 0; i < (int)m_names.size(); i++)
+			if (m_hashes[i] == hash && (int)m_names[i].length() == length &&
+				memcmp(m_names[i].c_str(), name, length) == 0)
+				return m_values[i];
+		return -1;
+	}
+
+	unsigned int bucket = hash & (unsigned int)(m_displacements.size() - 1);
+	unsigned int slot = displace(hash, m_displacements[bucket]) & (unsigned int)(m_slots.size() - 1);
+	
+	int index = m_slots[slot];
+	if (index < 0 || m_hashes[index] != hash || 
+		(int)m_names[index].length() != length ||
+		memcmp(m_names[index].c_str(), name, length) != 0)
+		return -1;
+
+	return m_values[index];
+}
+
+void ConsoleCommandTable::clear()
+{
+	m_names.clear();
+	m_hashes.clear();
+	m_values.clear();
+	m_displacements.clear();
+	m_slots.clear();
+	m_dirty = false;
+}
+
+/// FNV-1a
+unsigned int ConsoleCommandTable::hashName(const char* name, int length)
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+	return hash;
+}
+
+/// Finalizer from MurmurHash3, so that every displacement gives an
+/// unrelated slot.
+unsigned int ConsoleCommandTable::displace(unsigned int hash, unsigned int displacement)
+{
+	unsigned int x = hash ^ (displacement * 0x9E3779B9u);
+	x ^= x >> 16;
+	x *= 0x85EBCA6Bu;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35u;
+	x ^= x >> 16;
+	return x;
+}
+
+/// The biggest buckets are placed first, while the table is emptiest.
+/// With twice as many slots as names this almost always succeeds on the
+/// first size; if some bucket can't be placed the table doubles.  Two names
+/// with the same hash can never be placed, so past 16 slots per name the
+/// table is left empty and find() keeps comparing against every name.
+void ConsoleCommandTable::rebuild()
+{
+	m_dirty = false;
+
+	int numNames = (int)m_names.size();
+	if (numNames == 0)
+	{
+		m_displacements.clear();
+		m_slots.clear();
+		return;
+	}
+
+	unsigned int numSlots = 1;
+	while (numSlots < 2 * (unsigned int)numNames)
+		numSlots *= 2;
+
+	vector<int> bucketStart; // first entry of each bucket in bucketNames
+	vector<int> bucketNames; // names sorted by bucket
+	vector<pair<int,unsigned int> > order; // (-size, bucket) so big buckets sort first
+	
+	for (; numSlots <= 16 * (unsigned int)numNames; numSlots *= 2)
+	{
+		unsigned int numBuckets = numSlots / 2;
+		
+		// group the names by bucket
+		bucketStart.assign(numBuckets + 1, 0);
+		for (int i = 0; i < numNames; i++)
+			bucketStart[(m_hashes[i] & (numBuckets - 1)) + 1]++;
+		for (unsigned int b = 0; b < numBuckets; b++)
+			bucketStart[b + 1] += bucketStart[b];
+		bucketNames.resize(numNames);
+		vector<int> fill(bucketStart.begin(), bucketStart.end() - 1);
+		for (int i = 0; i < numNames; i++)
+			bucketNames[fill[m_hashes[i] & (numBuckets - 1)]++] = i;
+		
+		order.clear();
+		for (unsigned int b = 0; b < numBuckets; b++)
+			if (bucketStart[b + 1] > bucketStart[b])
+				order.push_back(make_pair(bucketStart[b] - bucketStart[b + 1], b));
+		sort(order.begin(), order.end());
+
+		m_displacements.assign(numBuckets, 0);
+		m_slots.assign(numSlots, -1);
+
+		bool placedAll = true;
+		for (int o = 0; o < (int)order.size() && placedAll; o++)
+		{
+			unsigned int b = order[o].second;
+			bool placed = false;
+			for (unsigned int d = 0; d < kMaxDisplacement && !placed; d++)
+			{
+				// claim slots until one is taken, then give them back
+				int k = bucketStart[b];
+				for (; k < bucketStart[b + 1]; k++)
+				{
+					unsigned int slot = displace(m_hashes[bucketNames[k]], d) & (numSlots - 1);
+					if (m_slots[slot] >= 0)
+						break;
+					m_slots[slot] = bucketNames[k];
+				}
+				
+				if (k == bucketStart[b + 1])
+				{
+					m_displacements[b] = d;
+					placed = true;
+				}
+				else
+				{
+					for (int j = bucketStart[b]; j < k; j++)
+						m_slots[displace(m_hashes[bucketNames[j]], d) & (numSlots - 1)] = -1;
+				}
+			}
+			placedAll = placed;
+		}
+
+		if (placedAll)
+			return;
+	}
+
+	m_displacements.clear();
+	m_slots.clear();
+}
@@ -0,0 +1,96 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file ConsoleCommandTable.h
+/// \brief Interface for the ConsoleCommandTable class.
+
+#ifndef __H_CONSOLECOMMANDTABLE_INCLUDED__
+#define __H_CONSOLECOMMANDTABLE_INCLUDED__
+
+#include <string>
+#include <vector>
+
+/// \class ConsoleCommandTable
+/// \brief Maps command names to indices with a perfect hash
+//
+/*!
+Every lookup hashes the name once, reads one displacement and one slot,
+and compares against at most one name.  The table is built with
+hash-and-displace: names are grouped into buckets by their hash, and
+each bucket gets the smallest displacement that sends all its names to
+empty slots.
+
+Commands are added during start up and looked up for every line, so
+insert() only marks the table out of date.  Until build() is called
+find() compares against every name, so registering commands one after
+another doesn't rebuild the table each time.  If two names share a
+hash no displacement can separate them; the table then stays empty and
+find() keeps comparing against every name.
+*/
+class ConsoleCommandTable
+{
+public:
+	ConsoleCommandTable(); ///< Creates an empty table
+
+	/// \brief Adds a name that isn't in the table yet
+	void insert(const std::string& name, int value);
+
+	/// \brief Returns the value for the specified characters, or -1
+	int find(const char* name, int length);
+	
+	/// \brief Returns the value for the specified name, or -1
+	int find(const std::string& name) {return find(name.c_str(), (int)name.length());}
+
+	/// \brief Assigns the names added since the last build their slots
+	void build() {if (m_dirty) rebuild();}
+
+	void clear(); ///< Removes all names
+
+private:
+	
+	/// \brief Hashes a name
+	static unsigned int hashName(const char* name, int length);
+
+	/// \brief Mixes a name hash with a bucket displacement
+	static unsigned int displace(unsigned int hash, unsigned int displacement);
+
+	/// \brief Assigns every name a slot
+	void rebuild();
+
+	std::vector<std::string> m_names; ///< Names in insertion order
+	std::vector<unsigned int> m_hashes; ///< Hash of each name
+	std::vector<int> m_values; ///< Value of each name
+	
+	std::vector<unsigned int> m_displacements; ///< Displacement of each bucket
+	std::vector<int> m_slots; ///< Index of the name in each slot, -1 if empty
+	
+	bool m_dirty; ///< True if names were added since the last rebuild
+};
+
+#endif
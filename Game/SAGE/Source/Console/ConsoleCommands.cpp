@@ -32,12 +32,15 @@
 
 #include "Console.h"
 #include "common/Renderer.h"
+#include "common/CommonStuff.h"
 #include "Game/gamebase.h"
 #include "Input/Input.h"
 #include "DerivedModels/AnimatedModel.h"
 #include "Terrain/Terrain.h"
 #include "Water/Water.h"
 #include "Objects/GameObjectManager.h"
+#include "common/BatchMathBenchmark.h"
+#include <stdio.h>
 
 
 bool consoleHelp (ParameterList* params,std::string* errorMessage)
@@ -176,6 +179,45 @@ bool consoleWaterReflection (ParameterList* params, std::string* errorMessage)
   return 1;
 }
 
+bool consoleExecute (ParameterList* params, std::string* errorMessage)
+{
+  // the script overwrites the parameters, so keep the name
+  std::string fileName = params->Strings[0];
+
+  double start = getPerformanceTime();
+  int numCommands = gConsole.executeScript(fileName);
+  double ms = getPerformanceTime() - start;
+
+  if (numCommands < 0)
+  {
+    *errorMessage = "Script '" + fileName + "' was not executed";
+    return 0;
+  }
+
+  char text[256];
+  sprintf_s(text, "Executed %d commands from '%s' in %.2f ms (%.0f commands/s)", 
+    numCommands, fileName.c_str(), ms, ms > 0.0 ? numCommands * 1000.0 / ms : 0.0);
+  gConsole.printLine(text);
+  
+  return 1;
+}
+
+bool consoleMathBenchmark (ParameterList* params, std::string* errorMessage)
+{
+  if (params->Ints[0] < 1)
+  {
+    *errorMessage = "Element count must be at least 1";
+    return 0;
+  }
+
+  std::vector<std::string> report;
+  BatchMathBenchmark::run(params->Ints[0], report);
+  for (unsigned int i = 0; i < report.size(); i++)
+    gConsole.printLine(report[i]);
+  
+  return 1;
+}
+
 /// Adds all the engine commands to the console.
 /// this function is called once in Console::initiate()
 void AddEngineConsoleCommands()
@@ -196,6 +238,8 @@ void AddEngineConsoleCommands()
   gConsole.addFunction("terraindistort", "b", consoleTerrainDistort);
   gConsole.addFunction("lod", "i", consoleTerrainLOD);
   gConsole.addFunction("reflection", "b", consoleWaterReflection);
+  gConsole.addFunction("exec", "s", consoleExecute);
+  gConsole.addFunction("mathbench", "i", consoleMathBenchmark);
 
 }
 
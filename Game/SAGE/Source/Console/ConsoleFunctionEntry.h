@@ -64,7 +64,7 @@ public:
 	/// \brief Returns a string in which each character represents a 
 	/// parameter type
 	/// \return String in which each character represents a parameter type
-	std::string getParameters() {return m_parameters;}
+	const std::string& getParameters() const {return m_parameters;}
 
 	/// \brief Calls the function pointer that was defined in the 
 	/// DefineFunction method		
@@ -48,6 +48,9 @@ are stored in this structure.  Once the structure is filled
 in, the custom function is called passing a pointer to this
 structure.  The custom function can then access each 
 parameter easily.
+
+The console keeps one ParameterList and refills it for every command,
+so the strings keep their memory from one command to the next.
 */
 struct ParameterList
 {
@@ -31,7 +31,7 @@
 /// \brief Code for the TextParser class.
 
 #include "TextParser.h"
-#include <queue>
+#include <string.h>
 #include "ParameterList.h"
 using namespace std;
 
@@ -40,57 +40,31 @@ using namespace std;
 // constructor
 TextParser::TextParser()
 {
-	m_tokens = NULL;
-	m_numTokens = 0;
-}
-
-// destructor
-TextParser::~TextParser()
-{
-	// deallocate token array
-	if (m_tokens)
-		delete []m_tokens;
-	m_tokens = NULL;
 	m_numTokens = 0;
+	m_typeList[0] = 0;
 }
 
 /// TextParser parse.
 /// parse() should be called before you start you try to do anything
 /// else with the TextParser.
-/// \param text Line of text that you want to parse
+/// \param text Characters that you want to parse.  They need not be
+/// zero terminated, but must outlive the tokens.
+/// \param length Number of characters in text
 /// \return true on success, if false is returned, a errorMessage 
 /// can is stored in public member variable errorMessage.
-bool TextParser::parse(std::string text)
+bool TextParser::parse(const char* text, int length)
 {
-	// delete previous m_tokens
-	if (m_tokens) 
-	{
-		delete []m_tokens;
-		m_tokens = NULL;
-	}
-
-	// create a queue so we can add m_tokens as we go
-	queue<MultiVariable> qTokens;
-
-	MultiVariable token; // used to push m_tokens on the queue
-
-	int strLength = (int)text.length();
-
-	const char* s = text.c_str();
+	// forget the previous tokens
+	m_numTokens = 0;
+	m_typeList[0] = 0;
 
-	if (text == "")
-	{
-		m_tokens = NULL;
-		m_numTokens = 0;
-		m_typeList = "";
-		return 1;
-	}
+	MultiVariable token; // used to add tokens as we go
 	
+	const char* s = text;
 
 	// parse the entire
-	bool done = false;
 	int index = 0;  //index into the string
-	while(!done)
+	while(index < length)
 	{		
 
 		// if a quote is found
@@ -103,25 +77,25 @@ bool TextParser::parse(std::string text)
 			int startIndex = index;
 			
 			// search for a a corresponding end quote or the end of the string
-			while (!(s[index] == '"' || index == strLength))
+			while (index < length && s[index] != '"')
 			 index++; 
 			
 
 			// if the end of file was found before and ending quote then
 			// return an error
-			if (index == strLength)
+			if (index == length)
 			{
 				errorMessage = "Open quote without ending quote";
 				return 0;
 			}
 
 			// now there is a string waiting between startIndex and index
-			// put it in a string
-			token.typeString = text.substr(startIndex,index - startIndex);
+			token.typeText = s + startIndex;
+			token.textLength = index - startIndex;
 			token.type = eDataTypeString;
 			
-			// push it on the stack
-			qTokens.push(token);
+			if (!addToken(token))
+				return 0;
 
 			//increment passed ending quote
 			index++;
@@ -144,32 +118,29 @@ bool TextParser::parse(std::string text)
 
 			
 			// search for a breaking character or the end of the string
-			while (!(s[index] == ')' || index == strLength))
+			while (index < length && s[index] != ')')
 			 index++; 
 
-			if (index == strLength)
+			if (index == length)
 			{
-				errorMessage = "Open quote without ending quote";
+				errorMessage = "Open parenthesis without closing parenthesis";
 				return 0;
 			}
 
-            // now there is a string waiting between startIndex and index
-			// put it in a string
-			string sToken = text.substr(startIndex,index - startIndex);
-
 			// parse the inside
 			TextParser tp;
-			tp.parse(sToken);
+			tp.parse(s + startIndex, index - startIndex);
 
 			// get the token from the string
 			if (!giveTokenFromTextParser(&tp, &token))
 			{
-				errorMessage = "Could not evaluate (" + sToken + ") to a type";
+				errorMessage = "Could not evaluate (" + 
+					string(s + startIndex, index - startIndex) + ") to a type";
 				return 0;
 			}
 			
-			// push it on the stack
-			qTokens.push(token);
+			if (!addToken(token))
+				return 0;
 
 			// skip ending parenthesis
 			index++;
@@ -186,98 +157,72 @@ bool TextParser::parse(std::string text)
 			int startIndex = index;
 			
 			// search for a breaking character or the end of the string
-			while (!(s[index] == ' ' || s[index] == ',' || index == strLength))
+			while (index < length && s[index] != ' ' && s[index] != ',')
 			 index++; 
 			
-            // now there is a string waiting between startIndex and index
-			// put it in a string
-			string sToken = text.substr(startIndex,index - startIndex);
+			// now there is a token waiting between startIndex and index
+			const char* sToken = s + startIndex;
+			int tokenLength = index - startIndex;
 
 		    // figure out what data type it is
-			if (giveInt(&token.typeInt,sToken))
+			if (giveInt(&token.typeInt,sToken,tokenLength))
 			{
 				token.type = eDataTypeInt;
 			}
-			else if (giveFloat(&token.typeFloat,sToken))
+			else if (giveFloat(&token.typeFloat,sToken,tokenLength))
 			{
 				token.type = eDataTypeFloat;
 			}
-			else if (giveBool(&token.typeBool,sToken))
+			else if (giveBool(&token.typeBool,sToken,tokenLength))
 			{
 				token.type = eDataTypeBool;
 			}
 			else // take it as a string
 			{
 				token.type = eDataTypeString;
-				token.typeString = sToken;
+				token.typeText = sToken;
+				token.textLength = tokenLength;
 				
 			}
 			
-			// push it on the stack
-			qTokens.push(token);		
+			if (!addToken(token))
+				return 0;
 		}
-
-
-		// leave at end of string
-		if (index >= strLength) done = true;
-	}
-
-	// delete previous token array
-	if (m_tokens) 
-		delete []m_tokens;
-
-	// get number of m_tokens in queue
-	m_numTokens = (int)qTokens.size();
-	
-	if (m_numTokens <=0)
-	{
-		m_tokens = NULL;
-		m_typeList = "";
-		m_numTokens = 0;
 	}
 
+	// everything worked return true
+	return true;
+}
 
-
-	// create a new array to hold m_tokens from the queue
-	m_tokens = new MultiVariable[m_numTokens];
-	
-	// reset the parameter array
-	m_typeList = "";
-
-	// loop through all the m_tokens
-	for (int a = 0; a < m_numTokens; a++)
+/// appends a token and its type. returns 0 if the token list is full
+bool TextParser::addToken(const MultiVariable& token)
+{
+	if (m_numTokens == MAX_PARAMETERS)
 	{
-		// save the token from the front of the queue
-		m_tokens[a] = qTokens.front();
-
-		// pop off the item we just saved
-		qTokens.pop();
-		
-		m_typeList += m_tokens[a].type;
-
-
+		errorMessage = "Too many parameters";
+		return 0;
 	}
 
-	
+	m_tokens[m_numTokens] = token;
+	m_typeList[m_numTokens] = (char)token.type;
+	m_numTokens++;
+	m_typeList[m_numTokens] = 0;
 
-	// everything worked return true
-	return true;
+	return 1;
 }
 
 /// returns a bool for a specified string. returns 0 on failure
-bool TextParser::giveBool(bool* result, std::string toConvert)
+bool TextParser::giveBool(bool* result, const char* s, int length)
  {
   
   // no pointer for return value?
   if (!result) 
 	  return 0;
 
-	const char* s = toConvert.c_str();
-	
-   if (_stricmp( s, "off" ) == 0) { (*result) = 0; return 1; }    
-   if (_stricmp( s, "on" ) == 0) { (*result) = 1; return 1; }
-   if (_stricmp( s, "false" ) == 0) { (*result) = 0; return 1; }    
-   if (_stricmp( s, "true" ) == 0) { (*result) = 1; return 1; }
+   if (length == 3 && _strnicmp( s, "off", 3 ) == 0) { (*result) = 0; return 1; }    
+   if (length == 2 && _strnicmp( s, "on", 2 ) == 0) { (*result) = 1; return 1; }
+   if (length == 5 && _strnicmp( s, "false", 5 ) == 0) { (*result) = 0; return 1; }    
+   if (length == 4 && _strnicmp( s, "true", 4 ) == 0) { (*result) = 1; return 1; }
 
 	 return 0;
  }
@@ -285,29 +230,29 @@ bool TextParser::giveBool(bool* result, std::string toConvert)
 
 
 /// returns an int for a specified string. returns 0 on failure
-bool TextParser::giveInt(int* result, std::string toConvert )
+bool TextParser::giveInt(int* result, const char* s, int length)
  {
 
   // no pointer for return value check
   if (!result) 
 	  return 0;
 
-  const char* s = toConvert.c_str();
-
   // make sure all the chars are numbers
-  for (int i = 0; s[i] != NULL; i++)
+  unsigned int value = 0;
+  for (int i = 0; i < length; i++)
   {
    if (i == 0 && s[0] == '-') continue; // the first char can be minus
    if ( s[i] > 57 || s[i] < 48) return 0 ;
+   value = value * 10 + (s[i] - 48);
   }  
 
-  (*result) = atoi(s);
+  (*result) = (length > 0 && s[0] == '-') ? -(int)value : (int)value;
 
   return 1;
  }
 
 ///< returns a float for a specified string. returns 0 on failure
-bool TextParser::giveFloat(float* result, std::string toConvert)
+bool TextParser::giveFloat(float* result, const char* s, int length)
 {
 
 
@@ -315,11 +260,11 @@ bool TextParser::giveFloat(float* result, std::string toConvert)
   if (!result) 
 	  return 0;
 
-  const char* s = toConvert.c_str();
-  
   int deccount = 0; // used to count decimals
+  double value = 0.0; // digits read so far, ignoring the decimal
+  double scale = 1.0; // power of ten to divide by for the digits after the decimal
   // make sure all the chars are numbers or decimal(only one )
-  for (int i = 0; s[i] != NULL; i++)
+  for (int i = 0; i < length; i++)
   {
 	// the negative is acceptable at the start
    if (i == 0 && s[0] == '-') continue; 
@@ -329,13 +274,17 @@ bool TextParser::giveFloat(float* result, std::string toConvert)
 
    // accept numbers
    if ((s[i] > 57 || s[i] < 48)) return 0;
+
+   value = value * 10.0 + (s[i] - 48);
+   if (deccount > 0) scale *= 10.0;
   }
 
   // there must be at least one decimal to signify it is a float
   if (deccount != 1) return 0;
 
-  // convert the string to a float
-  (*result) = float(atof(s));
+  // convert the digits to a float
+  value /= scale;
+  (*result) = float(s[0] == '-' ? -value : value);
 
   // return success
   return true;
@@ -345,7 +294,9 @@ bool TextParser::giveFloat(float* result, std::string toConvert)
 // Fills in the parameterList structure with the correct parameter information
 /// You must call the parse function before calling feedParameterList
 /// \param pList a pointer to the structure that the data info will be placed
-void TextParser::feedParameterList(ParameterList* pList)
+/// \note Strings are assigned into the existing strings of pList, so
+/// reusing one ParameterList reuses their memory.
+void TextParser::feedParameterList(ParameterList* pList) const
 {
 	// if the user didn't pass in an address to put information then leave
 	if (!pList) 
@@ -361,7 +312,7 @@ void TextParser::feedParameterList(ParameterList* pList)
 		{
 		case eDataTypeString:
 			{
-				pList->Strings[pList->numStrings] = m_tokens[a].typeString;
+				pList->Strings[pList->numStrings].assign(m_tokens[a].typeText, m_tokens[a].textLength);
 				pList->numStrings++;				
 			}break;
 		case eDataTypeFloat:
@@ -396,7 +347,7 @@ void TextParser::feedParameterList(ParameterList* pList)
 
 
 // this is called when a parenthesis must be evaluated
-bool TextParser::giveTokenFromTextParser(TextParser* tp, MultiVariable* token) // 
+bool TextParser::giveTokenFromTextParser(const TextParser* tp, MultiVariable* token) // 
 {
 	if (token == NULL || tp == NULL) 
 		return 0;
@@ -406,7 +357,7 @@ bool TextParser::giveTokenFromTextParser(TextParser* tp, MultiVariable* token) /
 	{
 
 		// if there are 3 floats then it is a vector
-		if (tp->getTypes() == "fff")
+		if (strcmp(tp->getTypes(), "fff") == 0)
 		{
 			// there are 3 floats
 			token->type = eDataTypeVector3;
@@ -419,8 +370,3 @@ bool TextParser::giveTokenFromTextParser(TextParser* tp, MultiVariable* token) /
 	
 	return false;
 }
-
-
-
-
-
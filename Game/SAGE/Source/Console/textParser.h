@@ -56,11 +56,13 @@ enum EDataType
 /// this structure is capable of holding all types of data.
 //
 /// The MultiVariable structure is an easy way to hold data
-/// of unknown types.
+/// of unknown types.  Strings are not copied; they point into the
+/// text that was parsed, so they are only valid as long as it is.
 struct MultiVariable
 {
 	EDataType type; ///< type of data that the multivariable is holding
-	std::string typeString; ///< if type is a string then this is filled in
+	const char* typeText; ///< if type is a string then this points to its first character
+	int textLength; ///< if type is a string then this is its length
 	Vector3 typeVector3; ///< if type is a vector3 then this is filled in
 	int typeInt; ///< if type is a integer then this is filled in
 	float typeFloat; ///< if type is a float then this is filled in
@@ -83,17 +85,24 @@ To use the text parser:\n
 Once the text is parsed, you can view the the results through public member 
 functions.
 
+The parser does not allocate memory, so one instance can be reused for
+any number of lines.  Tokens refer to the parsed text rather than
+copying it, so the text must stay alive until feedParameterList is
+called.
+
 */
 class TextParser
 {
 public:
 	//-------------------------------------------------------------------------
 	TextParser(); ///<Basic Constructor. Initiates variables to defaults
-	~TextParser(); ///<Basic Destructor. Deletes the tokens array
 
 
 	/// \brief Parses specified text into a list of types and values		
-	bool parse(std::string text); ///< parses the text and stores the results
+	bool parse(const std::string& text) {return parse(text.c_str(), (int)text.length());}
+
+	/// \brief Parses the specified characters into a list of types and values		
+	bool parse(const char* text, int length);
 
 	/// \brief If parse fails (returns 0) an error message will be in
 	/// this string message
@@ -101,34 +110,37 @@ public:
 
 	/// \brief Returns a string in which each character represents
 	/// a data type.  i.e. "sif" means string, int, float.
-	std::string getTypes() {return m_typeList;}
+	const char* getTypes() const {return m_typeList;}
 	
 	
 	/// \brief Fills in the ParameterList structure with the data
 	/// information obtained from the parse.	
-	void feedParameterList(ParameterList* pList); 
+	void feedParameterList(ParameterList* pList) const; 
 
 	
 private:
 	//-------------------------------------------------------------------------
 	
 	/// \brief Used to evaluate parenthesis
-	bool giveTokenFromTextParser(TextParser* tp, MultiVariable* token);
+	bool giveTokenFromTextParser(const TextParser* tp, MultiVariable* token);
+
+	/// \brief Adds a token, returns 0 if there are too many
+	bool addToken(const MultiVariable& token);
 
 	/// \brief Returns a float for a specified string, returns 0 on failure
-	bool giveFloat(float* result, std::string);
+	static bool giveFloat(float* result, const char* s, int length);
 	
 	/// \brief Returns an integer for a specified string, returns 0 on failure
-	bool giveInt(int* result, std::string); 
+	static bool giveInt(int* result, const char* s, int length); 
 
 	/// \brief Returns a boolean for a specified string, returns 0 on failure
-	bool giveBool(bool* result, std::string); 
+	static bool giveBool(bool* result, const char* s, int length); 
 
-	MultiVariable* m_tokens; ///< Holds all the tokens after a parse
-	int m_numTokens; /// Size of tokens array
+	MultiVariable m_tokens[MAX_PARAMETERS]; ///< Holds all the tokens after a parse
+	int m_numTokens; ///< Number of tokens in m_tokens
 	
 	/// \brief Holds a string in which each character represents a data type.
-	std::string m_typeList; 
+	char m_typeList[MAX_PARAMETERS + 1]; 
 };
 
 
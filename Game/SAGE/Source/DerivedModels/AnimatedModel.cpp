@@ -14,12 +14,14 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "animatedmodel.h"
 #include "common/TriMesh.h"
 #include "common/EditTriMesh.h"
 #include "common/renderer.h"
 #include "common/CommonStuff.h"
+#include "common/BatchMath.h"
 
 bool AnimatedModel::m_bModelLerp = true; //true for linear interpolation of model frames
 
@@ -62,6 +64,12 @@ AnimatedModel::AnimatedModel(int framecount, int animationcount)
   }
   m_animation = 0;
   m_frame = 0.0f;
+
+  m_framePositions = NULL;
+  m_frameNormals = NULL;
+  m_frameBoxes = NULL;
+  m_stagingVertices = NULL;
+  m_nSharedFrameSteps = 8;
 }
 
 AnimatedModel::~AnimatedModel(){
@@ -76,6 +84,13 @@ AnimatedModel::~AnimatedModel(){
   for(int i=0; i<m_nNumAnimations; i++)
     delete [] m_nAnimationFrame[i];
   delete[] m_nAnimationFrame;
+
+  //delete frame data
+  delete [] m_framePositions;
+  delete [] m_frameNormals;
+  delete [] m_frameBoxes;
+  delete [] m_stagingVertices;
+  freeSharedFrames();
   
 }
 
@@ -219,6 +234,8 @@ void AnimatedModel::importS3d(const std::list<const char *> &s3dFilenames, bool
   m_totalVertices = totalVc;
 
   m_indexBuffer->unlock();
+
+  buildFrameData();
 }
 
 /// \param vb Vertex buffer to be rendered.
@@ -233,6 +250,8 @@ void AnimatedModel::render(VertexBufferBase *vb) const
 void AnimatedModel::setAnimationSequence(int seqno, int length, int* sequence){
   if( seqno < 0 || seqno >= m_nNumAnimations ) return; //bail if wrong sequence number
   
+  freeSharedFrames(); //shared frames are laid out by sequence
+  
   //create space for animation sequence
   m_nAnimationFrameCount[seqno] = length; //record length
   m_nAnimationFrame[seqno] = new int[length]; //create space for sequence
@@ -245,6 +264,8 @@ void AnimatedModel::setAnimationSequence(int seqno, int length, int* sequence){
 void AnimatedModel::setAnimationSequence(int seqno, const std::list<int> &sequence){
   if(seqno < 0 || seqno >= m_nNumAnimations) return; // bail if bad sequence number
   
+  freeSharedFrames(); //shared frames are laid out by sequence
+
   int length = (int)sequence.size();
   m_nAnimationFrameCount[seqno] = length; //record length;
   m_nAnimationFrame[seqno] = new int[length];
@@ -281,58 +302,216 @@ void AnimatedModel::selectAnimationFrame(float frame, int animation, StandardVer
 /// \param world If non-NULL, specifies the world (or other parent) transform of the model.
 void AnimatedModel::selectAnimationFrame(float frame, int animation, StandardVertexBuffer &vb, AABB3 *boundingBox, const Matrix4x3 *world)
 {
+  if(animation < 0) animation = 0;
+  if(animation >= m_nNumAnimations) animation = m_nNumAnimations-1;
+
+  if (!m_bModelLerp) frame = (float) ((int)frame); //cancel out lerping
+
+  int prevFrame, nextFrame; //keyframes on either side
+  float fraction; //fraction between frames
+  findKeyframes(frame, animation, prevFrame, nextFrame, fraction);
+
+  fillVertexBuffer(prevFrame, nextFrame, fraction, vb);
+
   if(boundingBox != NULL)
   {
     assert(world != NULL);
-    boundingBox->empty();
-  }    
+    computeFrameBox(prevFrame, nextFrame, fraction, *boundingBox, *world);
+  }
 
-  //set vertex positions and normals from model frames, lerping if necessary
+  m_animation = animation;
+  m_frame = frame;
+}
 
+/// The frame is rounded down to a multiple of 1/steps of a keyframe, where steps
+/// is set by setSharedFrameSteps().  Each rounded frame has one static vertex
+/// buffer, which is filled the first time the frame is selected and then
+/// returned to every object that selects the same frame.
+/// \param frame Specifies the frame number as a fractional value for interpolation.
+/// \param animation Specifies the animation sequence to be run.
+/// \param boundingBox Specifies the bounding box to be updated.
+/// \param world Specifies the world (or other parent) transform of the model.
+/// \return The vertex buffer holding the frame.  The model owns it.
+StandardVertexBuffer *AnimatedModel::selectSharedAnimationFrame(float frame, int animation, AABB3 &boundingBox, const Matrix4x3 &world)
+{
   if(animation < 0) animation = 0;
   if(animation >= m_nNumAnimations) animation = m_nNumAnimations-1;
 
-  if (!m_bModelLerp) frame = (float) ((int)frame); //cancel out lerping
+  //lay out the shared frames of every animation
 
-  int prevFrameIndex = (int)frame; //integer part of previous frame index
-  float fraction = frame - (float)prevFrameIndex; //fraction between frames
-  int prevFrame = m_nAnimationFrame[animation][ prevFrameIndex % m_nAnimationFrameCount[animation]]; //previous frame
-  int nextFrame = m_nAnimationFrame[animation][
-    ( prevFrameIndex + 1 ) % m_nAnimationFrameCount[animation]]; //next frame 
+  if(m_sharedFrames.empty())
+  {
+    m_sharedFrameOffsets.resize(m_nNumAnimations);
+    int total = 0;
+    for(int i=0; i<m_nNumAnimations; i++)
+    {
+      m_sharedFrameOffsets[i] = total;
+      total += m_nAnimationFrameCount[i] * m_nSharedFrameSteps;
+    }
+    m_sharedFrames.resize(total, NULL);
+  }
 
-  if(!vb.lock())
-    ABORT("AnimatedModel failed to lock vertex buffer");
+  //round the frame down to a shared one
+
+  int steps = m_nAnimationFrameCount[animation] * m_nSharedFrameSteps; //shared frames in animation
+  int step = m_bModelLerp ? (int)(frame * m_nSharedFrameSteps) : (int)frame * m_nSharedFrameSteps;
+  step %= steps;
+  if(step < 0) step += steps;
+  frame = (float)step / (float)m_nSharedFrameSteps;
+
+  int prevFrame, nextFrame; //keyframes on either side
+  float fraction; //fraction between frames
+  findKeyframes(frame, animation, prevFrame, nextFrame, fraction);
+
+  StandardVertexBuffer *&vb = m_sharedFrames[m_sharedFrameOffsets[animation] + step];
+  if(vb == NULL)
+    vb = new StandardVertexBuffer(m_totalVertices);
+  if(vb->isEmpty())
+    fillVertexBuffer(prevFrame, nextFrame, fraction, *vb);
+
+  computeFrameBox(prevFrame, nextFrame, fraction, boundingBox, world);
+
+  m_animation = animation;
+  m_frame = frame;
+  return vb;
+}
+
+/// Changing the number of steps discards the shared vertex buffers.
+/// \param steps Specifies the number of shared frames from one keyframe to the next.
+void AnimatedModel::setSharedFrameSteps(int steps)
+{
+  if(steps < 1) steps = 1;
+  if(steps == m_nSharedFrameSteps) return;
+  freeSharedFrames();
+  m_nSharedFrameSteps = steps;
+}
+
+/// Stores the positions and normals of each frame in their own arrays, so that
+/// they can be interpolated in batches, and bounds each frame.  Also sets up the
+/// staging vertices, whose texture coordinates never change.
+void AnimatedModel::buildFrameData()
+{
+  delete [] m_framePositions;
+  delete [] m_frameNormals;
+  delete [] m_frameBoxes;
+  delete [] m_stagingVertices;
+
+  int n = m_totalVertices;
+  m_framePositions = new Vector3[m_nFrameCount * n];
+  m_frameNormals = new Vector3[m_nFrameCount * n];
+  m_frameBoxes = new AABB3[m_nFrameCount];
+  m_stagingVertices = new RenderVertex[n];
+
+  for(int f = 0; f < m_nFrameCount; f++){ //for each frame
+    Vector3 *p = m_framePositions + f * n;
+    Vector3 *nrm = m_frameNormals + f * n;
+    int totalVc = 0;
+
+    for(int i = 0; i < m_partCount; i++){ //for each part
+      int vc = m_partMeshList[i].getVertexCount(); //vertex count
+      RenderVertex *srcV = m_pModelArray[f]->m_partMeshList[i].getVertexList(); //source
+
+      for(int j=0; j<vc; j++){ //for each vertex
+        p[totalVc + j] = srcV[j].p;
+        nrm[totalVc + j] = srcV[j].n;
+      }
+      totalVc += vc;
+    }
+
+    m_frameBoxes[f].empty();
+    BatchMath::bound(p, sizeof(Vector3), n, m_frameBoxes[f]);
+  }
+
+  //texture coordinates come from the first frame
 
   int totalVc = 0;
-  
-  for(int i = 0; i < m_partCount; i++){ //for each part, do a deep copy of trimesh
-    
+  for(int i = 0; i < m_partCount; i++){ //for each part
     int vc = m_partMeshList[i].getVertexCount(); //vertex count
-  
-    RenderVertex *srcV1 = m_pModelArray[prevFrame]->m_partMeshList[i].getVertexList(); //source 1
-    RenderVertex *srcV2 = m_pModelArray[nextFrame]->m_partMeshList[i].getVertexList(); //source 2
-
-     //compute weighted average of vertex positions
-    for(int j=0; j<vc; j++)
-    { //for each vertex
-      Vector3 pos = (1.0f - fraction) * srcV1[j].p + fraction * srcV2[j].p;
-      vb[j+totalVc].p = pos;
-      vb[j+totalVc].n = (1.0f - fraction) * srcV1[j].n + fraction * srcV2[j].n;
-      vb[j+totalVc].u = srcV1[j].u;
-      vb[j+totalVc].v = srcV1[j].v;
-      
-      // Update bounding box
-      
-      if(boundingBox != NULL)
-        boundingBox->add(pos * (*world));
-    }
+    memcpy(m_stagingVertices + totalVc, m_partMeshList[i].getVertexList(), vc * sizeof(RenderVertex));
     totalVc += vc;
   }
 
+  freeSharedFrames();
+}
+
+/// \param frame Specifies the frame number as a fractional value for interpolation.
+/// \param animation Specifies the animation sequence, which must be valid.
+/// \param prevFrame Receives the model frame at or before the frame.
+/// \param nextFrame Receives the model frame after the frame.
+/// \param fraction Receives the fraction of the way from prevFrame to nextFrame.
+void AnimatedModel::findKeyframes(float frame, int animation, int &prevFrame, int &nextFrame, float &fraction) const
+{
+  int prevFrameIndex = (int)frame; //integer part of previous frame index
+  fraction = frame - (float)prevFrameIndex; //fraction between frames
+  prevFrame = m_nAnimationFrame[animation][ prevFrameIndex % m_nAnimationFrameCount[animation]]; //previous frame
+  nextFrame = m_nAnimationFrame[animation][
+    ( prevFrameIndex + 1 ) % m_nAnimationFrameCount[animation]]; //next frame 
+}
+
+/// The blend goes into the staging vertices, whose texture coordinates are
+/// already set, and is then copied into the buffer in one pass.  A dynamic
+/// buffer is locked with D3DLOCK_DISCARD, so it must be written in full.
+/// \param prevFrame Specifies the model frame to blend from.
+/// \param nextFrame Specifies the model frame to blend to.
+/// \param fraction Specifies the fraction of the way from prevFrame to nextFrame.
+/// \param vb Specifies the vertex buffer to be filled with interpolated data.
+void AnimatedModel::fillVertexBuffer(int prevFrame, int nextFrame, float fraction, StandardVertexBuffer &vb)
+{
+  int n = m_totalVertices;
+  if(n <= 0) return;
+
+  //compute weighted average of vertex positions and normals
+
+  BatchMath::lerp(m_framePositions + prevFrame * n, sizeof(Vector3),
+    m_framePositions + nextFrame * n, sizeof(Vector3),
+    &m_stagingVertices[0].p, sizeof(RenderVertex), n, fraction);
+  BatchMath::lerp(m_frameNormals + prevFrame * n, sizeof(Vector3),
+    m_frameNormals + nextFrame * n, sizeof(Vector3),
+    &m_stagingVertices[0].n, sizeof(RenderVertex), n, fraction);
+
+  if(!vb.lock())
+    ABORT("AnimatedModel failed to lock vertex buffer");
+
+  memcpy(&vb[0], m_stagingVertices, n * sizeof(RenderVertex));
+
   vb.unlock();
+}
 
-  m_animation = animation;
-  m_frame = frame;
+/// Every blended vertex lies between the same blend of the two frames' boxes,
+/// so blending the boxes bounds the blended frame without visiting a vertex.
+/// \param prevFrame Specifies the model frame to blend from.
+/// \param nextFrame Specifies the model frame to blend to.
+/// \param fraction Specifies the fraction of the way from prevFrame to nextFrame.
+/// \param boundingBox Specifies the bounding box to be updated.
+/// \param world Specifies the world (or other parent) transform of the model.
+void AnimatedModel::computeFrameBox(int prevFrame, int nextFrame, float fraction, AABB3 &boundingBox, const Matrix4x3 &world) const
+{
+  if(m_frameBoxes == NULL)
+  {
+    boundingBox.empty();
+    return;
+  }
+
+  const AABB3 &a = m_frameBoxes[prevFrame];
+  const AABB3 &b = m_frameBoxes[nextFrame];
+  if(a.isEmpty() || b.isEmpty())
+  {
+    boundingBox.empty();
+    return;
+  }
+
+  AABB3 box;
+  box.min = (1.0f - fraction) * a.min + fraction * b.min;
+  box.max = (1.0f - fraction) * a.max + fraction * b.max;
+  boundingBox.setToTransformedBox(box, world);
+}
+
+void AnimatedModel::freeSharedFrames()
+{
+  for(int i = 0; i < (int)m_sharedFrames.size(); i++)
+    delete m_sharedFrames[i];
+  m_sharedFrames.clear();
+  m_sharedFrameOffsets.clear();
 }
 
 /// \return The number of frames in the current animation.  
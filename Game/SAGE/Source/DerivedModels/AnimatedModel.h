@@ -14,6 +14,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "graphics/VertexTypes.h"
 #include "common/model.h"
 #include "common/vector3.h"
@@ -26,6 +27,17 @@ class TriMesh;
 /// This class consists of a model that can contain multiple frames of animation.
 /// It assumes that each frame is read in as a separate model, with the same
 /// vertex count, triangle count, and texture for each frame.
+///
+/// The frames are kept as separate arrays of positions and normals, with a
+/// bounding box for each, so that interpolating is a pair of batch lerps.
+/// Positions and normals stay packed as Vector3 rather than being split into
+/// x, y and z arrays: the blend is written straight into interleaved
+/// RenderVertex data for the vertex buffer, and BatchMath::lerp blends a whole
+/// Vector3 in one SSE register, so split arrays would only add a pass
+/// gathering the components back into vertices.
+/// Objects that do not need their own vertex buffer can share one with every
+/// other object showing the same animation frame, rounded to a fraction of a
+/// keyframe; see selectSharedAnimationFrame().
 
 class AnimatedModel : public Model {
 
@@ -59,6 +71,12 @@ public:
   /// \brief Select the current animation sequence and frame, updating a supplied vertex buffer and bounding box.
   void selectAnimationFrame(float frame, int animation, StandardVertexBuffer &vb, AABB3 &boundingBox, const Matrix4x3 &world);
 
+  /// \brief Select an animation sequence and frame from a vertex buffer shared with other objects.
+  StandardVertexBuffer *selectSharedAnimationFrame(float frame, int animation, AABB3 &boundingBox, const Matrix4x3 &world);
+
+  /// \brief Sets how many shared frames there are from one keyframe to the next.
+  void setSharedFrameSteps(int steps);
+
   /// \brief Queries the model for the number of frames in the current animation.
   int numFramesInAnimation() const;
 
@@ -69,6 +87,12 @@ private:
   /// \brief Utility function.
   void selectAnimationFrame(float frame, int animation, StandardVertexBuffer &vb, AABB3 *boundingBox, const Matrix4x3 *world);
 
+  void buildFrameData(); ///< Copies the vertices of every frame into the frame arrays.
+  void findKeyframes(float frame, int animation, int &prevFrame, int &nextFrame, float &fraction) const; ///< Finds the keyframes on either side of a frame.
+  void fillVertexBuffer(int prevFrame, int nextFrame, float fraction, StandardVertexBuffer &vb); ///< Fills a vertex buffer with a blend of two keyframes.
+  void computeFrameBox(int prevFrame, int nextFrame, float fraction, AABB3 &boundingBox, const Matrix4x3 &world) const; ///< Bounds a blend of two keyframes.
+  void freeSharedFrames(); ///< Deletes the shared vertex buffers.
+
   Model** m_pModelArray; ///< Array of pointers to models for frames.
   int m_nNumAnimations; ///< Number of animations.
   int** m_nAnimationFrame; ///< Animation frames for each behaviour.
@@ -76,4 +100,12 @@ private:
   int m_animation;  ///< Specifies currently selected animation sequence.
   float m_frame; ///< Specifies current animation frame.
 
+  Vector3 *m_framePositions; ///< Vertex positions of every frame, m_totalVertices per frame.
+  Vector3 *m_frameNormals; ///< Vertex normals of every frame, m_totalVertices per frame.
+  AABB3 *m_frameBoxes; ///< Bounding box of every frame, in model space.
+  RenderVertex *m_stagingVertices; ///< Interpolated vertices; texture coordinates are set once on import.
+  int m_nSharedFrameSteps; ///< Number of shared frames from one keyframe to the next.
+  std::vector<StandardVertexBuffer*> m_sharedFrames; ///< Shared vertex buffers, created when first selected.
+  std::vector<int> m_sharedFrameOffsets; ///< Index in m_sharedFrames of the first frame of each animation.
+
 };
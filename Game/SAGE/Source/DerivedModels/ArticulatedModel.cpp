@@ -127,12 +127,14 @@ AABB3 ArticulatedModel::getSubmodelBoundingBox(int submodel) const
 
 /// \param submodel Specifies the submodel whose bounding box is to be fetched.
 /// \param m Specifies the transformation matrix representing the submodel in world space.
-AABB3 ArticulatedModel::getSubmodelBoundingBox(int submodel, const Matrix4x3 &m) const
+/// \param exact Specifies whether to compute the smallest box, or a quicker
+/// box made from the parts' local bounding boxes.
+AABB3 ArticulatedModel::getSubmodelBoundingBox(int submodel, const Matrix4x3 &m, bool exact) const
 {
   assert(submodel < m_nSubmodelCount);
   AABB3 bb;
   bb.empty();
   for(int i = 0; i < m_nNextSubmodelPart[submodel]; ++i)
-    bb.add(m_partMeshList[m_nSubmodelPart[submodel][i]].getBoundingBox(m));
+    bb.add(m_partMeshList[m_nSubmodelPart[submodel][i]].getBoundingBox(m, exact));
   return bb;
 }
\ No newline at end of file
@@ -56,5 +56,5 @@ public:
   void moveSubmodel(int nSubmodel,const Vector3 &v);
 
   AABB3 getSubmodelBoundingBox(int submodel) const;  ///< Return the bounding box of a submodel.
-  AABB3 getSubmodelBoundingBox(int submodel, const Matrix4x3 &m) const;  ///< Return the bounding box of a submodel given a world transformation.
+  AABB3 getSubmodelBoundingBox(int submodel, const Matrix4x3 &m, bool exact = true) const;  ///< Return the bounding box of a submodel given a world transformation.
 };
@@ -30,58 +30,68 @@
 /// \file IDGenerator.cpp
 /// \brief Code for the IDGenerator class.
 
+#include <assert.h>
 #include "IDGenerator.h"
 
 IDGenerator::IDGenerator()
-    : m_idCounter(0), m_hasCounterWrapped(false)
 {}
 
 /// \return A new ID
 /// \remark The new ID is guaranteed to not have been generated without
-///    a subsequent, corresponding release; furthermore, it is guaranteed
-///    to not be generated again until released.  When the caller is finished
-///    with an ID, the caller should release it.
-/// \warning Theoretically, this function will lock up if all possible IDs
-///    are allocated at once without a release.  This is unlikely, as the
-///    number of IDs that can be generated in a 32-bit environment is over
-///    four billion.  Also, theoretically, generation no longer happens in
-///    constant time after every ID has been generated once.
+///    a subsequent, corresponding release.  Its slot may have been used
+///    before, but then with another generation, so the ID differs from every
+///    ID of that slot handed out in the last 2^(32-INDEX_BITS) uses.
+///    When the caller is finished with an ID, the caller should release it.
 unsigned int IDGenerator::generateID()
 {
-  unsigned int oldID = m_idCounter++;
-
-  // Check if this wraps the ID counter around the range of an unsigned int  
-  if(m_idCounter < oldID)
+  unsigned int slot;
+  if(!m_freeSlots.empty())
   {
-    m_idCounter = 1;
-    m_hasCounterWrapped = true;
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+
+    // next generation of the same slot
+    m_slots[slot] += INDEX_MASK + 1;
   }
-  if(!m_hasCounterWrapped)
+  else
   {
-    m_ids.insert(m_idCounter);
-    return m_idCounter;
+    if(m_slots.empty())
+    {
+      m_slots.push_back(0); // slot 0 is never handed out, so no ID is NULLID
+      m_allocated.push_back(false);
+    }
+    slot = (unsigned int)m_slots.size();
+    assert(slot <= INDEX_MASK);
+    m_slots.push_back(slot);
+    m_allocated.push_back(false);
   }
-
-  // Counter has wrapped; must check for duplicate IDs
-  // Only happens in the greatest of games....
-  // ASSUME:  No game has every single possible object ID at once
-
-  while(m_ids.find(m_idCounter) != m_ids.end())
-    ++m_idCounter;
-  m_ids.insert(m_idCounter);
-  return m_idCounter;
+  m_allocated[slot] = true;
+  return m_slots[slot];
 }
 
 /// \param id Specifies the ID to be released.
-/// \remark If id hasn't been generated, does nothing.
+/// \remark If id isn't allocated, including if it was released already, does nothing.
 void IDGenerator::releaseID(unsigned int id)
 {
-  m_ids.erase(id);
+  if(!isValid(id))
+    return;
+  unsigned int slot = getIndex(id);
+  m_allocated[slot] = false;
+  m_freeSlots.push_back(slot);
+}
+
+/// \param id Specifies the ID.
+/// \return True iff the ID has been generated and not released since.
+bool IDGenerator::isValid(unsigned int id) const
+{
+  unsigned int slot = getIndex(id);
+  return slot != 0 && slot < m_slots.size() && m_allocated[slot] && m_slots[slot] == id;
 }
 
+/// Slots keep their generations, so IDs handed out before the clear stay invalid.
 void IDGenerator::clear()
 {
-  m_ids.clear();
-  m_idCounter = 0;
-  m_hasCounterWrapped = false;
+  for(unsigned int slot = 1; slot < m_slots.size(); ++slot)
+    if(m_allocated[slot])
+      releaseID(m_slots[slot]);
 }
@@ -33,14 +33,17 @@
 #ifndef __IDGENERATOR_H_INCLUDED__
 #define __IDGENERATOR_H_INCLUDED__
 
-#include <hash_set>
+#include <vector>
 
 /// \brief Generates unique ids in the form of unsigned ints.  Useful for resource factories/managers.
+///
+/// An ID packs a slot index in its low INDEX_BITS bits and the slot's generation in
+/// the bits above.  Released slots go on a free list and are handed out again with
+/// the next generation, so IDs stay small enough to index arrays with getIndex(),
+/// while an ID kept after its release no longer passes isValid().
 class IDGenerator
 {
 public:
-  // Nested types
-  
   // Constructers/destructor
   
   IDGenerator();  ///< Constructs a fresh generator.
@@ -50,15 +53,20 @@ public:
   unsigned int generateID(); ///< Generates a new ID.
   void releaseID(unsigned int id);  ///< Releases an ID.
   void clear(); /// Clears the set of allocated IDs.
+  bool isValid(unsigned int id) const; ///< Queries whether an ID is allocated.
+
+  /// \brief Queries the slot index of an ID, for indexing arrays.
+  /// \param id Specifies the ID.
+  /// \return The slot index, less than 2^INDEX_BITS.  Zero only for NULLID.
+  static unsigned int getIndex(unsigned int id) { return id & INDEX_MASK; }
   
   const static unsigned int NULLID = 0; ///< Represents an invalid or nonexistent ID.
+  const static unsigned int INDEX_BITS = 20; ///< Number of low bits holding the slot index.
+  const static unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1; ///< Selects the slot index of an ID.
 private:
-  
-  typedef stdext::hash_set<unsigned int> IDSet; ///< Represenets a set of IDs.
-  
-  unsigned int m_idCounter;  ///< Holds last allocated ID. 
-  bool m_hasCounterWrapped;  ///< Holds true iff ID counter has wrapped around the range of IDs (not likely).
-  IDSet m_ids;               ///< Holds the set of allocated IDs.
+  std::vector<unsigned int> m_slots;   ///< Holds the current ID of each slot, allocated or last released.
+  std::vector<bool> m_allocated;       ///< Holds whether each slot is allocated.
+  std::vector<unsigned int> m_freeSlots; ///< Holds released slots waiting for reuse.
 };
 
 #endif
@@ -30,20 +30,29 @@
 /// \file NameGenerator.cpp
 /// \brief Code for the NameGenerator class.
 
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include "NameGenerator.h"
 
+NameGenerator::NameGenerator() :
+  m_liveCount(0),
+  m_freeChars(0)
+{
+}
+
 /// Requests a specific name from the name generator.  If the name is not
 /// already allocated, the name will be considered generated.  When the
 /// caller is finished with the name, the caller should release it.
 /// \param name Specifies the requested name.
-/// \return True iff the name request was granted.
-bool NameGenerator::requestName(const std::string &name)
+/// \return The symbol of the name iff the name request was granted, NOSYMBOL otherwise.
+NameGenerator::Symbol NameGenerator::requestName(const std::string &name)
 {
-  if(names.find(name) != names.end())
-    return false;
-  names.insert(name);
-  return true;
+  Symbol symbol = intern(name.c_str(), (unsigned int)name.length());
+  if(m_entries[symbol - 1].allocated)
+    return NOSYMBOL;
+  allocate(symbol);
+  return symbol;
 }
 
 /// Generates a name given a base name.  The generated name is a concatenation
@@ -53,45 +62,267 @@ bool NameGenerator::requestName(const std::string &name)
 /// is already allocated).  When the caller is finished with the name,
 /// the caller should release it.
 /// \param baseName Specifies the base name.
-/// \return A reference to the generated name.  If you want to keep the name
-///     after clearing or discarding the set, be sure to store it in a string
-/// rather than a reference-to-string.
-const std::string &NameGenerator::generateName(const std::string &baseName)
-{
-  unsigned int counter = 0;
-
-  // Get existing counter if this class has one
-  CounterMapIter it = counters.find(baseName);
-  if(it != counters.end())
-    counter = it->second;
-  
-  // Generate names of the form (baseName + (string)counter)
-  // until a unique one is found
-  char buffer[80]; // more than enough
-  std::string generatedName;
-  do
-  {
-    //SECURITY-UPDATE:2/3/07
-    //sprintf(buffer,"%u",++counter);
-	sprintf_s(buffer,sizeof(buffer),"%u",++counter);
-    generatedName = baseName + buffer;
-  } while (names.find(generatedName) != names.end());
-  
-  // Update counter and add name
-  counters[baseName] = counter;
-  std::pair<NameSetIter,bool> rv = names.insert(generatedName);
-  return *(rv.first);
+/// \return The symbol of the generated name.  Use getName() for its characters.
+NameGenerator::Symbol NameGenerator::generateName(const std::string &baseName)
+{
+  Symbol base = intern(baseName.c_str(), (unsigned int)baseName.length());
+
+  // The counter is at least every number already following the base name,
+  // so the next one is free
+  unsigned int length = (unsigned int)baseName.length();
+  m_scratch.resize(length + 16);
+  memcpy(&m_scratch[0], baseName.c_str(), length);
+  length += sprintf_s(&m_scratch[length], 16, "%u", m_entries[base - 1].counter + 1);
+
+  Symbol symbol = intern(&m_scratch[0], length);
+  assert(!m_entries[symbol - 1].allocated);
+  allocate(symbol);
+  return symbol;
 }
 
 /// \param name Specifies the name to be released.
 /// \note If the name wasn't allocated, this function has no effect.
 void NameGenerator::releaseName(const std::string &name)
 {
-  names.erase(name);
+  releaseName(findName(name));
+}
+
+/// \param symbol Specifies the name to be released.  The symbol must not be
+///     used afterwards, since it may be reused for another name.
+/// \note If the name wasn't allocated, this function has no effect.
+void NameGenerator::releaseName(Symbol symbol)
+{
+  if(symbol == NOSYMBOL || !m_entries[symbol - 1].allocated)
+    return;
+  m_entries[symbol - 1].allocated = false;
+  updateBases(symbol, false);
+  if(m_entries[symbol - 1].dependents == 0)
+    freeSymbol(symbol);
 }
 
 void NameGenerator::clear()
 {
-  names.clear();
-  counters.clear();
-}
\ No newline at end of file
+  m_chars.clear();
+  m_entries.clear();
+  m_table.clear();
+  m_freeSymbols.clear();
+  m_liveCount = 0;
+  m_freeChars = 0;
+}
+
+/// \param name Specifies the name.
+/// \return The symbol of the name if it is allocated, NOSYMBOL otherwise.
+NameGenerator::Symbol NameGenerator::findName(const std::string &name) const
+{
+  unsigned int length = (unsigned int)name.length();
+  Symbol symbol = lookup(name.c_str(), length, hashName(name.c_str(), length));
+  if(symbol == NOSYMBOL || !m_entries[symbol - 1].allocated)
+    return NOSYMBOL;
+  return symbol;
+}
+
+/// \param symbol Specifies the name.
+/// \return The zero-terminated name.  Allocating or releasing names may move
+///     it, so copy it rather than keeping the pointer.
+const char *NameGenerator::getName(Symbol symbol) const
+{
+  return &m_chars[m_entries[symbol - 1].offset];
+}
+
+/// FNV-1a.
+/// \param name Specifies the characters.
+/// \param length Specifies the number of characters.
+/// \return The hash.
+unsigned int NameGenerator::hashName(const char *name, unsigned int length)
+{
+  unsigned int hash = 2166136261u;
+  for(unsigned int i = 0; i < length; ++i)
+    hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+  return hash;
+}
+
+/// \param name Specifies the characters.
+/// \param length Specifies the number of characters.
+/// \param hash Specifies the hash of the characters.
+/// \return The symbol of the name, or NOSYMBOL if it was never interned.
+NameGenerator::Symbol NameGenerator::lookup(const char *name, unsigned int length, unsigned int hash) const
+{
+  if(m_table.empty())
+    return NOSYMBOL;
+
+  unsigned int mask = (unsigned int)m_table.size() - 1;
+  for(unsigned int i = hash & mask; m_table[i] != NOSYMBOL; i = (i + 1) & mask)
+  {
+    const Entry &entry = m_entries[m_table[i] - 1];
+    if(entry.hash == hash && entry.length == length &&
+       memcmp(&m_chars[entry.offset], name, length) == 0)
+      return m_table[i];
+  }
+  return NOSYMBOL;
+}
+
+/// \param name Specifies the characters.  Must not point into the arena.
+/// \param length Specifies the number of characters.
+/// \return The symbol of the name, interned now if it wasn't already.
+NameGenerator::Symbol NameGenerator::intern(const char *name, unsigned int length)
+{
+  unsigned int hash = hashName(name, length);
+  Symbol symbol = lookup(name, length, hash);
+  if(symbol != NOSYMBOL)
+    return symbol;
+
+  Entry entry;
+  entry.offset = (unsigned int)m_chars.size();
+  entry.length = length;
+  entry.hash = hash;
+  entry.counter = 0;
+  entry.value = 0;
+  entry.dependents = 0;
+  entry.allocated = false;
+  entry.interned = true;
+  m_chars.insert(m_chars.end(), name, name + length);
+  m_chars.push_back('\0');
+  if(m_freeSymbols.empty())
+  {
+    m_entries.push_back(entry);
+    symbol = (Symbol)m_entries.size();
+  }
+  else
+  {
+    symbol = m_freeSymbols.back();
+    m_freeSymbols.pop_back();
+    m_entries[symbol - 1] = entry;
+  }
+  ++m_liveCount;
+
+  // keep the table at most half full
+  if(m_liveCount * 2 > m_table.size())
+  {
+    m_table.assign(m_table.empty() ? 64 : m_table.size() * 2, (Symbol)NOSYMBOL);
+    for(Symbol s = 1; s <= (Symbol)m_entries.size(); ++s)
+      if(m_entries[s - 1].interned)
+        insertSymbol(s);
+  }
+  else
+    insertSymbol(symbol);
+
+  return symbol;
+}
+
+/// \param symbol Specifies a symbol that isn't in the table yet.
+void NameGenerator::insertSymbol(Symbol symbol)
+{
+  unsigned int mask = (unsigned int)m_table.size() - 1;
+  unsigned int i = m_entries[symbol - 1].hash & mask;
+  while(m_table[i] != NOSYMBOL)
+    i = (i + 1) & mask;
+  m_table[i] = symbol;
+}
+
+/// \param symbol Specifies a name that isn't allocated.
+void NameGenerator::allocate(Symbol symbol)
+{
+  m_entries[symbol - 1].allocated = true;
+  updateBases(symbol, true);
+}
+
+/// A name ending in a number is a numbered version of each prefix that leaves
+/// a number without a leading zero:  "Foo12" of "Foo" and of "Foo1".  When the
+/// name is allocated, those bases count it as a dependent and their counters
+/// are raised, "Foo" to 12 and "Foo1" to 2.  When it is released, the count
+/// goes back down and bases that are neither allocated nor depended on are
+/// freed.
+/// \param symbol Specifies the name.
+/// \param allocating Specifies true if the name is being allocated, false if released.
+void NameGenerator::updateBases(Symbol symbol, bool allocating)
+{
+  // copy the name out of the arena, since interning or freeing the bases may move it
+  unsigned int length = m_entries[symbol - 1].length;
+  m_scratch.assign(m_chars.begin() + m_entries[symbol - 1].offset,
+                   m_chars.begin() + m_entries[symbol - 1].offset + length);
+
+  unsigned int digits = length;
+  while(digits > 0 && m_scratch[digits - 1] >= '0' && m_scratch[digits - 1] <= '9')
+    --digits;
+
+  for(unsigned int split = digits; split < length; ++split)
+  {
+    // skip leading zeros and numbers too big for the counter
+    if(m_scratch[split] == '0' || length - split > 9)
+      continue;
+
+    if(allocating)
+    {
+      unsigned int number = 0;
+      for(unsigned int i = split; i < length; ++i)
+        number = number * 10 + (m_scratch[i] - '0');
+
+      Symbol base = intern(&m_scratch[0], split);
+      if(m_entries[base - 1].counter < number)
+        m_entries[base - 1].counter = number;
+      ++m_entries[base - 1].dependents;
+    }
+    else
+    {
+      Symbol base = lookup(&m_scratch[0], split, hashName(&m_scratch[0], split));
+      assert(base != NOSYMBOL);
+      if(--m_entries[base - 1].dependents == 0 && !m_entries[base - 1].allocated)
+        freeSymbol(base);
+    }
+  }
+}
+
+/// The characters stay in the arena until freed names make up most of it.
+/// \param symbol Specifies a name that is neither allocated nor depended on.
+void NameGenerator::freeSymbol(Symbol symbol)
+{
+  removeSymbol(symbol);
+  Entry &entry = m_entries[symbol - 1];
+  entry.interned = false;
+  m_freeChars += entry.length + 1;
+  m_freeSymbols.push_back(symbol);
+  --m_liveCount;
+
+  if(m_freeChars > 4096 && m_freeChars * 2 > m_chars.size())
+    compactChars();
+}
+
+/// Later symbols in the same run of the table are shifted back into the gap
+/// when their home slot allows it, so lookups never stop short of them.
+/// \param symbol Specifies a symbol that is in the table.
+void NameGenerator::removeSymbol(Symbol symbol)
+{
+  unsigned int mask = (unsigned int)m_table.size() - 1;
+  unsigned int hole = m_entries[symbol - 1].hash & mask;
+  while(m_table[hole] != symbol)
+    hole = (hole + 1) & mask;
+
+  for(unsigned int i = (hole + 1) & mask; m_table[i] != NOSYMBOL; i = (i + 1) & mask)
+  {
+    unsigned int home = m_entries[m_table[i] - 1].hash & mask;
+    if(((i - home) & mask) >= ((i - hole) & mask))
+    {
+      m_table[hole] = m_table[i];
+      hole = i;
+    }
+  }
+  m_table[hole] = NOSYMBOL;
+}
+
+void NameGenerator::compactChars()
+{
+  std::vector<char> chars;
+  chars.reserve(m_chars.size() - m_freeChars);
+  for(unsigned int i = 0; i < m_entries.size(); ++i)
+  {
+    Entry &entry = m_entries[i];
+    if(!entry.interned)
+      continue;
+    unsigned int offset = (unsigned int)chars.size();
+    chars.insert(chars.end(), m_chars.begin() + entry.offset,
+                 m_chars.begin() + entry.offset + entry.length + 1);
+    entry.offset = offset;
+  }
+  m_chars.swap(chars);
+  m_freeChars = 0;
+}
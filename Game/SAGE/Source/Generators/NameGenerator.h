@@ -33,32 +33,81 @@
 #ifndef __NAMEGENERATOR_H_INCLUDED__
 #define __NAMEGENERATOR_H_INCLUDED__
 
-#include <hash_map>
-#include <hash_set>
 #include <string>
+#include <vector>
 
 /// \brief Generates and tracks unique names (strings). These names can be
 /// requested and released according to the needs of the application.
+///
+/// Every name ever seen is interned: its characters are stored once in an
+/// arena and it is known by a 32-bit symbol, found through a flat
+/// open-addressing hash table, so a lookup hashes the name once and compares
+/// it once.  A name can carry a value, such as the ID of the object it
+/// names.
+///
+/// Each name also keeps a counter for use as a base name.  Whenever a name
+/// ending in a number is allocated, the counter of the part before the
+/// number is raised to at least that number, so generateName() can append
+/// the next count without checking whether the result is taken.
+///
+/// A name is freed once it has been released and no allocated name is a
+/// numbered version of it, so the generator only holds the names in use and
+/// their bases.  Its symbol may then be reused for another name, and a freed
+/// base starts counting from 1 again.
 class NameGenerator
 {
   public:
-    // Nested types
-    
-    bool requestName(const std::string &name);  ///< Requests a specific name from the generator.
-    const std::string &generateName(const std::string &baseName);  ///< Generates a name given a base name.
+    typedef unsigned int Symbol;  ///< Handle to an interned name.
+    static const Symbol NOSYMBOL = 0;  ///< Represents no name.
+
+    // Constructers/destructor
+
+    NameGenerator();  ///< Constructs an empty generator.
+
+    // Member functions
+
+    Symbol requestName(const std::string &name);  ///< Requests a specific name from the generator.
+    Symbol generateName(const std::string &baseName);  ///< Generates a name given a base name.
     void releaseName(const std::string &name);  ///< Releases a name, making it available for future requests.
+    void releaseName(Symbol symbol);  ///< Releases a name by its symbol.
     void clear();  ///< Clears the set of allocated names.
 
-    // Constructers/destructor
+    Symbol findName(const std::string &name) const;  ///< Finds an allocated name.
+    const char *getName(Symbol symbol) const;  ///< Gets the characters of a name.
+    unsigned int getValue(Symbol symbol) const { return m_entries[symbol - 1].value; }  ///< Gets the value stored with a name.
+    void setValue(Symbol symbol, unsigned int value) { m_entries[symbol - 1].value = value; }  ///< Stores a value with a name.
 
   private:
-    typedef stdext::hash_set<std::string> NameSet;  ///< Represents a set of names.
-    typedef NameSet::iterator NameSetIter;  ///< Set iterator.
-    typedef stdext::hash_map<std::string,unsigned int> CounterMap;  ///< Represents a mapping of base names to ID counters.
-    typedef CounterMap::iterator CounterMapIter;  ///< Map iterator.
-    
-    NameSet names;        ///< Holds the set of all allocated names.
-    CounterMap counters;  ///< Holds the mapping of all base names to their ID counters.
+    /// \brief Interned name.
+    struct Entry
+    {
+      unsigned int offset;   ///< Index of the first character in m_chars.
+      unsigned int length;   ///< Number of characters, not counting the terminator.
+      unsigned int hash;     ///< Hash of the characters.
+      unsigned int counter;  ///< Highest number following this name in an allocated name.
+      unsigned int value;    ///< Value stored by the user, zero by default.
+      unsigned int dependents;  ///< Number of allocated names that are numbered versions of this one.
+      bool allocated;        ///< True iff the name is currently handed out.
+      bool interned;         ///< False if the entry was freed and awaits reuse.
+    };
+
+    static unsigned int hashName(const char *name, unsigned int length);  ///< Hashes a name.
+    Symbol lookup(const char *name, unsigned int length, unsigned int hash) const;  ///< Finds an interned name.
+    Symbol intern(const char *name, unsigned int length);  ///< Finds or adds a name.
+    void insertSymbol(Symbol symbol);  ///< Adds a symbol to m_table.
+    void allocate(Symbol symbol);  ///< Marks a name as handed out and updates counters.
+    void updateBases(Symbol symbol, bool allocating);  ///< Updates the names that a name is a numbered version of.
+    void freeSymbol(Symbol symbol);  ///< Forgets a name and puts its symbol up for reuse.
+    void removeSymbol(Symbol symbol);  ///< Takes a symbol out of m_table.
+    void compactChars();  ///< Drops the characters of freed names from m_chars.
+
+    std::vector<char> m_chars;     ///< Arena holding the characters of all names, each followed by a zero.
+    std::vector<Entry> m_entries;  ///< Interned names; symbol s is m_entries[s-1].
+    std::vector<Symbol> m_freeSymbols;  ///< Symbols of freed entries, to be reused.
+    unsigned int m_liveCount;      ///< Number of interned names, not counting freed ones.
+    unsigned int m_freeChars;      ///< Characters in m_chars that belong to freed names.
+    std::vector<Symbol> m_table;   ///< Open-addressing hash table of symbols, zero when empty.  Size is a power of two.
+    std::vector<char> m_scratch;   ///< Buffer for building generated names.
 };
 
 #endif
@@ -38,11 +38,17 @@
 #include "common/Quaternion.h"
 #include "Common/Matrix4x3.h"
 #include "derivedmodels/animatedmodel.h"
+#include "Objects/GameObjectManager.h"
 #include <stdlib.h>
 #include <assert.h>
 #include <math.h>
 
 
+/// \return true iff the two orientations hold the same angles.
+static inline bool sameOrientation(const EulerAngles &a, const EulerAngles &b)
+{
+  return a.heading == b.heading && a.pitch == b.pitch && a.bank == b.bank;
+}
 
 /// \param m Specifies the model used by the object.
 /// \param parts Specifies the number of parts in the object.
@@ -57,27 +63,49 @@ GameObject::GameObject(Model *m, int parts, int frames):
   m_eaOrient(NULL),
   m_eaAngularVelocity(NULL),
   m_v3Position(NULL),
+  m_partMatrix(NULL),
+  m_partMatrixPosition(NULL),
+  m_partMatrixOrient(NULL),
+  m_modelOrientMatrixOrient(EulerAngles::kEulerAnglesIdentity),
+  m_bModelToWorldDirty(false),
   m_fSpeed(0.0f),
   m_animFreq(1.0f),
   m_lifeState(LS_NEW),
   m_id(0),
+  m_name(NameGenerator::NOSYMBOL),
   m_className("Object"),
   m_type(0),
   m_manager(NULL),
   m_vertexBuffer(NULL),
+  m_sharedVertexBuffer(NULL),
   m_fSpeedRight(0.0),
   m_fSpeedLeft(0.0),
   m_bBounded(false),
-  m_bAllRange(false)
+  m_bAnimationPending(false),
+  m_bExactBounds(true),
+  m_bSharedAnimation(false),
+  m_bAllRange(false),
+  colOb(NULL),
+  body(NULL)
 {
   m_eaOrient = new EulerAngles[m_nNumParts];
   m_eaAngularVelocity = new EulerAngles[m_nNumParts];
   m_v3Position = new Vector3[m_nNumParts];
+  m_partMatrix = new Matrix4x3[m_nNumParts];
+  m_partMatrixPosition = new Vector3[m_nNumParts];
+  m_partMatrixOrient = new EulerAngles[m_nNumParts];
   for(int i=0; i<m_nNumParts; i++){
     m_eaOrient[i] = EulerAngles::kEulerAnglesIdentity;
     m_eaAngularVelocity[i] = EulerAngles::kEulerAnglesIdentity;
     m_v3Position[i] = Vector3::kZeroVector;
+    m_partMatrix[i].identity();
+    m_partMatrixPosition[i] = Vector3::kZeroVector;
+    m_partMatrixOrient[i] = EulerAngles::kEulerAnglesIdentity;
   }
+  m_modelOrientMatrix.identity();
+  m_modelToWorld.identity();
+  for(int i = 0; i < GameObjectList::MAX_LISTS; ++i)
+    m_listSlots[i].group = -1;
 
   if(frames > 1)
     m_vertexBuffer = ((AnimatedModel*)m)->getNewVertexBuffer();
@@ -93,6 +121,9 @@ GameObject::~GameObject(void){
   delete [] m_eaOrient;
   delete [] m_eaAngularVelocity;
   delete [] m_v3Position;
+  delete [] m_partMatrix;
+  delete [] m_partMatrixPosition;
+  delete [] m_partMatrixOrient;
 
   delete m_vertexBuffer;
   delete trans;
@@ -110,6 +141,27 @@ void GameObject::setAllRange(bool range)
 void GameObject::setModel(Model *m)
 {
   m_pModel = m;
+  m_sharedVertexBuffer = NULL;
+}
+
+/// A shared object has no vertex buffer of its own.  It shows its animation
+/// rounded to a fraction of a keyframe, from a buffer the model fills once
+/// for every object on that frame, so a crowd of identical objects costs
+/// one interpolation per frame shown rather than one per object.
+/// \param shared Specifies whether the vertex buffer is shared.
+void GameObject::setSharedAnimation(bool shared)
+{
+  if(m_nNumFrames <= 1 || shared == m_bSharedAnimation)
+    return;
+  m_bSharedAnimation = shared;
+  m_sharedVertexBuffer = NULL;
+  if(shared)
+  {
+    delete m_vertexBuffer;
+    m_vertexBuffer = NULL;
+  }
+  else
+    m_vertexBuffer = ((AnimatedModel*)m_pModel)->getNewVertexBuffer();
 }
 
 /// \param v Specifies the new position for the object.
@@ -251,43 +303,152 @@ void GameObject::incrementSpeed(float speed){
 /// interial (world) space
 const Vector3 GameObject::transformObjectToInertial(const Vector3& position) const
 {
-  RotationMatrix rMat;
-  Vector3 ret;
-  rMat.setup(getOrientation());
+  return position * getObjectToWorldMatrix();
+}
 
-  ret = rMat.objectToInertial(position);
-  ret += getPosition();
+/// \param v Direction relative to the object to rotate to inertial 
+/// (world) space
+/// \return The direction passed in rotated from object space to 
+/// inertial (world) space
+const Vector3 GameObject::rotateObjectToInertial(const Vector3& v) const
+{
+  const Matrix4x3 &m = getObjectToWorldMatrix();
+  return Vector3(
+    v.x*m.m11 + v.y*m.m21 + v.z*m.m31,
+    v.x*m.m12 + v.y*m.m22 + v.z*m.m32,
+    v.x*m.m13 + v.y*m.m23 + v.z*m.m33);
+}
 
-  return ret;
+/// The matrix is cached, and rebuilt only when the position or orientation
+/// of part 0 has changed since it was last built.  A change of position
+/// alone only updates the translation.
+/// \return The local-to-world matrix of the object, without the model orientation.
+const Matrix4x3 &GameObject::getObjectToWorldMatrix() const
+{
+  if(updatePartMatrix(0))
+    m_bModelToWorldDirty = true;
+  return m_partMatrix[0];
 }
 
+/// This is the matrix the model is rendered with, and the one its bounding
+/// box is computed with.  Like getObjectToWorldMatrix(), it is cached.
+/// \return The model-to-world matrix of part 0.
+const Matrix4x3 &GameObject::getModelToWorldMatrix() const
+{
+  if(updatePartMatrix(0))
+    m_bModelToWorldDirty = true;
+  if(!sameOrientation(m_modelOrientMatrixOrient, m_modelOrient))
+  {
+    m_modelOrientMatrix.setupLocalToParent(Vector3::kZeroVector, m_modelOrient);
+    m_modelOrientMatrixOrient = m_modelOrient;
+    m_bModelToWorldDirty = true;
+  }
+  if(m_bModelToWorldDirty)
+  {
+    m_modelToWorld = m_modelOrientMatrix * m_partMatrix[0];
+    m_bModelToWorldDirty = false;
+  }
+  return m_modelToWorld;
+}
+
+/// \param part Specifies the part to be queried.
+/// \return For part 0, the object-to-world matrix.  For other parts, the
+/// local-to-parent matrix of the part, where the parent is the model space
+/// of part 0.
+const Matrix4x3 &GameObject::getPartMatrix(int part) const
+{
+  assert(part >= 0 && part < m_nNumParts);
+  if(part == 0)
+    return getObjectToWorldMatrix();
+  updatePartMatrix(part);
+  return m_partMatrix[part];
+}
+
+/// Position and orientation are compared with the values the matrix was built
+/// from, so derived classes may change m_v3Position and m_eaOrient directly.
+/// \param part Specifies the part whose matrix is to be updated.
+/// \return true iff the matrix changed.
+bool GameObject::updatePartMatrix(int part) const
+{
+  const Vector3 &pos = m_v3Position[part];
+  const EulerAngles &orient = m_eaOrient[part];
+  if(!sameOrientation(m_partMatrixOrient[part], orient))
+  {
+    m_partMatrix[part].setupLocalToParent(pos, orient);
+    m_partMatrixOrient[part] = orient;
+    m_partMatrixPosition[part] = pos;
+    return true;
+  }
+  if(m_partMatrixPosition[part] != pos)
+  {
+    m_partMatrix[part].setTranslation(pos);
+    m_partMatrixPosition[part] = pos;
+    return true;
+  }
+  return false;
+}
+
+/// The box comes from the model's precomputed convex hulls, or from its
+/// local part boxes if exact bounds are turned off, so the cost doesn't
+/// grow with the number of vertices.
 void GameObject::computeBoundingBox()
 {
   if(m_pModel == NULL) {
 	  return;
   }
   if(m_nNumFrames > 1) return;
-  Matrix4x3 world, modelOrient, sub;
-  world.setupLocalToParent(m_v3Position[0], m_eaOrient[0]);
-  modelOrient.setupLocalToParent(Vector3::kZeroVector, m_modelOrient);
-  world = modelOrient * world;
+  const Matrix4x3 &world = getModelToWorldMatrix();
   if(m_nNumParts > 1)
-    m_boundingBox = ((ArticulatedModel*)m_pModel)->getSubmodelBoundingBox(0,world);
+    m_boundingBox = ((ArticulatedModel*)m_pModel)->getSubmodelBoundingBox(0,world,m_bExactBounds);
   else
-    m_boundingBox = m_pModel->getBoundingBox(world);
+    m_boundingBox = m_pModel->getBoundingBox(world,m_bExactBounds);
   for(int i = 1; i < m_nNumParts; ++i)
   {
-    sub.setupLocalToParent(m_v3Position[i], m_eaOrient[i]);
-    m_boundingBox.add(((ArticulatedModel*)m_pModel)->getSubmodelBoundingBox(i,sub * world));
+    m_boundingBox.add(((ArticulatedModel*)m_pModel)->getSubmodelBoundingBox(i,getPartMatrix(i) * world,m_bExactBounds));
   }
 
   
 }
 
+/// Derived classes that add state should override this, call the base version
+/// and then reset their own members.  The model, class name, type and physics body
+/// are kept; the manager puts the body back into the world when the object is respawned.
+void GameObject::reset()
+{
+  for(int i=0; i<m_nNumParts; i++){
+    m_eaOrient[i] = EulerAngles::kEulerAnglesIdentity;
+    m_eaAngularVelocity[i] = EulerAngles::kEulerAnglesIdentity;
+    m_v3Position[i] = Vector3::kZeroVector;
+  }
+  m_fSpeed = 0.0f;
+  m_fSpeedLeft = 0.0f;
+  m_fSpeedRight = 0.0f;
+  m_fDeltaTime = 0.0f;
+  m_fCurFrame = 0.0f;
+  m_animFreq = 1.0f;
+  m_bAllRange = false;
+  m_bBounded = false;
+  m_bAnimationPending = false;
+  m_lifeState = LS_NEW;
+  m_id = 0;
+  m_name = NameGenerator::NOSYMBOL;
+  computeBoundingBox();
+}
+
 void GameObject::addBody(btRigidBody* b) {
 	body = b;
 }
 
+/// \return The object's name, or an empty string if it is unmanaged or anonymous.
+///     The characters belong to the manager and may move when objects are
+///     added or deleted, so copy them rather than keeping the pointer.
+const char *GameObject::getName() const
+{
+  if(m_manager == NULL)
+    return "";
+  return m_manager->getObjectName(*this);
+}
+
 /// \return The last computed bounding box of the object.
 const AABB3 &GameObject::getBoundingBox() const
 {
@@ -308,23 +469,25 @@ void GameObject::move(float dt)
 void GameObject::render(){
   if(!m_pModel)return;
 
-  gRenderer.instance(m_v3Position[0], m_eaOrient[0]);
-  gRenderer.instance(Vector3::kZeroVector, m_modelOrient);
+  gRenderer.instance(getModelToWorldMatrix());
   if(m_nNumParts > 1) //articulated model
     ((ArticulatedModel*)m_pModel)->renderSubmodel(0);
   else if(m_nNumFrames > 1) // animated model
-    ((AnimatedModel*)m_pModel)->render(m_vertexBuffer);
+  {
+    StandardVertexBuffer *vb = m_bSharedAnimation ? m_sharedVertexBuffer : m_vertexBuffer;
+    if(vb != NULL)
+      ((AnimatedModel*)m_pModel)->render(vb);
+  }
   else
     m_pModel->render(); //vanilla model
 
   for(int i=1; i<m_nNumParts; i++){
-    gRenderer.instance(m_v3Position[i], m_eaOrient[i]);
+    gRenderer.instance(getPartMatrix(i));
     ((ArticulatedModel*)m_pModel)->renderSubmodel(i);
     gRenderer.instancePop(); // submodel i
   }
 
-  gRenderer.instancePop(); // submodel 0
-  gRenderer.instancePop(); // object
+  gRenderer.instancePop(); // object and submodel 0
 }
 
 /// \param dt Specifies the amount of time since the last call to move, in seconds.
@@ -367,10 +530,7 @@ void GameObject::move(float dt, bool savePreviousState){
 	  }
   }
 
-  RotationMatrix Matrix;
-  Matrix.setup(m_eaOrient[0]);
-  Vector3 addend = Matrix.objectToInertial(bDisplacement);
-  m_v3Position[0] += Matrix.objectToInertial(bDisplacement);
+  m_v3Position[0] += rotateObjectToInertial(bDisplacement);
   /*
   Matrix4x3 Matrix;
   Quaternion q;
@@ -399,11 +559,25 @@ void GameObject::move(float dt, bool savePreviousState){
   if(m_nNumFrames > 1)
   {
     m_fCurFrame += dt * ((AnimatedModel*)m_pModel)->numFramesInAnimation() * m_animFreq;
-    Matrix4x3 world, modelOrient;
-    world.setupLocalToParent(m_v3Position[0], m_eaOrient[0]);
-    modelOrient.setupLocalToParent(Vector3::kZeroVector,m_modelOrient);
-    world = modelOrient * world;
-    ((AnimatedModel*)m_pModel)->selectAnimationFrame(m_fCurFrame, 0, *m_vertexBuffer, m_boundingBox, world); // TODO figure which frame to render based on state
-    world;
+    // Vertex buffers can only be locked from the main thread; the manager
+    // finishes the job after a parallel move phase.
+    if(m_manager != NULL && m_manager->isUpdatingInParallel())
+      m_bAnimationPending = true;
+    else
+      updateAnimation();
   }
 }
+
+/// Interpolates the model's current animation frame into the object's vertex buffer
+/// and updates the bounding box to match.  Must be called from the main thread.
+void GameObject::updateAnimation()
+{
+  m_bAnimationPending = false;
+  if(m_nNumFrames <= 1)
+    return;
+  AnimatedModel *model = (AnimatedModel*)m_pModel;
+  if(m_bSharedAnimation)
+    m_sharedVertexBuffer = model->selectSharedAnimationFrame(m_fCurFrame, 0, m_boundingBox, getModelToWorldMatrix());
+  else
+    model->selectAnimationFrame(m_fCurFrame, 0, *m_vertexBuffer, m_boundingBox, getModelToWorldMatrix()); // TODO figure which frame to render based on state
+}
@@ -39,8 +39,11 @@
 #include "Common/EulerAngles.h"
 #include "Common/AABB3.h"
 #include "Common/Vector3.h"
+#include "Common/Matrix4x3.h"
 #include "Common/Renderer.h"
 #include "Graphics/VertexTypes.h"
+#include "Generators/NameGenerator.h"
+#include "Objects/GameObjectList.h"
 #include "../../Bullet/src/btBulletDynamicsCommon.h"
 
 
@@ -59,6 +62,7 @@ class GameObjectManager; /// \brief Represents a game entity, usually represente
 class GameObject{
 public:
   friend class GameObjectManager;
+  friend class GameObjectList;
 
   btCollisionObject* colOb;
   btTransform* trans;
@@ -85,18 +89,28 @@ public:
   void setRotationSpeedBank(float speed, int part=0);  ///< Sets the rotation speed for the object (or one of its parts) on the bank axis.
   void incrementSpeed(float speed);  ///< Adjusts the forward speed of the object.
   const Vector3 transformObjectToInertial(const Vector3& position) const; ///< Transforms a position relative to this object to inertial (world) space.
+  const Vector3 rotateObjectToInertial(const Vector3& v) const; ///< Rotates a direction relative to this object to inertial (world) space.
+  const Matrix4x3 &getObjectToWorldMatrix() const; ///< Queries the object for its object-to-world transform.
+  const Matrix4x3 &getModelToWorldMatrix() const; ///< Queries the object for the transform of its model, including the model orientation.
+  const Matrix4x3 &getPartMatrix(int part) const; ///< Queries a part for its transform relative to the model of part 0.
   virtual void killObject() {m_lifeState = LS_DEAD;} ///< Sets the object's m_lifeState variable to LS_DEAD.  The object manager will then remove the object.
+  virtual void reset();  ///< Returns the object to its newly-constructed state, so that a pooled object can be spawned again.
   
   virtual void computeBoundingBox();  ///< Updates the object's bounding box.
   const AABB3 &getBoundingBox() const;  ///< Queries the object for its axially-aligned bounding box.
+  void setExactBounds(bool exact) { m_bExactBounds = exact; }  ///< Sets whether the bounding box is the smallest box or a quicker, looser one.
+  bool hasExactBounds() const { return m_bExactBounds; }  ///< Returns true iff the bounding box is the smallest box around the model.
+  void setSharedAnimation(bool shared);  ///< Sets whether an animated object shares its vertex buffer with objects on the same frame.
+  bool hasSharedAnimation() const { return m_bSharedAnimation; }  ///< Returns true iff the object shares its animation vertex buffer.
   
   bool isAlive() const { return m_lifeState == LS_ALIVE; }  ///< Returns true iff the object is fully-grown and alive.
+  virtual bool isThreadSafe() const { return false; }  ///< Returns true iff process() and move() may run on a worker thread.
   virtual void process(float dt);  ///< Performs internal logic updates.
   virtual void move(float dt);  ///< Updates the object's position and other physical characteristics.
   virtual void render();  ///< Renders the object.
 
   unsigned int getID() const { return m_id; }  ///< Queries the object for its ID number.
-  const std::string &getName() const { return m_name; }  ///< Queries the object for its name.
+  const char *getName() const;  ///< Queries the object for its name.
   const std::string &getClassName() const { return m_className; }  ///< Queries the object for its class name.
   int getType() const { return m_type; }  ///< Queries the object for its type.
   void setClassName(const std::string &className) { m_className = className; }  ///< Sets the object's class name.
@@ -111,6 +125,8 @@ protected:
   btRigidBody* body;
 		  
   virtual void move(float dt, bool savePreviousState);
+  void updateAnimation();  ///< Fills the vertex buffer with the current animation frame.
+  bool updatePartMatrix(int part) const;  ///< Rebuilds the cached matrix of a part if the part has moved.
 
   // Object stage of life
   enum LifeState ///< Represents the stage of an object's life.
@@ -132,21 +148,34 @@ protected:
   float m_fDeltaTime; ///< Time change since last animation, in seconds.
 
   bool m_bBounded; ///< true if bounded by walls
+  bool m_bAnimationPending; ///< true if move() advanced the animation but left the vertex buffer for later
+  bool m_bExactBounds; ///< true if the bounding box is built from the model's hull, false if from its local boxes
+  bool m_bSharedAnimation; ///< true if the animation vertex buffer comes from the model and is shared
 	AABB3 m_boundingBox; ///< Contains the last computed bounding box.
 	float m_animFreq; ///< Number of times an animation cycles per second.
 	
   
+	mutable Matrix4x3 *m_partMatrix; ///< Cached local-to-parent matrices of parts; part 0 is object-to-world
+	mutable Vector3 *m_partMatrixPosition; ///< Positions the cached part matrices were built from
+	mutable EulerAngles *m_partMatrixOrient; ///< Orientations the cached part matrices were built from
+	mutable Matrix4x3 m_modelOrientMatrix; ///< Cached matrix of m_modelOrient
+	mutable EulerAngles m_modelOrientMatrixOrient; ///< Model orientation m_modelOrientMatrix was built from
+	mutable Matrix4x3 m_modelToWorld; ///< Cached model-to-world matrix
+	mutable bool m_bModelToWorldDirty; ///< true if m_modelToWorld must be rebuilt
+  
 	Vector3 m_oldPosition; ///< Previous position of the object.
 	EulerAngles m_oldOrient; ///< Previous orientation of the object.
 
   LifeState  m_lifeState; ///< State used by object manager to, e.g., cull dead objects.
   unsigned int m_id; ///< Unique ID number.
-  std::string m_name; ///< Unique name.
+  NameGenerator::Symbol m_name; ///< Unique name, held by the manager's name generator.
   std::string m_className; ///< Typically the name of the class, but can be changed; used to generate name.
   int m_type;              ///< Optionally used by games for runtime type identification.
   GameObjectManager *m_manager; ///< Points to this object's manager (if any).
+  GameObjectListSlot m_listSlots[GameObjectList::MAX_LISTS]; ///< Position of this object in the manager's object lists.
 
   StandardVertexBuffer *m_vertexBuffer; ///< Dynamic vertex buffer to hold animated model data
+  StandardVertexBuffer *m_sharedVertexBuffer; ///< Model's vertex buffer for the current frame, if m_bSharedAnimation
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file GameObjectList.cpp
+/// \brief Code for the GameObjectList class.
+
+#include <assert.h>
+#include "GameObject.h"
+#include "GameObjectList.h"
+
+/// \param slot Specifies which of the objects' list slots this list uses.
+///     Lists that may share objects must use different slots.
+GameObjectList::GameObjectList(unsigned int slot) :
+  m_slot(slot),
+  m_size(0)
+{
+  assert(slot < MAX_LISTS);
+}
+
+/// \param object Specifies the object.  Does nothing if it's already in the list.
+void GameObjectList::insert(GameObject *object)
+{
+  assert(object != NULL);
+  GameObjectListSlot &slot = object->m_listSlots[m_slot];
+  if(slot.group >= 0)
+    return;
+  int group = object->m_type < 0 ? 0 : object->m_type;
+  if(group >= (int)m_groups.size())
+    m_groups.resize(group + 1);
+  slot.group = group;
+  slot.index = (unsigned int)m_groups[group].size();
+  m_groups[group].push_back(object);
+  ++m_size;
+}
+
+/// \param object Specifies the object.  Does nothing if it isn't in the list.
+void GameObjectList::erase(GameObject *object)
+{
+  if(object == NULL)
+    return;
+  GameObjectListSlot &slot = object->m_listSlots[m_slot];
+  if(slot.group < 0)
+    return;
+  Group &group = m_groups[slot.group];
+  assert(slot.index < group.size() && group[slot.index] == object);
+  
+  // Move the last object of the group into the hole
+  GameObject *last = group.back();
+  group[slot.index] = last;
+  last->m_listSlots[m_slot].index = slot.index;
+  group.pop_back();
+  
+  slot.group = -1;
+  --m_size;
+}
+
+/// \param object Specifies the object.
+/// \return True iff the object is in the list.
+bool GameObjectList::contains(const GameObject *object) const
+{
+  return object != NULL && object->m_listSlots[m_slot].group >= 0;
+}
+
+void GameObjectList::clear()
+{
+  for(unsigned int g = 0; g < m_groups.size(); ++g)
+  {
+    Group &group = m_groups[g];
+    for(unsigned int i = 0; i < group.size(); ++i)
+      group[i]->m_listSlots[m_slot].group = -1;
+    group.clear();
+  }
+  m_size = 0;
+}
+
+/// \return An object in the list, or NULL if the list is empty.
+GameObject *GameObjectList::front() const
+{
+  for(unsigned int g = 0; g < m_groups.size(); ++g)
+    if(!m_groups[g].empty())
+      return m_groups[g].front();
+  return NULL;
+}
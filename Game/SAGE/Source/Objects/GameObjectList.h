@@ -0,0 +1,90 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file GameObjectList.h
+/// \brief Interface for the GameObjectList class.
+
+#ifndef __GAMEOBJECTLIST_H_INCLUDED__
+#define __GAMEOBJECTLIST_H_INCLUDED__
+
+#include <vector>
+
+class GameObject;
+
+/// \brief Records where an object is stored within one GameObjectList.
+struct GameObjectListSlot
+{
+  int group;          ///< Group holding the object, or -1 if the object is not in the list.
+  unsigned int index; ///< Index of the object within its group.
+};
+
+/// \brief A dense list of objects, grouped by object type.
+///
+/// Objects are kept in contiguous arrays, one per value of GameObject::getType(),
+/// so that walking the list touches memory linearly and calls the same virtual
+/// functions back to back.  Each object remembers its position in the list
+/// (in one of its GameObjectListSlot entries), which makes insertion, removal
+/// and membership tests constant time.  Removal swaps the last object of the
+/// group into the hole, so the order within a group is not preserved.
+///
+/// An object can be a member of at most MAX_LISTS lists at once, each of which
+/// must use a different slot number.
+class GameObjectList
+{
+  public:
+    enum { MAX_LISTS = 6 }; ///< Number of slots each object has for list membership.
+    typedef std::vector<GameObject *> Group; ///< Contiguous array of objects of one type.
+
+    explicit GameObjectList(unsigned int slot); ///< Constructs an empty list using the given object slot.
+
+    void insert(GameObject *object); ///< Adds an object to the list.
+    void erase(GameObject *object);  ///< Removes an object from the list.
+    bool contains(const GameObject *object) const; ///< Queries the list for membership of an object.
+    void clear(); ///< Removes all objects from the list without deleting them.
+
+    bool empty() const { return m_size == 0; } ///< Returns true iff the list has no objects.
+    unsigned int size() const { return m_size; } ///< Queries the number of objects in the list.
+    GameObject *front() const; ///< Returns some object in the list, or NULL if empty.
+
+    /// \brief Queries the number of groups.  Some groups may be empty.
+    unsigned int getGroupCount() const { return (unsigned int)m_groups.size(); }
+
+    /// \brief Queries one group of objects.
+    /// \param group Specifies the group, less than getGroupCount().
+    /// \return The objects in the group.
+    /// \warning Adding objects to the list may invalidate the returned reference.
+    const Group &getGroup(unsigned int group) const { return m_groups[group]; }
+
+  private:
+    unsigned int m_slot;        ///< Which of the objects' slots this list uses.
+    std::vector<Group> m_groups; ///< Objects, grouped by type.
+    unsigned int m_size;        ///< Total number of objects in all groups.
+};
+
+#endif
@@ -37,9 +37,23 @@
 
 bool GameObjectManager::renderBB = false;
 
+/// Index of the worker running the current PhaseJob chunk on this thread, so that
+/// queueSpawn() and queueKill() can pick that worker's command buffer.  Set by
+/// PhaseJob::run() from the index the pool hands it.
+static __declspec(thread) unsigned int s_phaseWorker = 0;
+
 GameObjectManager::GameObjectManager() :
+  m_objects(LIST_ALL),
+  m_movableObjects(LIST_MOVABLE),
+  m_processableObjects(LIST_PROCESSABLE),
+  m_renderableObjects(LIST_RENDERABLE),
   m_numDeadFrames(0),
-  m_frameCount(0)
+  m_frameCount(0),
+  m_physicsTimeStep(1.0f / 60.0f),
+  m_maxPhysicsSubSteps(4),
+  m_workers(NULL),
+  m_updateChunkSize(32),
+  m_bParallelPhase(false)
 {
 	
 	///collision configuration contains default setup for memory, collision setup
@@ -69,6 +83,10 @@ GameObjectManager::GameObjectManager() :
 
 GameObjectManager::~GameObjectManager()
 {
+  // Objects go first:  pooling them takes their bodies out of the world
+  clear();
+  clearPools();
+
     int i;
 	for (i=m_dynamicsWorld->getNumCollisionObjects()-1; i>=0 ;i--)
 	{
@@ -107,26 +125,44 @@ GameObjectManager::~GameObjectManager()
 	delete m_dispatcher;
 
 	delete m_collisionConfiguration;
-  clear();
+  delete m_workers;
 }
 
 void GameObjectManager::clear()
 {
-  while(m_objects.begin() != m_objects.end())
-    deleteObject(*(m_objects.begin()));
+  // Queued spawns were never handed over, so the queue still owns them
+  for(unsigned int t = 0; t < m_commands.size(); ++t)
+  {
+    for(unsigned int i = 0; i < m_commands[t].spawns.size(); ++i)
+      delete m_commands[t].spawns[i].object;
+    m_commands[t].spawns.clear();
+    m_commands[t].kills.clear();
+  }
+  while(!m_objects.empty())
+    deleteObject(m_objects.front());
   m_objects.clear();
   m_movableObjects.clear();
   m_processableObjects.clear();
   m_renderableObjects.clear();
   m_objectIDs.clear();
   m_objectNames.clear();
-  m_nameToID.clear();
   m_idToObject.clear();
   m_frameCount = 0;
 }
 
 void GameObjectManager::addPhysics(GameObject* g, bool activation) {
 
+	// A pooled object keeps its body, which was taken out of the world when the
+	// object was deleted.  Put it back, at rest.
+	if (g->body != NULL) {
+		g->body->setLinearVelocity(btVector3(0,0,0));
+		g->body->setAngularVelocity(btVector3(0,0,0));
+		g->body->clearForces();
+		m_dynamicsWorld->addRigidBody(g->body);
+		g->body->activate(activation);
+		return;
+	}
+
 	///create a few basic rigid bodies
 	Vector3 v = g->getBoundingBox().max-g->getBoundingBox().min;
 	btBoxShape* box = new btBoxShape(btVector3(v.x,v.y,v.z));
@@ -197,11 +233,50 @@ void GameObjectManager::setNumberOfDeadFrames(unsigned int numFrames)
   m_numDeadFrames = numFrames;
 }
 
+/// \param stepsPerSecond Specifies how many fixed physics steps make up one second of
+///     simulation.  If zero or less, physics takes a single variable step of the frame time.
+/// \param maxSubSteps Specifies the most fixed steps taken in one update.  Time beyond that
+///     is dropped, so that a long frame can't snowball into ever longer physics updates.
+void GameObjectManager::setPhysicsRate(float stepsPerSecond, int maxSubSteps)
+{
+  m_physicsTimeStep = stepsPerSecond > 0.0f ? 1.0f / stepsPerSecond : 0.0f;
+  m_maxPhysicsSubSteps = maxSubSteps < 1 ? 1 : maxSubSteps;
+}
+
+/// In parallel mode, the process and move phases are shared among a pool of threads.
+/// Only objects whose isThreadSafe() returns true are handed to the pool; the rest are
+/// updated on the calling thread first, as usual.  Objects updated in parallel must
+/// spawn and kill through queueSpawn() and queueKill().
+/// \param threadCount Specifies the total number of threads, counting the caller of
+///     update().  One updates serially; zero uses one thread per hardware thread.
+void GameObjectManager::setUpdateThreads(unsigned int threadCount)
+{
+  assert(!m_bParallelPhase);
+  flushCommands();
+  delete m_workers;
+  m_workers = threadCount == 1 ? NULL : new WorkerPool(threadCount);
+  m_commands.resize(getUpdateThreads());
+}
+
+/// \return The number of threads that share the process and move phases, counting the
+///     caller of update().  One means objects are updated serially.
+unsigned int GameObjectManager::getUpdateThreads() const
+{
+  return m_workers == NULL ? 1 : m_workers->getThreadCount();
+}
+
+/// \param chunkSize Specifies how many objects a thread takes at a time.  Bigger chunks
+///     cost less to hand out; smaller chunks balance uneven work better.
+void GameObjectManager::setUpdateChunkSize(unsigned int chunkSize)
+{
+  m_updateChunkSize = chunkSize < 1 ? 1 : chunkSize;
+}
+
 /// \param dt Specifies the amount of time since last update, in seconds.
 void GameObjectManager::update(float dt)
 {
-  m_dynamicsWorld->stepSimulation(dt, 60);
   updateObjectLifeStates();
+  stepPhysics(dt);
   if(m_frameCount >= m_numDeadFrames)
   {
     process(dt);
@@ -210,23 +285,30 @@ void GameObjectManager::update(float dt)
     handleInteractions();
     computeBoundingBoxes();
   }
-  
-	// handle physics stuff
-
-	m_dynamicsWorld->stepSimulation(dt);
-
-	// TODO: set positions from physics
-
-	// end physics stuff
-
   ++m_frameCount;
 }
 
+/// In fixed-rate mode, Bullet accumulates frame time and takes as many fixed steps as fit
+/// (up to the maximum), keeping the remainder for the next update.  Objects still
+/// position themselves in move(), so nothing is read back from the motion states.
+/// \param dt Specifies the amount of time since last update, in seconds.
+void GameObjectManager::stepPhysics(float dt)
+{
+  if(m_physicsTimeStep > 0.0f)
+    m_dynamicsWorld->stepSimulation(dt, m_maxPhysicsSubSteps, m_physicsTimeStep);
+  else
+    m_dynamicsWorld->stepSimulation(dt, 0);
+}
+
 void GameObjectManager::render()
 {
-  for(ObjectSetIter it = m_renderableObjects.begin(); it != m_renderableObjects.end(); ++it)
-    if((*it)->m_lifeState == GameObject::LS_ALIVE)
-      (*it)->render();
+  for(unsigned int g = 0; g < m_renderableObjects.getGroupCount(); ++g)
+  {
+    const GameObjectList::Group &group = m_renderableObjects.getGroup(g);
+    for(unsigned int i = 0; i < group.size(); ++i)
+      if(group[i]->m_lifeState == GameObject::LS_ALIVE)
+        group[i]->render();
+  }
 
   if (renderBB)
     renderBoundingBoxes();
@@ -234,17 +316,25 @@ void GameObjectManager::render()
 
 void GameObjectManager::computeBoundingBoxes()
 {
-  for(ObjectSetIter it = m_objects.begin(); it != m_objects.end(); ++it)
-    if((*it)->isAlive())
-      (*it)->computeBoundingBox();
+  for(unsigned int g = 0; g < m_objects.getGroupCount(); ++g)
+  {
+    const GameObjectList::Group &group = m_objects.getGroup(g);
+    for(unsigned int i = 0; i < group.size(); ++i)
+      if(group[i]->isAlive())
+        group[i]->computeBoundingBox();
+  }
 }
 
 void GameObjectManager::renderBoundingBoxes()
 {
   gRenderer.setARGB(0xFF000000);
-  for(ObjectSetIter it = m_renderableObjects.begin(); it != m_renderableObjects.end(); ++it)
-    if((*it)->isAlive())
-      gRenderer.renderBoundingBox((*it)->getBoundingBox());
+  for(unsigned int g = 0; g < m_renderableObjects.getGroupCount(); ++g)
+  {
+    const GameObjectList::Group &group = m_renderableObjects.getGroup(g);
+    for(unsigned int i = 0; i < group.size(); ++i)
+      if(group[i]->isAlive())
+        gRenderer.renderBoundingBox(group[i]->getBoundingBox());
+  }
 }
 
 // Documentation for public addObject functions
@@ -293,39 +383,128 @@ void GameObjectManager::renderBoundingBoxes()
 void GameObjectManager::deleteObject(GameObject *object)
 {
   if(object == NULL) return;
-  m_nameToID.erase(object->m_name);
-  m_idToObject.erase(object->m_id);
-  m_objectIDs.releaseID(object->m_id);
   m_objectNames.releaseName(object->m_name);
+  object->m_name = NameGenerator::NOSYMBOL;
+  unsigned int slot = IDGenerator::getIndex(object->m_id);
+  if(slot < m_idToObject.size())
+    m_idToObject[slot] = NULL;
+  m_objectIDs.releaseID(object->m_id);
   m_objects.erase(object);
   m_movableObjects.erase(object);
   m_processableObjects.erase(object);
   m_renderableObjects.erase(object);
   object->m_manager = NULL;
-  delete object;
+
+  ObjectPool &pool = getPool(object->m_type);
+  if(pool.objects.size() < pool.capacity)
+  {
+    if(object->body != NULL)
+      m_dynamicsWorld->removeRigidBody(object->body);
+    pool.objects.push_back(object);
+  }
+  else
+    delete object;
+}
+
+/// Deleted objects of the type are kept, up to the given number, and handed back by
+/// reuseObject() instead of being destroyed.  A derived manager's spawn function can
+/// then reset and respawn one rather than allocating a new object.
+/// \param type Specifies the object type, as returned by GameObject::getType().
+/// \param capacity Specifies the most objects to keep.  Zero turns pooling off.
+void GameObjectManager::setObjectPoolSize(int type, unsigned int capacity)
+{
+  ObjectPool &pool = getPool(type);
+  pool.capacity = capacity;
+  while(pool.objects.size() > capacity)
+  {
+    GameObject *object = pool.objects.back();
+    pool.objects.pop_back();
+    if(object->body != NULL)
+    {
+      delete object->body->getMotionState();
+      delete object->body;
+    }
+    delete object;
+  }
+}
+
+/// Anonymous objects spawned without a requested name get an empty name instead of a
+/// generated one, which saves a string build and two hash table updates per spawn.
+/// They can still be found by ID.
+/// \param type Specifies the object type, as returned by GameObject::getType().
+/// \param anonymous True to skip name generation for the type.
+void GameObjectManager::setAnonymous(int type, bool anonymous)
+{
+  getPool(type).anonymous = anonymous;
+}
+
+/// \param type Specifies the object type, as returned by GameObject::getType().
+/// \return The number of deleted objects of the type waiting to be reused.
+unsigned int GameObjectManager::getPooledObjectCount(int type) const
+{
+  if(type < 0)
+    type = 0;
+  if(type >= (int)m_pools.size())
+    return 0;
+  return (unsigned int)m_pools[type].objects.size();
+}
+
+/// \param type Specifies the object type.
+/// \return A pooled object, which the caller must reset() before adding it
+///     again, or NULL if the pool is empty.
+GameObject *GameObjectManager::reuseObject(int type)
+{
+  if(type < 0)
+    type = 0;
+  if(type >= (int)m_pools.size() || m_pools[type].objects.empty())
+    return NULL;
+  GameObject *object = m_pools[type].objects.back();
+  m_pools[type].objects.pop_back();
+  return object;
+}
+
+/// \param type Specifies the object type.  Negative types share pool 0, as in GameObjectList.
+/// \return The pool for the type.
+GameObjectManager::ObjectPool &GameObjectManager::getPool(int type)
+{
+  if(type < 0)
+    type = 0;
+  if(type >= (int)m_pools.size())
+    m_pools.resize(type + 1);
+  return m_pools[type];
+}
+
+/// Pooled objects' bodies are no longer in the physics world, so they are destroyed here too.
+void GameObjectManager::clearPools()
+{
+  for(unsigned int t = 0; t < m_pools.size(); ++t)
+    setObjectPoolSize((int)t, 0);
+  m_pools.clear();
 }
 
 /// \param name Specifies the name of the object.
 /// \return The object's ID.
 unsigned int GameObjectManager::getObjectID(const std::string &name)
 {
-  NameToIDMapIter it = m_nameToID.find(name);
-  if(it == m_nameToID.end())
+  NameGenerator::Symbol symbol = m_objectNames.findName(name);
+  if(symbol == NameGenerator::NOSYMBOL)
     return 0;
   else
-    return it->second;
+    return m_objectNames.getValue(symbol);
 }
 
 /// \param id Specifies the id of the object.
-/// \return A pointer to the object.
+/// \return A pointer to the object, or NULL if the id is stale or was never handed out.
 /// \warning Do not call \c delete on this function's return value.
 GameObject *GameObjectManager::getObjectPointer(unsigned int id)
 {
-  IDToObjectMapIter it = m_idToObject.find(id);
-  if(it == m_idToObject.end())
+  unsigned int slot = IDGenerator::getIndex(id);
+  if(slot >= m_idToObject.size())
     return NULL;
-  else
-    return it->second;
+  GameObject *object = m_idToObject[slot];
+  if(object == NULL || object->m_id != id) // slot reused by a newer object
+    return NULL;
+  return object;
 }
 
 /// \param name Specifies the name of the object.
@@ -336,15 +515,35 @@ GameObject *GameObjectManager::getObjectPointer(const std::string &name)
   return getObjectPointer(getObjectID(name));
 }
 
+/// \param object Specifies an object owned by this manager.
+/// \return The object's name, or an empty string if it is anonymous.
+const char *GameObjectManager::getObjectName(const GameObject &object) const
+{
+  if(object.m_name == NameGenerator::NOSYMBOL)
+    return "";
+  return m_objectNames.getName(object.m_name);
+}
+
 /// This function handles any internal processing each object should perform before movement.
 /// Typically, this function won't need to be overridden in a derived class.
 /// \param dt Specifies the amount of time since the last call to process().
 void GameObjectManager::process(float dt)
 {
-  // Process live objects (new objects spawned during this loop will be skipped until next frame)
-  for(ObjectSetIter it = m_processableObjects.begin(); it != m_processableObjects.end(); ++it)
-    if((*it)->m_lifeState == GameObject::LS_ALIVE)
-      (*it)->process(dt);
+  if(m_workers != NULL)
+  {
+    runParallelPhase(m_processableObjects, false, dt);
+    return;
+  }
+
+  // Process live objects (new objects spawned during this loop will be skipped until next frame).
+  // Spawning can grow the lists, so elements are looked up by index each time.
+  for(unsigned int g = 0; g < m_processableObjects.getGroupCount(); ++g)
+    for(unsigned int i = 0; i < m_processableObjects.getGroup(g).size(); ++i)
+    {
+      GameObject *object = m_processableObjects.getGroup(g)[i];
+      if(object->m_lifeState == GameObject::LS_ALIVE)
+        object->process(dt);
+    }
 }
 
 /// This function handles all "normal" movement of each object--that is, any movement that
@@ -353,9 +552,19 @@ void GameObjectManager::process(float dt)
 /// \param dt Specifies the amount of time since the last call to render().
 void GameObjectManager::move(float dt)
 {
-  for(ObjectSetIter it = m_movableObjects.begin(); it != m_movableObjects.end(); ++it)
-    if((*it)->m_lifeState == GameObject::LS_ALIVE)
-      (*it)->move(dt);
+  if(m_workers != NULL)
+  {
+    runParallelPhase(m_movableObjects, true, dt);
+    return;
+  }
+
+  for(unsigned int g = 0; g < m_movableObjects.getGroupCount(); ++g)
+    for(unsigned int i = 0; i < m_movableObjects.getGroup(g).size(); ++i)
+    {
+      GameObject *object = m_movableObjects.getGroup(g)[i];
+      if(object->m_lifeState == GameObject::LS_ALIVE)
+        object->move(dt);
+    }
 }
 
 /// This function handles interactions between objects (such as collisions) and other post-movement
@@ -374,23 +583,27 @@ void GameObjectManager::move(float dt)
 void GameObjectManager::handleInteractions()
 {
   // Default interaction handler:  Check all movable objects against all objects
-  for(ObjectSetIter mit = m_movableObjects.begin(); mit != m_movableObjects.end(); ++mit)
-  {
-    if((*mit)->m_lifeState != GameObject::LS_ALIVE)
-      continue;
-    for(ObjectSetIter oit = m_objects.begin(); oit != m_objects.end(); ++oit)
-      {
-        // Handling duplicate interactions (i.e., preventing interact(o1,o2)
-        // and interact(o2,o1)):  Duplicates only occur between any pair of
-        // movable objects o1 and o2.  (Think about it.) Therefore, if both
-        // objects are movable, only call once.  A simple ID ordering
-        // accomplishes our objective.
-        if((*oit)->m_lifeState != GameObject::LS_ALIVE)
-          continue;
-        if((*mit)->m_id != (*oit)->m_id && ((*mit)->m_id < (*oit)->m_id || m_movableObjects.find(*oit) == m_movableObjects.end()))
-          interact(**mit, **oit);
-      }
-  }
+  for(unsigned int mg = 0; mg < m_movableObjects.getGroupCount(); ++mg)
+    for(unsigned int mi = 0; mi < m_movableObjects.getGroup(mg).size(); ++mi)
+    {
+      GameObject *mobj = m_movableObjects.getGroup(mg)[mi];
+      if(mobj->m_lifeState != GameObject::LS_ALIVE)
+        continue;
+      for(unsigned int og = 0; og < m_objects.getGroupCount(); ++og)
+        for(unsigned int oi = 0; oi < m_objects.getGroup(og).size(); ++oi)
+        {
+          // Handling duplicate interactions (i.e., preventing interact(o1,o2)
+          // and interact(o2,o1)):  Duplicates only occur between any pair of
+          // movable objects o1 and o2.  (Think about it.) Therefore, if both
+          // objects are movable, only call once.  A simple ID ordering
+          // accomplishes our objective.
+          GameObject *oobj = m_objects.getGroup(og)[oi];
+          if(oobj->m_lifeState != GameObject::LS_ALIVE)
+            continue;
+          if(mobj->m_id != oobj->m_id && (mobj->m_id < oobj->m_id || !m_movableObjects.contains(oobj)))
+            interact(*mobj, *oobj);
+        }
+    }
 }
 
 /// This function handles interactions between two objects.  The default implementation simply
@@ -425,7 +638,7 @@ bool GameObjectManager::interact(GameObject &obj1, GameObject &obj2)
 unsigned int GameObjectManager::addObject(GameObject *object, bool canMove, bool canProcess, bool canRender, const std::string *name)
 {
   assert(object != NULL);
-
+  assert(!m_bParallelPhase); // Use queueSpawn() from process() and move()
 
   if(object->m_manager == this)
     return object->m_id;
@@ -439,17 +652,23 @@ unsigned int GameObjectManager::addObject(GameObject *object, bool canMove, bool
   if(canRender)
     m_renderableObjects.insert(object);
   object->m_id = m_objectIDs.generateID();
-  if(name == NULL || name->length() == 0)
-    object->m_name = m_objectNames.generateName(object->m_className);  // Generate default name
-  else if(m_objectNames.requestName(*name))
-    object->m_name = *name;                                            // Requested name accepted
-  else
-    object->m_name = m_objectNames.generateName(*name);                // Append number to requested name
+  NameGenerator::Symbol symbol = NameGenerator::NOSYMBOL;
+  if((name == NULL || name->length() == 0) && getPool(object->m_type).anonymous)
+    symbol = NameGenerator::NOSYMBOL;                             // Anonymous object
+  else if(name == NULL || name->length() == 0)
+    symbol = m_objectNames.generateName(object->m_className);     // Generate default name
+  else if((symbol = m_objectNames.requestName(*name)) == NameGenerator::NOSYMBOL)
+    symbol = m_objectNames.generateName(*name);                   // Append number to requested name
   // Ensure new object status
   object->m_lifeState = GameObject::LS_NEW;
   // Add id and name mappings
-  m_nameToID[object->m_name] = object->m_id;
-  m_idToObject[object->m_id] = object;
+  object->m_name = symbol;
+  if(symbol != NameGenerator::NOSYMBOL)
+    m_objectNames.setValue(symbol, object->m_id);
+  unsigned int slot = IDGenerator::getIndex(object->m_id);
+  if(slot >= m_idToObject.size())
+    m_idToObject.resize(slot + 1, NULL);
+  m_idToObject[slot] = object;
 
   
   return object->m_id;
@@ -459,26 +678,129 @@ unsigned int GameObjectManager::addObject(GameObject *object, bool canMove, bool
 /// and objects marked as "dead" are culled from the manager.
 void GameObjectManager::updateObjectLifeStates()
 {
-  // Promote new objects to "fully alive" and cull dead objects
-  for(ObjectSetIter it = m_objects.begin(); it != m_objects.end();)
-  {
-    switch((*it)->m_lifeState)
+  flushCommands();
+
+  // Promote new objects to "fully alive" and cull dead objects.  Deleting an object
+  // moves the last object of its group into its place, so walk each group backwards.
+  for(unsigned int g = 0; g < m_objects.getGroupCount(); ++g)
+    for(unsigned int i = (unsigned int)m_objects.getGroup(g).size(); i-- > 0;)
     {
-      case GameObject::LS_DEAD:
+      GameObject *object = m_objects.getGroup(g)[i];
+      switch(object->m_lifeState)
       {
-        ObjectSetIter murderDeathKill = it;
-        ++it;
-        deleteObject(*murderDeathKill);
-      } break;
-      case GameObject::LS_NEW:
-      {
-        (*it)->m_lifeState = GameObject::LS_ALIVE;
-        ++it;
-      } break;
-      default:
-      {
-       ++it;
-      } break;
-    };
+        case GameObject::LS_DEAD:
+        {
+          deleteObject(object);
+        } break;
+        case GameObject::LS_NEW:
+        {
+          object->m_lifeState = GameObject::LS_ALIVE;
+        } break;
+        default:
+        {
+        } break;
+      };
+    }
+}
+/// Objects that aren't thread-safe are processed or moved right away on this thread.
+/// The thread-safe ones are gathered up and then shared among the workers, after which
+/// any animation they left pending is finished here.
+/// \param objects Specifies the list to update.
+/// \param moving True to call move(), false to call process().
+/// \param dt Specifies the amount of time since the last update, in seconds.
+void GameObjectManager::runParallelPhase(GameObjectList &objects, bool moving, float dt)
+{
+  m_parallelObjects.clear();
+  for(unsigned int g = 0; g < objects.getGroupCount(); ++g)
+    for(unsigned int i = 0; i < objects.getGroup(g).size(); ++i)
+    {
+      GameObject *object = objects.getGroup(g)[i];
+      if(object->m_lifeState != GameObject::LS_ALIVE)
+        continue;
+      if(object->isThreadSafe())
+        m_parallelObjects.push_back(object);
+      else if(moving)
+        object->move(dt);
+      else
+        object->process(dt);
+    }
+
+  if(m_commands.size() < m_workers->getThreadCount())
+    m_commands.resize(m_workers->getThreadCount());
+
+  PhaseJob job(*this, moving, dt);
+  m_bParallelPhase = true;
+  m_workers->parallelFor(job, (unsigned int)m_parallelObjects.size(), m_updateChunkSize);
+  m_bParallelPhase = false;
+
+  if(moving)
+    for(unsigned int i = 0; i < m_parallelObjects.size(); ++i)
+      if(m_parallelObjects[i]->m_bAnimationPending)
+        m_parallelObjects[i]->updateAnimation();
+}
+
+/// \param object Specifies the object.
+/// \param canMove True iff the object needs move() to be called.
+/// \param canProcess True iff the object needs process() to be called.
+/// \param canRender True iff the object needs render() to be called.
+/// \return The ID of the object, or 0 if the spawn was queued.  Queued objects are
+///     added at the start of the next update, and are owned by the manager from now on.
+unsigned int GameObjectManager::queueSpawn(GameObject *object, bool canMove, bool canProcess, bool canRender)
+{
+  if(!m_bParallelPhase)
+    return addObject(object, canMove, canProcess, canRender, NULL);
+  SpawnCommand command = {object, canMove, canProcess, canRender};
+  m_commands[s_phaseWorker].spawns.push_back(command);
+  return 0;
+}
+
+/// Calls the object's killObject() right away, or, during a parallel phase, at the start
+/// of the next update.  Overrides of killObject() often touch shared state, such as the
+/// particle engine, so they mustn't run on a worker thread.
+/// \param object Specifies the object.
+void GameObjectManager::queueKill(GameObject *object)
+{
+  if(object == NULL)
+    return;
+  if(!m_bParallelPhase)
+    object->killObject();
+  else
+    m_commands[s_phaseWorker].kills.push_back(object);
+}
+
+void GameObjectManager::flushCommands()
+{
+  for(unsigned int t = 0; t < m_commands.size(); ++t)
+  {
+    CommandBuffer &commands = m_commands[t];
+    for(unsigned int i = 0; i < commands.spawns.size(); ++i)
+    {
+      const SpawnCommand &spawn = commands.spawns[i];
+      addObject(spawn.object, spawn.canMove, spawn.canProcess, spawn.canRender, NULL);
+    }
+    for(unsigned int i = 0; i < commands.kills.size(); ++i)
+      commands.kills[i]->killObject();
+    commands.spawns.clear();
+    commands.kills.clear();
+  }
+}
+
+GameObjectManager::PhaseJob::PhaseJob(GameObjectManager &manager, bool moving, float dt) :
+  m_manager(manager),
+  m_moving(moving),
+  m_dt(dt)
+{
+}
+
+void GameObjectManager::PhaseJob::run(unsigned int begin, unsigned int end, unsigned int worker)
+{
+  s_phaseWorker = worker;
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    GameObject *object = m_manager.m_parallelObjects[i];
+    if(m_moving)
+      object->move(m_dt);
+    else
+      object->process(m_dt);
   }
-}
\ No newline at end of file
+}
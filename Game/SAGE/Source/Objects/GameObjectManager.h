@@ -35,12 +35,14 @@
 #ifndef __GAMEOBJECTMANAGER_H_INCLUDED__
 #define __GAMEOBJECTMANAGER_H_INCLUDED__
 
-#include <hash_map>
 #include <hash_set>
 #include <list>
 #include <string>
+#include <vector>
+#include "Common/WorkerPool.h"
 #include "Generators/IDGenerator.h"
 #include "Generators/NameGenerator.h"
+#include "Objects/GameObjectList.h"
 #include "../../Bullet/src/LinearMath/btAlignedObjectArray.h"
 
 class btBroadphaseInterface;
@@ -102,6 +104,14 @@ class GameObjectManager
     // State update functions
         
     void setNumberOfDeadFrames(unsigned int numFrames);  ///< Sets the number of frames to skip before processing begins.
+    void setPhysicsRate(float stepsPerSecond, int maxSubSteps);  ///< Sets the fixed rate at which physics is stepped.
+    float getPhysicsTimeStep() const { return m_physicsTimeStep; }  ///< Queries the fixed physics time step, in seconds (0 if variable).
+    int getMaxPhysicsSubSteps() const { return m_maxPhysicsSubSteps; }  ///< Queries the maximum number of physics steps per update.
+    void setUpdateThreads(unsigned int threadCount);  ///< Sets how many threads share the process and move phases.
+    unsigned int getUpdateThreads() const;  ///< Queries how many threads share the process and move phases.
+    void setUpdateChunkSize(unsigned int chunkSize);  ///< Sets how many objects a thread takes at a time.
+    unsigned int getUpdateChunkSize() const { return m_updateChunkSize; }  ///< Queries how many objects a thread takes at a time.
+    bool isUpdatingInParallel() const { return m_bParallelPhase; }  ///< Returns true while worker threads are processing or moving objects.
     virtual void update(float dt);  ///< Updates the state of all objects.
     virtual void render();  ///< Renders all renderable objects.
     
@@ -116,19 +126,77 @@ class GameObjectManager
     unsigned int addObject(GameObject *object, bool canMove, bool canProcess, bool canRender, const std::string &name) { return addObject(object, canMove, canProcess, canRender, &name); }
     virtual void deleteObject(GameObject *object);  ///< Deletes an object.
 
+    // Spawning and killing from process() and move().  Safe from worker threads.
+
+    unsigned int queueSpawn(GameObject *object) { return queueSpawn(object, true, true, true); }
+    unsigned int queueSpawn(GameObject *object, bool canMove, bool canProcess, bool canRender);  ///< Adds an object now, or after a parallel phase.
+    void queueKill(GameObject *object);  ///< Kills an object now, or after a parallel phase.
+
+    // Object pools
+
+    void setObjectPoolSize(int type, unsigned int capacity);  ///< Sets how many deleted objects of a type are kept for reuse.
+    void setAnonymous(int type, bool anonymous);  ///< Sets whether objects of a type skip name generation.
+    unsigned int getPooledObjectCount(int type) const;  ///< Queries how many objects of a type wait in the pool.
+
     unsigned int getObjectID(const std::string &name);  ///< Queries the manager for an object's ID.
     GameObject *getObjectPointer(unsigned int id);  ///< Queries the manager for an object's pointer.
     GameObject *getObjectPointer(const std::string &name);  ///< Queries the manager for an object's pointer.
+    const char *getObjectName(const GameObject &object) const;  ///< Queries the manager for an object's name.
 
   protected:
     // Nested types
     
     typedef stdext::hash_set<GameObject *> ObjectSet;  ///< Represents a set of objects.
     typedef ObjectSet::iterator ObjectSetIter;  ///< Set iterator.
-    typedef stdext::hash_map<std::string, unsigned int> NameToIDMap;  ///< Maps object names to object IDs.
-    typedef NameToIDMap::iterator NameToIDMapIter;  ///< Map iterator.
-    typedef stdext::hash_map<unsigned int, GameObject *> IDToObjectMap;  ///< Maps object IDs to object pointers.
-    typedef IDToObjectMap::iterator IDToObjectMapIter;  ///< 
+    typedef std::vector<GameObject *> IDToObjectMap;  ///< Maps the slot index of object IDs to object pointers.  Slots are recycled, so they stay dense.
+
+    /// \brief Per-type pool of deleted objects kept for reuse.
+    struct ObjectPool
+    {
+      std::vector<GameObject *> objects; ///< Deleted objects waiting to be respawned.
+      unsigned int capacity;             ///< Most objects the pool will keep.
+      bool anonymous;                    ///< True if objects of this type get no generated name.
+      ObjectPool() : capacity(0), anonymous(false) {}
+    };
+
+    /// \brief A spawn raised while objects were updated in parallel.
+    struct SpawnCommand
+    {
+      GameObject *object; ///< Object to be added.
+      bool canMove;       ///< Whether the object needs move() to be called.
+      bool canProcess;    ///< Whether the object needs process() to be called.
+      bool canRender;     ///< Whether the object needs render() to be called.
+    };
+
+    /// \brief Spawns and kills raised by one thread during a parallel phase.
+    struct CommandBuffer
+    {
+      std::vector<SpawnCommand> spawns; ///< Objects to add.
+      std::vector<GameObject *> kills;  ///< Objects to kill.
+    };
+
+    /// \brief Runs process() or move() on a slice of m_parallelObjects.
+    class PhaseJob : public WorkerPool::Job
+    {
+      public:
+        PhaseJob(GameObjectManager &manager, bool moving, float dt);
+        virtual void run(unsigned int begin, unsigned int end, unsigned int worker);
+      private:
+        GameObjectManager &m_manager; ///< Manager whose objects are updated.
+        bool m_moving;                ///< True to call move(), false to call process().
+        float m_dt;                   ///< Time step passed to the objects.
+    };
+    friend class PhaseJob;
+
+    /// \brief Object slots used by the manager's lists.
+    enum ObjectListSlot
+    {
+      LIST_ALL = 0,     ///< Slot used by m_objects.
+      LIST_MOVABLE,     ///< Slot used by m_movableObjects.
+      LIST_PROCESSABLE, ///< Slot used by m_processableObjects.
+      LIST_RENDERABLE,  ///< Slot used by m_renderableObjects.
+      LIST_USER         ///< First slot free for lists kept by derived managers.
+    };
     
     virtual void process(float dt);  ///< Processes all objects.
     virtual void move(float dt);  ///< Moves all objects.
@@ -137,42 +205,58 @@ class GameObjectManager
 
     virtual unsigned int addObject(GameObject *object, bool canMove, bool canProcess, bool canRender, const std::string *namePtr);  ///< Gives control of an object to the manager.
     virtual void updateObjectLifeStates();  ///< Updates new objects to "alive", and culls dead objects.
+    virtual void stepPhysics(float dt);  ///< Advances the physics world.
+    void runParallelPhase(GameObjectList &objects, bool moving, float dt);  ///< Processes or moves a list of objects on the worker pool.
+    void flushCommands();  ///< Carries out spawns and kills queued during parallel phases.
+    GameObject *reuseObject(int type);  ///< Takes a deleted object of a type out of its pool, if any.
+    ObjectPool &getPool(int type);  ///< Finds the pool for a type, creating it if needed.
+    void clearPools();  ///< Destroys all pooled objects.
 
     /// \brief Contains and owns all managed objects.
     ///
     /// Contains and owns all managed objects.  Created objects are
-    /// deleted from here.
-    ObjectSet m_objects;
+    /// deleted from here.  Like the lists below, objects are stored
+    /// densely and grouped by type; see GameObjectList.
+    GameObjectList m_objects;
     
     /// \brief Lists all objects that can move.
     ///
     /// Lists all objects that can move.  The pointers in this list
     /// point to elements of objects; therefore, one should never
     /// call \p delete on a pointer in this list.
-    ObjectSet m_movableObjects;
+    GameObjectList m_movableObjects;
 
     /// \brief Lists all objects that will think during behavioral updates.
     ///
     /// Lists all objects that can think.  The pointers in this list
     /// point to elements of objects; therefore, one should never
     /// call \p delete on a pointer in this list.
-    ObjectSet m_processableObjects;
+    GameObjectList m_processableObjects;
 
     /// \brief Lists all objects that will be rendered.
     ///
     /// Lists all objects that can render.  The pointers in this list
     /// point to elements of objects; therefore, one should never
     /// call \p delete on a pointer in this list.
-    ObjectSet m_renderableObjects;
+    GameObjectList m_renderableObjects;
     
-    NameToIDMap m_nameToID;       ///< Maps object names to their IDs.
-    IDToObjectMap m_idToObject;   ///< Maps object IDs to their pointers.
+    IDToObjectMap m_idToObject;   ///< Maps the slot index of object IDs to their pointers.
     
-    IDGenerator m_objectIDs;      ///< Generates IDs for the objects.
-    NameGenerator m_objectNames;  ///< Generates names for the objects.
+    IDGenerator m_objectIDs;      ///< Generates IDs for the objects.  Released slots are recycled with a new generation.
+    NameGenerator m_objectNames;  ///< Generates names for the objects and maps them to their IDs.
     
     unsigned int m_numDeadFrames;  ///< Number of frames to skip processing at creation.
     unsigned int m_frameCount;  ///< Tracks the number of frames processed.
+    float m_physicsTimeStep;  ///< Fixed physics time step in seconds, or 0 for one variable step per update.
+    int m_maxPhysicsSubSteps;  ///< Maximum number of fixed physics steps taken per update.
+
+    WorkerPool *m_workers;  ///< Threads for the process and move phases, or NULL to update serially.
+    unsigned int m_updateChunkSize;  ///< Number of objects a thread takes at a time.
+    bool m_bParallelPhase;  ///< True while the workers are processing or moving objects.
+    std::vector<GameObject *> m_parallelObjects;  ///< Thread-safe objects updated by the current phase.
+    std::vector<CommandBuffer> m_commands;  ///< Spawns and kills queued by each thread.
+
+    std::vector<ObjectPool> m_pools;  ///< Pools of deleted objects, indexed by type.
 };
 
 #endif
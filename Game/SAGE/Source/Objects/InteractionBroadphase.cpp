@@ -0,0 +1,350 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file InteractionBroadphase.cpp
+/// \brief Code for the interaction broadphase classes.
+
+#include <algorithm>
+#include <math.h>
+#include "InteractionBroadphase.h"
+
+/// Objects whose boxes cover more cells than this are kept off the grid.
+static const unsigned int kMaxCellsPerObject = 64;
+
+/// Bias added to cell coordinates so they pack into 21 unsigned bits.
+static const int kCellBias = 1 << 20;
+
+/// Counts the cells from c0 to c1 inclusive, capped just past kMaxCellsPerObject
+/// so that multiplying the spans of all three axes can't overflow.
+static unsigned int cellSpan(int c0, int c1)
+{
+  long long span = (long long)c1 - c0 + 1;
+  return span > kMaxCellsPerObject ? kMaxCellsPerObject + 1 : (unsigned int)span;
+}
+
+//-----------------------------------------------------------------------------
+// InteractionBroadphase
+
+InteractionBroadphase::InteractionBroadphase() :
+  m_pairsTested(0),
+  m_pairsFound(0)
+{
+  m_bounds.empty();
+}
+
+void InteractionBroadphase::clear()
+{
+  m_objects.clear();
+  m_boxes.clear();
+  m_bounds.empty();
+  m_pairsTested = 0;
+  m_pairsFound = 0;
+}
+
+/// \param object Specifies the object.  It is only used as a handle.
+/// \param box Specifies the object's bounding box.
+void InteractionBroadphase::insert(GameObject *object, const AABB3 &box)
+{
+  if(box.isEmpty()) return;
+  m_objects.push_back(object);
+  m_boxes.push_back(box);
+  m_bounds.add(box);
+}
+
+bool InteractionBroadphase::testPair(unsigned int i, unsigned int j)
+{
+  ++m_pairsTested;
+  return AABB3::intersect(m_boxes[i], m_boxes[j]);
+}
+
+bool InteractionBroadphase::testBox(unsigned int i, const AABB3 &box)
+{
+  ++m_pairsTested;
+  return AABB3::intersect(m_boxes[i], box);
+}
+
+void InteractionBroadphase::addPair(PairList &pairs, unsigned int i, unsigned int j)
+{
+  Pair p;
+  p.first = m_objects[i];
+  p.second = m_objects[j];
+  pairs.push_back(p);
+  ++m_pairsFound;
+}
+
+//-----------------------------------------------------------------------------
+// BruteForceBroadphase
+
+void BruteForceBroadphase::findPairs(PairList &pairs)
+{
+  pairs.clear();
+  unsigned int n = (unsigned int)m_objects.size();
+  for(unsigned int i = 0; i < n; ++i)
+    for(unsigned int j = i + 1; j < n; ++j)
+      if(testPair(i, j))
+        addPair(pairs, i, j);
+}
+
+void BruteForceBroadphase::queryBox(const AABB3 &box, ObjectList &results)
+{
+  results.clear();
+  unsigned int n = (unsigned int)m_objects.size();
+  for(unsigned int i = 0; i < n; ++i)
+    if(testBox(i, box))
+    {
+      results.push_back(m_objects[i]);
+      ++m_pairsFound;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// SweepAndPruneBroadphase
+
+void SweepAndPruneBroadphase::build()
+{
+  unsigned int n = (unsigned int)m_objects.size();
+  m_sorted.resize(n);
+  for(unsigned int i = 0; i < n; ++i)
+    m_sorted[i] = i;
+  MinXLess less;
+  less.boxes = &m_boxes;
+  std::sort(m_sorted.begin(), m_sorted.end(), less);
+}
+
+void SweepAndPruneBroadphase::findPairs(PairList &pairs)
+{
+  pairs.clear();
+  unsigned int n = (unsigned int)m_sorted.size();
+  for(unsigned int i = 0; i < n; ++i)
+  {
+    unsigned int a = m_sorted[i];
+    float maxX = m_boxes[a].max.x;
+    // Every box starting before this one ends is a candidate; the rest can't overlap
+    for(unsigned int j = i + 1; j < n && m_boxes[m_sorted[j]].min.x <= maxX; ++j)
+    {
+      unsigned int b = m_sorted[j];
+      if(testPair(a, b))
+        addPair(pairs, a, b);
+    }
+  }
+}
+
+void SweepAndPruneBroadphase::queryBox(const AABB3 &box, ObjectList &results)
+{
+  results.clear();
+  unsigned int n = (unsigned int)m_sorted.size();
+  for(unsigned int i = 0; i < n && m_boxes[m_sorted[i]].min.x <= box.max.x; ++i)
+  {
+    unsigned int a = m_sorted[i];
+    if(testBox(a, box))
+    {
+      results.push_back(m_objects[a]);
+      ++m_pairsFound;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+// UniformGridBroadphase
+
+/// \param cellSize Specifies the edge length of a grid cell.
+UniformGridBroadphase::UniformGridBroadphase(float cellSize) :
+  m_queryStamp(0)
+{
+  setCellSize(cellSize);
+}
+
+/// \param cellSize Specifies the edge length of a grid cell.  Must be positive.
+void UniformGridBroadphase::setCellSize(float cellSize)
+{
+  if(cellSize <= 0.0f) return;
+  m_cellSize = cellSize;
+  m_invCellSize = 1.0f / cellSize;
+}
+
+void UniformGridBroadphase::clear()
+{
+  InteractionBroadphase::clear();
+  m_entries.clear();
+  m_large.clear();
+}
+
+int UniformGridBroadphase::cellCoord(float v) const
+{
+  return (int)floor(v * m_invCellSize);
+}
+
+UniformGridBroadphase::CellKey UniformGridBroadphase::makeKey(int x, int y, int z)
+{
+  const CellKey mask = (1 << 21) - 1;
+  return (((CellKey)(x + kCellBias) & mask) << 42) |
+         (((CellKey)(y + kCellBias) & mask) << 21) |
+          ((CellKey)(z + kCellBias) & mask);
+}
+
+UniformGridBroadphase::CellKey UniformGridBroadphase::pointKey(const Vector3 &p) const
+{
+  return makeKey(cellCoord(p.x), cellCoord(p.y), cellCoord(p.z));
+}
+
+void UniformGridBroadphase::build()
+{
+  unsigned int n = (unsigned int)m_objects.size();
+  m_entries.clear();
+  m_large.clear();
+  m_stamps.assign(n, 0);
+  m_queryStamp = 0;
+
+  for(unsigned int i = 0; i < n; ++i)
+  {
+    const AABB3 &box = m_boxes[i];
+    int x0 = cellCoord(box.min.x), x1 = cellCoord(box.max.x);
+    int y0 = cellCoord(box.min.y), y1 = cellCoord(box.max.y);
+    int z0 = cellCoord(box.min.z), z1 = cellCoord(box.max.z);
+    unsigned int cells = cellSpan(x0, x1) * cellSpan(y0, y1) * cellSpan(z0, z1);
+    if(cells > kMaxCellsPerObject)
+    {
+      m_large.push_back(i);
+      continue;
+    }
+    Entry e;
+    e.index = i;
+    for(int x = x0; x <= x1; ++x)
+      for(int y = y0; y <= y1; ++y)
+        for(int z = z0; z <= z1; ++z)
+        {
+          e.key = makeKey(x, y, z);
+          m_entries.push_back(e);
+        }
+  }
+  std::sort(m_entries.begin(), m_entries.end());
+}
+
+/// \param key Specifies the cell.
+/// \param first Receives the index of the cell's first entry.
+/// \param last Receives one past the index of the cell's last entry.
+/// \return True iff the cell contains any objects.
+bool UniformGridBroadphase::findCell(CellKey key, unsigned int &first, unsigned int &last) const
+{
+  Entry e;
+  e.key = key;
+  e.index = 0;
+  std::vector<Entry>::const_iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), e);
+  if(it == m_entries.end() || it->key != key)
+    return false;
+  first = (unsigned int)(it - m_entries.begin());
+  last = first;
+  while(last < m_entries.size() && m_entries[last].key == key)
+    ++last;
+  return true;
+}
+
+void UniformGridBroadphase::report(unsigned int index, ObjectList &results)
+{
+  if(m_stamps[index] == m_queryStamp) return;
+  m_stamps[index] = m_queryStamp;
+  results.push_back(m_objects[index]);
+  ++m_pairsFound;
+}
+
+void UniformGridBroadphase::collectCell(CellKey key, const AABB3 &box, ObjectList &results)
+{
+  unsigned int first, last;
+  if(!findCell(key, first, last)) return;
+  for(unsigned int k = first; k < last; ++k)
+  {
+    unsigned int i = m_entries[k].index;
+    if(m_stamps[i] != m_queryStamp && testBox(i, box))
+      report(i, results);
+  }
+}
+
+void UniformGridBroadphase::findPairs(PairList &pairs)
+{
+  pairs.clear();
+  unsigned int n = (unsigned int)m_entries.size();
+  for(unsigned int first = 0; first < n;)
+  {
+    CellKey key = m_entries[first].key;
+    unsigned int last = first + 1;
+    while(last < n && m_entries[last].key == key)
+      ++last;
+    for(unsigned int a = first; a < last; ++a)
+      for(unsigned int b = a + 1; b < last; ++b)
+      {
+        unsigned int i = m_entries[a].index, j = m_entries[b].index;
+        AABB3 overlap;
+        ++m_pairsTested;
+        if(!AABB3::intersect(m_boxes[i], m_boxes[j], &overlap))
+          continue;
+        // Two boxes can share several cells; only report the pair from the cell
+        // holding the minimum corner of their overlap.
+        if(pointKey(overlap.min) == key)
+          addPair(pairs, i, j);
+      }
+    first = last;
+  }
+
+  // Objects kept off the grid are tested against everything
+  unsigned int numLarge = (unsigned int)m_large.size();
+  for(unsigned int a = 0; a < numLarge; ++a)
+  {
+    unsigned int i = m_large[a];
+    for(unsigned int j = 0; j < m_objects.size(); ++j)
+    {
+      if(j == i) continue;
+      // Large-large pairs are seen twice; keep the one with the lower index first
+      if(j < i && std::binary_search(m_large.begin(), m_large.end(), j)) continue;
+      if(testPair(i, j))
+        addPair(pairs, i, j);
+    }
+  }
+}
+
+void UniformGridBroadphase::queryBox(const AABB3 &box, ObjectList &results)
+{
+  results.clear();
+  if(m_objects.empty()) return;
+  ++m_queryStamp;
+
+  for(unsigned int a = 0; a < m_large.size(); ++a)
+    if(testBox(m_large[a], box))
+      report(m_large[a], results);
+
+  // Only the part of the box inside the occupied region can find anything
+  AABB3 clipped;
+  if(!AABB3::intersect(box, m_bounds, &clipped)) return;
+  int x0 = cellCoord(clipped.min.x), x1 = cellCoord(clipped.max.x);
+  int y0 = cellCoord(clipped.min.y), y1 = cellCoord(clipped.max.y);
+  int z0 = cellCoord(clipped.min.z), z1 = cellCoord(clipped.max.z);
+  for(int x = x0; x <= x1; ++x)
+    for(int y = y0; y <= y1; ++y)
+      for(int z = z0; z <= z1; ++z)
+        collectCell(makeKey(x, y, z), box, results);
+}
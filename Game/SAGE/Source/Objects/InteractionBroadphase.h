@@ -0,0 +1,185 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file InteractionBroadphase.h
+/// \brief Interface for the interaction broadphase classes.
+
+#ifndef __INTERACTIONBROADPHASE_H_INCLUDED__
+#define __INTERACTIONBROADPHASE_H_INCLUDED__
+
+#include <vector>
+#include "Common/AABB3.h"
+
+class GameObject;
+
+/// \brief Culls object interaction tests down to candidates whose bounding boxes may overlap.
+///
+/// A broadphase is rebuilt from scratch every frame:  call clear(), insert() every object
+/// that should take part, then build().  After that, findPairs() reports all pairs of
+/// inserted objects whose boxes overlap, and queryBox() reports the inserted
+/// objects that a box may touch.  Object pointers are never dereferenced
+/// by the broadphase; the boxes passed to insert() are copied.
+///
+/// Derived classes choose the spatial structure.  All of them keep count of the
+/// box-box tests performed since the last clear(), which is handy for profiling.
+class InteractionBroadphase
+{
+  public:
+    /// \brief Two objects whose bounding boxes overlap.
+    struct Pair
+    {
+      GameObject *first;  ///< First object of the pair.
+      GameObject *second; ///< Second object of the pair.
+    };
+    typedef std::vector<Pair> PairList;           ///< Output list for findPairs().
+    typedef std::vector<GameObject *> ObjectList; ///< Output list for queries.
+
+    InteractionBroadphase();
+    virtual ~InteractionBroadphase() {}
+
+    virtual const char *getName() const = 0; ///< Queries the broadphase for a short descriptive name.
+
+    virtual void clear(); ///< Removes all objects and resets the statistics.
+    void insert(GameObject *object, const AABB3 &box); ///< Adds an object with the given bounding box.
+    virtual void build() = 0; ///< Prepares the structure after all objects have been inserted.
+
+    /// \brief Finds all pairs of inserted objects whose boxes overlap.
+    /// \param pairs Receives the pairs; previous contents are discarded.
+    virtual void findPairs(PairList &pairs) = 0;
+
+    /// \brief Finds all inserted objects whose boxes overlap a box.
+    /// \param box Specifies the query box.
+    /// \param results Receives the objects; previous contents are discarded.
+    virtual void queryBox(const AABB3 &box, ObjectList &results) = 0;
+
+    unsigned int getObjectCount() const { return (unsigned int)m_objects.size(); } ///< Queries the number of inserted objects.
+    unsigned int getPairsTested() const { return m_pairsTested; } ///< Queries the number of box tests performed since clear().
+    unsigned int getPairsFound() const { return m_pairsFound; } ///< Queries the number of pairs and candidates reported since clear().
+
+  protected:
+    std::vector<GameObject *> m_objects; ///< Inserted objects.
+    std::vector<AABB3> m_boxes;          ///< Bounding boxes of the inserted objects, by index.
+    AABB3 m_bounds;                      ///< Union of all inserted boxes.
+    unsigned int m_pairsTested;          ///< Box-box tests performed since clear().
+    unsigned int m_pairsFound;           ///< Pairs and candidates reported since clear().
+
+    /// \brief Tests two inserted boxes for overlap, counting the test.
+    bool testPair(unsigned int i, unsigned int j);
+    /// \brief Tests an inserted box against an arbitrary box, counting the test.
+    bool testBox(unsigned int i, const AABB3 &box);
+    /// \brief Appends a pair of inserted objects to a pair list.
+    void addPair(PairList &pairs, unsigned int i, unsigned int j);
+};
+
+/// \brief Tests every object against every other object.
+///
+/// Reproduces the original Theta(n^2) behavior; mainly useful as a reference
+/// when checking the other broadphases.
+class BruteForceBroadphase : public InteractionBroadphase
+{
+  public:
+    virtual const char *getName() const { return "brute"; }
+    virtual void build() {}
+    virtual void findPairs(PairList &pairs);
+    virtual void queryBox(const AABB3 &box, ObjectList &results);
+};
+
+/// \brief Sorts objects along the x-axis and sweeps over the sorted intervals.
+///
+/// Works well when objects are spread out along x; degrades gracefully to
+/// brute force when they are not.
+class SweepAndPruneBroadphase : public InteractionBroadphase
+{
+  public:
+    virtual const char *getName() const { return "sap"; }
+    virtual void build();
+    virtual void findPairs(PairList &pairs);
+    virtual void queryBox(const AABB3 &box, ObjectList &results);
+
+  private:
+    /// \brief Orders object indices by the minimum x-coordinate of their boxes.
+    struct MinXLess
+    {
+      const std::vector<AABB3> *boxes;
+      bool operator()(unsigned int a, unsigned int b) const { return (*boxes)[a].min.x < (*boxes)[b].min.x; }
+    };
+
+    std::vector<unsigned int> m_sorted; ///< Object indices sorted by box.min.x.
+};
+
+/// \brief Buckets objects into a uniform grid of cubic cells (a spatial hash).
+///
+/// Each object is entered into every cell its box touches.  Pairs are only tested
+/// between objects sharing a cell, and box queries only look at the cells they cover.
+/// Objects whose boxes cover too many cells are kept on a separate list and tested
+/// against everything.  The cell size should be a little larger than a typical object.
+class UniformGridBroadphase : public InteractionBroadphase
+{
+  public:
+    UniformGridBroadphase(float cellSize = 16.0f); ///< Constructs a grid with the given cell size.
+
+    virtual const char *getName() const { return "grid"; }
+    virtual void clear();
+    virtual void build();
+    virtual void findPairs(PairList &pairs);
+    virtual void queryBox(const AABB3 &box, ObjectList &results);
+
+    void setCellSize(float cellSize); ///< Sets the edge length of a cell.  Takes effect at the next build().
+    float getCellSize() const { return m_cellSize; } ///< Queries the edge length of a cell.
+
+  private:
+    typedef unsigned long long CellKey; ///< Packed integer cell coordinates.
+
+    /// \brief One object's membership in one cell.
+    struct Entry
+    {
+      CellKey key;        ///< Cell containing the object.
+      unsigned int index; ///< Index of the object.
+      bool operator<(const Entry &e) const { return key < e.key || (key == e.key && index < e.index); }
+    };
+
+    int cellCoord(float v) const; ///< Converts a world coordinate to a cell coordinate.
+    static CellKey makeKey(int x, int y, int z); ///< Packs cell coordinates into a key.
+    CellKey pointKey(const Vector3 &p) const; ///< Computes the key of the cell containing a point.
+    /// \brief Finds the run of entries in a cell.
+    bool findCell(CellKey key, unsigned int &first, unsigned int &last) const;
+    /// \brief Reports every not yet reported object in a cell that overlaps a box.
+    void collectCell(CellKey key, const AABB3 &box, ObjectList &results);
+    /// \brief Reports an object once per query.
+    void report(unsigned int index, ObjectList &results);
+
+    float m_cellSize;                    ///< Edge length of a cell.
+    float m_invCellSize;                 ///< Reciprocal of the cell size.
+    std::vector<Entry> m_entries;        ///< Cell memberships, sorted by key.
+    std::vector<unsigned int> m_large;   ///< Objects that cover too many cells.
+    std::vector<unsigned int> m_stamps;  ///< Per-object query stamp, for removing duplicates.
+    unsigned int m_queryStamp;           ///< Stamp of the current query.
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file Particle.cpp
+/// \brief Code for the ParticleArrays class.
+
+#include <string.h>
+#include "Particle.h"
+
+ParticleArrays::ParticleArrays():
+m_block(NULL),
+m_nCapacity(0)
+{
+  setPointers();
+}
+
+ParticleArrays::~ParticleArrays()
+{
+  delete [] m_block;
+  m_block = NULL;
+}
+
+/// Any particles already held are discarded.
+/// \param count Number of particles to make room for
+void ParticleArrays::allocate(int count)
+{
+  delete [] m_block;
+
+  m_nCapacity = (count + 3) & ~3;
+  m_block = new float[FIELD_COUNT * m_nCapacity];
+  memset(m_block, 0, FIELD_COUNT * m_nCapacity * sizeof(float));
+  setPointers();
+}
+
+/// Keeps the remaining particles in the same order.
+/// \param index Index of the particle to remove
+/// \param count Number of particles currently held, including the removed one
+void ParticleArrays::remove(int index, int count)
+{
+  int after = count - index - 1;
+  if(after <= 0)
+    return;
+
+  for(int field = 0; field < FIELD_COUNT; field++)
+  {
+    float *array = getField(field);
+    memmove(array + index, array + index + 1, after * sizeof(float));
+  }
+}
+
+/// Survivors are packed to the front in a single pass and keep their order,
+/// so removing many particles at once costs no more than removing one.
+/// \param count Number of particles currently held
+/// \return Number of particles left
+int ParticleArrays::removeExpired(int count)
+{
+  // skip past the particles that stay where they are
+  int kept = 0;
+  while(kept < count && lifeleft[kept] >= 0.0f)
+    kept++;
+
+  for(int i = kept + 1; i < count; i++)
+  {
+    if(lifeleft[i] < 0.0f)
+      continue;
+
+    // moved as integers so the packed color bits survive, as in gather()
+    for(int field = 0; field < FIELD_COUNT; field++)
+    {
+      unsigned int *array = (unsigned int*)getField(field);
+      array[kept] = array[i];
+    }
+    kept++;
+  }
+
+  return kept;
+}
+
+/// \param from Arrays to copy from.  Must not be these arrays.
+/// \param order Index in from of each particle to copy, in the order they
+/// are to be stored here
+/// \param count Number of particles to copy
+void ParticleArrays::gather(const ParticleArrays& from, const int* order, int count)
+{
+  // Copy the bits as integers: color is packed into one of the arrays, and
+  // moving it through float registers can alter NaN patterns
+  for(int field = 0; field < FIELD_COUNT; field++)
+  {
+    const unsigned int *src = (const unsigned int*)from.getField(field);
+    unsigned int *dst = (unsigned int*)getField(field);
+    for(int i = 0; i < count; i++)
+      dst[i] = src[order[i]];
+  }
+}
+
+/// \param other Arrays to exchange contents with
+void ParticleArrays::swap(ParticleArrays& other)
+{
+  float *block = m_block; m_block = other.m_block; other.m_block = block;
+  int capacity = m_nCapacity; m_nCapacity = other.m_nCapacity; other.m_nCapacity = capacity;
+  setPointers();
+  other.setPointers();
+}
+
+void ParticleArrays::setPointers()
+{
+  posX = getField(0);
+  posY = getField(1);
+  posZ = getField(2);
+  velX = getField(3);
+  velY = getField(4);
+  velZ = getField(5);
+  lifeleft = getField(6);
+  color = (unsigned int *)getField(7);
+  rotation = getField(8);
+  rotationSpeed = getField(9);
+  rotationStopTime = getField(10);
+}
@@ -28,41 +28,58 @@
 */
 
 /// \file Particle.h
-/// \brief Interface for the Particle class.
+/// \brief Interface for the ParticleArrays class.
 
 #ifndef __PARTICLE_H_INCLUDED__
 #define __PARTICLE_H_INCLUDED__
 
-#include "common/Vector3.h"
-
 //-----------------------------------------------------------------------------
 /// \brief Particle information used by ParticleEffect
 ///
-/// Represents a single particle
-class Particle
+/// Holds a fixed number of particles as parallel arrays, one per attribute,
+/// so that updates stream through memory and can work on four particles at
+/// a time.  The capacity is rounded up to a multiple of four and every
+/// entry starts out zeroed, so SSE loops may run past the last live
+/// particle without a scalar tail.  Size, drag and texture coordinates are
+/// the same for every particle of an effect and live in ParticleEffect.
+class ParticleArrays
 {
-  friend class ParticleEffect;
-
 public:
-  Vector3 position; ///< Position of the particle
-  Vector3 velocity; ///< Velocity of the particle
-  float drag; ///< Rate at which velocity slows
-  float size; ///< Size of the particle
-  unsigned int color; ///< Color value of the particle
-  float lifeleft; ///< Time in seconds until the particle dies
-  bool birthed; ///< Whether this particle has been created (used)
+  ParticleArrays();  ///< Basic constructor
+  ~ParticleArrays(); ///< Basic destructor
+
+  void allocate(int count); ///< Makes room for count particles
+  int getCapacity() const { return m_nCapacity; } ///< Number of particles there is room for
+
+  void remove(int index, int count); ///< Removes a particle, shifting the ones after it down
+  int removeExpired(int count); ///< Removes every particle whose life has run out
+  void gather(const ParticleArrays& from, const int* order, int count); ///< Copies particles in the given order
+  void swap(ParticleArrays& other); ///< Exchanges contents with another set of arrays
+
+  float *posX; ///< X coordinate of the position of each particle
+  float *posY; ///< Y coordinate of the position of each particle
+  float *posZ; ///< Z coordinate of the position of each particle
+  float *velX; ///< X component of the velocity of each particle
+  float *velY; ///< Y component of the velocity of each particle
+  float *velZ; ///< Z component of the velocity of each particle
+  float *lifeleft; ///< Time in seconds until each particle dies
+  unsigned int *color; ///< Color value of each particle
+  float *rotation; ///< Current rotation of each particle
+  float *rotationSpeed; ///< Speed at which each particle rotates (in radians/sec)
+  float *rotationStopTime; ///< Time until each particle's rotation stops
+
+private:
+  enum { FIELD_COUNT = 11 }; ///< Number of arrays above
 
-  float rotation; ///< Current rotation of the particle
-  float rotationSpeed; ///< Speed at which the particle rotates (in radians/sec)
-  float rotationStopTime; ///< Time until rotation stops
+  float *m_block; ///< One allocation holding all the arrays back to back
+  int m_nCapacity; ///< Entries in each array
 
-  float uLeft; ///< Texture coords of the particle (top left)
-  float uRight; ///< Texture coords of the particle (top right)
-  float vTop; ///< Texture coords of the particle (bottom left)
-  float vBottom; ///< Texture coords of the particle (bottom right)
+  float *getField(int field) const { return m_block + field * m_nCapacity; }
+  void setPointers(); ///< Points the arrays into m_block
 
-  float distance; ///< Used by the effect class for sorting
+  ParticleArrays(const ParticleArrays&); ///< Not copyable
+  ParticleArrays& operator=(const ParticleArrays&); ///< Not copyable
 };
 //-----------------------------------------------------------------------------
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,186 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file ParticleBillboards.cpp
+/// \brief Code for the ParticleBillboards class.
+
+#include <math.h>
+#include "ParticleBillboards.h"
+#include "Particle.h"
+#include "common/Vector3.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define PARTICLEBILLBOARDS_SSE
+#include <emmintrin.h>
+#endif
+
+/// \brief Writes the quad of one particle.
+/// \param out First of the four vertices to write
+/// \param x X coordinate of the particle
+/// \param y Y coordinate of the particle
+/// \param z Z coordinate of the particle
+/// \param color Color of the particle
+/// \param a Offset from the center to the upper left corner
+/// \param b Offset from the center to the upper right corner
+static inline void writeQuad(BillboardVertex *out, float x, float y, float z,
+  unsigned int color, const float a[3], const float b[3])
+{
+  // the bottom corners mirror the top ones through the center
+  out[0].x = x + a[0]; out[0].y = y + a[1]; out[0].z = z + a[2];
+  out[0].argb = color; out[0].u = 0.0f; out[0].v = 0.0f;
+
+  out[1].x = x + b[0]; out[1].y = y + b[1]; out[1].z = z + b[2];
+  out[1].argb = color; out[1].u = 1.0f; out[1].v = 0.0f;
+
+  out[2].x = x - b[0]; out[2].y = y - b[1]; out[2].z = z - b[2];
+  out[2].argb = color; out[2].u = 0.0f; out[2].v = 1.0f;
+
+  out[3].x = x - a[0]; out[3].y = y - a[1]; out[3].z = z - a[2];
+  out[3].argb = color; out[3].u = 1.0f; out[3].v = 1.0f;
+}
+
+#ifdef PARTICLEBILLBOARDS_SSE
+/// \brief Sine and cosine of four angles.
+///
+/// The angles are wrapped into [-pi,pi] and folded into [-pi/2,pi/2],
+/// where a degree 11 polynomial is good to about 1e-6.
+/// \param angle Angles in radians
+/// \param s Receives the sines
+/// \param c Receives the cosines
+static inline void sinCos(__m128 angle, __m128 &s, __m128 &c)
+{
+  const __m128 twoPi = _mm_set1_ps(6.28318531f);
+  const __m128 oneOverTwoPi = _mm_set1_ps(0.159154943f);
+  const __m128 pi = _mm_set1_ps(3.14159265f);
+  const __m128 piOverTwo = _mm_set1_ps(1.57079633f);
+  const __m128 signBit = _mm_set1_ps(-0.0f);
+
+  // wrap to [-pi,pi]
+  __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, oneOverTwoPi)));
+  __m128 x = _mm_sub_ps(angle, _mm_mul_ps(turns, twoPi));
+
+  // sin(x) = sin(pi - x), so fold |x| > pi/2 back towards zero
+  __m128 sign = _mm_and_ps(x, signBit);
+  __m128 absX = _mm_andnot_ps(signBit, x);
+  __m128 fold = _mm_cmpgt_ps(absX, piOverTwo);
+  __m128 sx = _mm_or_ps(sign, _mm_or_ps(
+    _mm_and_ps(fold, _mm_sub_ps(pi, absX)), _mm_andnot_ps(fold, absX)));
+
+  // cos(x) = sin(pi/2 - |x|), which is already in range
+  __m128 cx = _mm_sub_ps(piOverTwo, absX);
+
+  const __m128 c3 = _mm_set1_ps(-1.66666667e-1f);
+  const __m128 c5 = _mm_set1_ps(8.33333333e-3f);
+  const __m128 c7 = _mm_set1_ps(-1.98412698e-4f);
+  const __m128 c9 = _mm_set1_ps(2.75573192e-6f);
+  const __m128 c11 = _mm_set1_ps(-2.50521084e-8f);
+
+  __m128 x2 = _mm_mul_ps(sx, sx);
+  __m128 p = _mm_add_ps(_mm_mul_ps(c11, x2), c9);
+  p = _mm_add_ps(_mm_mul_ps(p, x2), c7);
+  p = _mm_add_ps(_mm_mul_ps(p, x2), c5);
+  p = _mm_add_ps(_mm_mul_ps(p, x2), c3);
+  s = _mm_add_ps(sx, _mm_mul_ps(_mm_mul_ps(p, x2), sx));
+
+  x2 = _mm_mul_ps(cx, cx);
+  p = _mm_add_ps(_mm_mul_ps(c11, x2), c9);
+  p = _mm_add_ps(_mm_mul_ps(p, x2), c7);
+  p = _mm_add_ps(_mm_mul_ps(p, x2), c5);
+  p = _mm_add_ps(_mm_mul_ps(p, x2), c3);
+  c = _mm_add_ps(cx, _mm_mul_ps(_mm_mul_ps(p, x2), cx));
+}
+#endif
+
+/// Turning the camera axes by an angle t gives right' = right*cos(t) +
+/// up*sin(t) and up' = up*cos(t) - right*sin(t). The upper left corner is
+/// then (up' - right')*halfSize and the upper right (up' + right')*halfSize,
+/// which works out to one multiply-add per axis for each corner.
+/// \param particles Particles to expand
+/// \param count Number of particles, from the front of the arrays
+/// \param right Camera right vector
+/// \param up Camera up vector
+/// \param halfSize Half the width of a quad
+/// \param out Receives 4*count vertices, written in order
+void ParticleBillboards::expand(const ParticleArrays &particles, int count,
+  const Vector3 &right, const Vector3 &up, float halfSize,
+  BillboardVertex *out)
+{
+  int i = 0;
+
+#ifdef PARTICLEBILLBOARDS_SSE
+  __m128 half = _mm_set1_ps(halfSize);
+  __m128 rightX = _mm_set1_ps(right.x), rightY = _mm_set1_ps(right.y), rightZ = _mm_set1_ps(right.z);
+  __m128 upX = _mm_set1_ps(up.x), upY = _mm_set1_ps(up.y), upZ = _mm_set1_ps(up.z);
+
+  // corner offsets for four particles, stored by component
+  float corners[6][4];
+
+  // the arrays are padded to a multiple of four, so reading a whole group
+  // past count is safe; only count particles are written
+  for(; i < count; i += 4)
+  {
+    __m128 s, c;
+    sinCos(_mm_loadu_ps(particles.rotation + i), s, c);
+    __m128 plus = _mm_mul_ps(_mm_add_ps(c, s), half);
+    __m128 minus = _mm_mul_ps(_mm_sub_ps(c, s), half);
+
+    // a = up*minus - right*plus, b = up*plus + right*minus
+    _mm_storeu_ps(corners[0], _mm_sub_ps(_mm_mul_ps(upX, minus), _mm_mul_ps(rightX, plus)));
+    _mm_storeu_ps(corners[1], _mm_sub_ps(_mm_mul_ps(upY, minus), _mm_mul_ps(rightY, plus)));
+    _mm_storeu_ps(corners[2], _mm_sub_ps(_mm_mul_ps(upZ, minus), _mm_mul_ps(rightZ, plus)));
+    _mm_storeu_ps(corners[3], _mm_add_ps(_mm_mul_ps(upX, plus), _mm_mul_ps(rightX, minus)));
+    _mm_storeu_ps(corners[4], _mm_add_ps(_mm_mul_ps(upY, plus), _mm_mul_ps(rightY, minus)));
+    _mm_storeu_ps(corners[5], _mm_add_ps(_mm_mul_ps(upZ, plus), _mm_mul_ps(rightZ, minus)));
+
+    int group = count - i < 4 ? count - i : 4;
+    for(int j = 0; j < group; j++)
+    {
+      float a[3] = {corners[0][j], corners[1][j], corners[2][j]};
+      float b[3] = {corners[3][j], corners[4][j], corners[5][j]};
+      writeQuad(out, particles.posX[i+j], particles.posY[i+j], particles.posZ[i+j],
+        particles.color[i+j], a, b);
+      out += 4;
+    }
+  }
+#else
+  for(; i < count; i++)
+  {
+    float s = sinf(particles.rotation[i]);
+    float c = cosf(particles.rotation[i]);
+    float plus = (c + s) * halfSize;
+    float minus = (c - s) * halfSize;
+
+    float a[3] = {up.x*minus - right.x*plus, up.y*minus - right.y*plus, up.z*minus - right.z*plus};
+    float b[3] = {up.x*plus + right.x*minus, up.y*plus + right.y*minus, up.z*plus + right.z*minus};
+    writeQuad(out, particles.posX[i], particles.posY[i], particles.posZ[i],
+      particles.color[i], a, b);
+    out += 4;
+  }
+#endif
+}
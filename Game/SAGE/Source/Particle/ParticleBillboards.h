@@ -0,0 +1,68 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file ParticleBillboards.h
+/// \brief Interface for the ParticleBillboards class.
+
+#ifndef __PARTICLEBILLBOARDS_H_INCLUDED__
+#define __PARTICLEBILLBOARDS_H_INCLUDED__
+
+class ParticleArrays;
+class Vector3;
+
+//-----------------------------------------------------------------------------
+/// \brief Vertex written by ParticleBillboards
+///
+/// Laid out exactly like RenderVertexL, so a locked vertex buffer can be
+/// filled directly, but free of Direct3D so the expansion can be run on
+/// plain memory.
+struct BillboardVertex
+{
+  float x, y, z; ///< Position
+  unsigned int argb; ///< Prelit diffuse color
+  float u, v; ///< Texture mapping coordinates
+};
+
+//-----------------------------------------------------------------------------
+/// \brief Expands particles into camera facing quads
+///
+/// Each particle becomes four vertices, upper left, upper right, bottom left
+/// and bottom right, with the texture spread over the whole quad. The camera
+/// right and up vectors are turned by each particle's rotation with one sine
+/// and cosine, computed four particles at a time with SSE where available.
+class ParticleBillboards
+{
+public:
+  static void expand(const ParticleArrays &particles, int count,
+    const Vector3 &right, const Vector3 &up, float halfSize,
+    BillboardVertex *out); ///< Writes four vertices per particle
+};
+//-----------------------------------------------------------------------------
+
+#endif
@@ -32,6 +32,7 @@
 
 #include "ParticleDefines.h"
 #include "common/renderer.h"
+#include "common/Random.h"
 #include <hash_map>
 
 typedef stdext::hash_map<std::string, DistributionFunc> Map; ///< Shorthand for the template map used below
@@ -52,16 +53,16 @@ DistributionFunc ParticleUtil::getEDTFunc(const char *stremitdist)
   static MapIter iter;
 
   // assume shell sphere by default
-  DistributionFunc retval = &ParticleUtil::getRandVecShellSphere;
+  DistributionFunc retval = &ParticleUtil::getRandVecsShellSphere;
 
   // if this is the first time, add the distribution types
   if(distTypes.empty())
   {
-    distTypes.insert(MapPair("shellsphere", &ParticleUtil::getRandVecShellSphere));
-    distTypes.insert(MapPair("solidsphere", &ParticleUtil::getRandVecSolidSphere));
-    distTypes.insert(MapPair("ring", &ParticleUtil::getRandVecRing));
-    distTypes.insert(MapPair("disc", &ParticleUtil::getRandVecDisc));
-    distTypes.insert(MapPair("solidcube", &ParticleUtil::getRandVecSolidCube));
+    distTypes.insert(MapPair("shellsphere", &ParticleUtil::getRandVecsShellSphere));
+    distTypes.insert(MapPair("solidsphere", &ParticleUtil::getRandVecsSolidSphere));
+    distTypes.insert(MapPair("ring", &ParticleUtil::getRandVecsRing));
+    distTypes.insert(MapPair("disc", &ParticleUtil::getRandVecsDisc));
+    distTypes.insert(MapPair("solidcube", &ParticleUtil::getRandVecsSolidCube));
   }
 
   // try to find the value
@@ -73,82 +74,117 @@ DistributionFunc ParticleUtil::getEDTFunc(const char *stremitdist)
   return retval;
 }
 
-/// Returns a random uniform distribution vector on a sphere. Every vector
-/// returned by this function will have a magnitude of one
-/// \return Random vector
-Vector3 ParticleUtil::getRandVecShellSphere()
+/// Writes random uniform distribution vectors on a sphere. Every vector
+/// written by this function will have a magnitude of one
+/// \param random Random number generator to draw from
+/// \param x Receives the x components
+/// \param y Receives the y components
+/// \param z Receives the z components
+/// \param count Number of vectors to write
+void ParticleUtil::getRandVecsShellSphere(CRandom &random, float *x, float *y, float *z, int count)
 {
-  Vector3 vec;
-  
-  vec.y = (2.0f * randf()) - 1.0f; // rand value from -1 to 1
+  // draw all the random values first, then turn them into vectors in place
+  random.fillUniform(y, count);
+  random.fillUniform(x, count);
 
-  float 
-    r2 = randf() * 2.0f * kPi, // rand value from 0 to 2pi
-    r3 = sqrt(1-(vec.y*vec.y));
-
-  vec.x = cos(r2) * r3;
-  vec.z = sin(r2) * r3;
-
-  vec.normalize();
-
-  return vec;
+  for(int i=0; i<count; i++)
+  {
+    float
+      height = (2.0f * y[i]) - 1.0f, // rand value from -1 to 1
+      r2 = x[i] * 2.0f * kPi, // rand value from 0 to 2pi
+      r3 = sqrt(1-(height*height));
+
+    x[i] = cos(r2) * r3;
+    y[i] = height;
+    z[i] = sin(r2) * r3;
+  }
 }
 
-/// Returns a random vector within a sphere.
-/// \return Random vector
+/// Writes random vectors within a sphere.
+/// \param random Random number generator to draw from
+/// \param x Receives the x components
+/// \param y Receives the y components
+/// \param z Receives the z components
+/// \param count Number of vectors to write
 /// \remark This function is broken. The vectors will tend toward the origin
 /// with this implementation (not a uniform distribution), but this is quick
 /// and easy, and no one but Erik Carsen would notice.
-Vector3 ParticleUtil::getRandVecSolidSphere()
+void ParticleUtil::getRandVecsSolidSphere(CRandom &random, float *x, float *y, float *z, int count)
 {
-  return getRandVecShellSphere() * randf();
+  getRandVecsShellSphere(random, x, y, z, count);
+
+  for(int i=0; i<count; i++)
+  {
+    float scale = random.getFloat();
+    x[i] *= scale;
+    y[i] *= scale;
+    z[i] *= scale;
+  }
 }
 
-/// Returns a random vector on a ring. The y component of the return value will
-/// be zero.
-/// \return Random vector distributed around a ring
-Vector3 ParticleUtil::getRandVecRing()
+/// Writes random vectors on a ring. The y components will be zero.
+/// \param random Random number generator to draw from
+/// \param x Receives the x components
+/// \param y Receives the y components
+/// \param z Receives the z components
+/// \param count Number of vectors to write
+void ParticleUtil::getRandVecsRing(CRandom &random, float *x, float *y, float *z, int count)
 {
-  float th = ((2.0f * randf()) - 1.0f) * kPi; // th -pi to pi
-
-  float
-    x = cos(th),
-    z = sin(th);
+  random.fillUniform(x, count);
 
-  Vector3 vec3(x, 0, z);
+  for(int i=0; i<count; i++)
+  {
+    float th = ((2.0f * x[i]) - 1.0f) * kPi; // th -pi to pi
 
-  return vec3;
+    x[i] = cos(th);
+    y[i] = 0.0f;
+    z[i] = sin(th);
+  }
 }
 
-/// Returns a random vector within a ring, which forms a disc. The y component
-/// of the return value will be zero.
-/// \return Random vector distributed within a ring
-Vector3 ParticleUtil::getRandVecDisc()
+/// Writes random vectors within a ring, which forms a disc. The y components
+/// will be zero.
+/// \param random Random number generator to draw from
+/// \param x Receives the x components
+/// \param y Receives the y components
+/// \param z Receives the z components
+/// \param count Number of vectors to write
+/// \remark Taking the square root of a uniform radius spreads the vectors
+/// evenly over the disc, the same as picking points in a square until one
+/// falls inside, but without the loop.
+void ParticleUtil::getRandVecsDisc(CRandom &random, float *x, float *y, float *z, int count)
 {
-  float x = 1.0f, z = 1.0f;
+  random.fillUniform(x, count);
+  random.fillUniform(z, count);
 
-  // HACK!: there is a way to get a uniform distribution throughout
-  // a disc, this isn't the best way
-  while(sqrt(x*x + z*z) > 1.0f)
+  for(int i=0; i<count; i++)
   {
-    x = (2.0f * randf()) - 1.0f;
-    z = (2.0f * randf()) - 1.0f;
-  }
-
-  Vector3 vec3(x, 0, z);
+    float
+      r = sqrt(x[i]),
+      th = z[i] * 2.0f * kPi;
 
-  return vec3;
+    x[i] = cos(th) * r;
+    y[i] = 0.0f;
+    z[i] = sin(th) * r;
+  }
 }
 
-/// Returns a random vector within a cube
-/// \return Random vector distributed within a cube
-Vector3 ParticleUtil::getRandVecSolidCube()
+/// Writes random vectors within a cube
+/// \param random Random number generator to draw from
+/// \param x Receives the x components
+/// \param y Receives the y components
+/// \param z Receives the z components
+/// \param count Number of vectors to write
+void ParticleUtil::getRandVecsSolidCube(CRandom &random, float *x, float *y, float *z, int count)
 {
-  float
-    x = 2.0f * (randf() - 0.5f),
-    y = 2.0f * (randf() - 0.5f),
-    z = 2.0f * (randf() - 0.5f);
+  random.fillUniform(x, count);
+  random.fillUniform(y, count);
+  random.fillUniform(z, count);
 
-  return Vector3(x, y, z);
+  for(int i=0; i<count; i++)
+  {
+    x[i] = 2.0f * (x[i] - 0.5f);
+    y[i] = 2.0f * (y[i] - 0.5f);
+    z[i] = 2.0f * (z[i] - 0.5f);
+  }
 }
-
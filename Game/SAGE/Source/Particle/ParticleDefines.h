@@ -37,8 +37,11 @@
 #include "common/Vector3.h"
 #include <string>
 
-/// \brief Describes a function to be used to get inital particle velocities
-typedef Vector3(*DistributionFunc)();
+class CRandom;
+
+/// \brief Describes a function to be used to get inital particle velocities.
+/// It writes count random directions, one component to each array.
+typedef void (*DistributionFunc)(CRandom &random, float *x, float *y, float *z, int count);
 
 /// \brief Enumerated particle distribution shapes
 enum EmitDistributionType
@@ -56,30 +59,25 @@ class ParticleUtil
 {
 public:
 
-  //------------------------------------------------------------
-  /// \brief Returns a random value between 0 and 1
-  /// \return A random value between 0 and 1
-  static float randf() { return ((float)rand() / (float)RAND_MAX); }
-
   /// \brief Particle distribution functions
   //@{
   /// \brief Returns the distribution function pointer for the given string
   static DistributionFunc getEDTFunc(const char* edt);
 
-  /// \brief Returns a uniform distribution random vector on a sphere
-  static Vector3 getRandVecShellSphere();
+  /// \brief Writes uniform distribution random vectors on a sphere
+  static void getRandVecsShellSphere(CRandom &random, float *x, float *y, float *z, int count);
 
-  /// \brief Returns a uniform distribution random vector within a sphere
-  static Vector3 getRandVecSolidSphere();
+  /// \brief Writes random vectors within a sphere
+  static void getRandVecsSolidSphere(CRandom &random, float *x, float *y, float *z, int count);
 
-  /// \brief Returns a uniform distribution random vector on a ring
-  static Vector3 getRandVecRing();
+  /// \brief Writes uniform distribution random vectors on a ring
+  static void getRandVecsRing(CRandom &random, float *x, float *y, float *z, int count);
 
-  /// \brief Returns a uniform distribution random vector within a ring (disc)
-  static Vector3 getRandVecDisc();
+  /// \brief Writes uniform distribution random vectors within a ring (disc)
+  static void getRandVecsDisc(CRandom &random, float *x, float *y, float *z, int count);
 
-  /// \brief Returns a uniform distribution random vector within a cube
-  static Vector3 getRandVecSolidCube();
+  /// \brief Writes uniform distribution random vectors within a cube
+  static void getRandVecsSolidCube(CRandom &random, float *x, float *y, float *z, int count);
   //@}
   //------------------------------------------------------------
 };
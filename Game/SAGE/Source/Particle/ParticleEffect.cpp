@@ -34,13 +34,16 @@
 #include "ParticleEngine.h"
 #include "ParticleDefines.h"
 #include "Particle.h"
-#include "common/Quaternion.h"
-#include "common/RotationMatrix.h"
+#include "ParticleBillboards.h"
 #include "directorymanager/directorymanager.h"
-#include "common/RotationMatrix.h"
 #include "common/Renderer.h"
 #include "common/commonstuff.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define PARTICLEEFFECT_SSE
+#include <emmintrin.h>
+#endif
+
 extern LPDIRECT3DDEVICE9 pD3DDevice; ///< Global DirectX device
 
 //-----------------------------------------------------------------------------
@@ -114,6 +117,7 @@ ParticleEffect::ParticleEffect(TiXmlElement *effectDef)
   m_bIsDead = false;
   m_IsDying = false;
   m_nLiveParticleCount = 0;
+  m_nBirthCount = 0;
   m_fEmitPartial = 1.0f; // start with at least one particle
   m_vecGravity = Vector3::kZeroVector;
   m_vecPosition = Vector3::kZeroVector;
@@ -134,6 +138,7 @@ ParticleEffect::ParticleEffect(TiXmlElement *effectDef)
   // default emit rate is all at once (or at least all in the first .01 secs)
   m_nEmitRate = m_nTotalParticleCount * 100;
   m_sort = false;
+  m_sortMode = ParticleSorter::SORT_INSERTION;
 
   m_vertBuffer = NULL;
   m_indexBuffer = NULL;
@@ -145,11 +150,16 @@ ParticleEffect::ParticleEffect(TiXmlElement *effectDef)
   // initialize effect properties from the xml tag
   initProperties(effectDef);
 
-  // allocate memory needed
-  m_Particles = new Particle[m_nTotalParticleCount];
-  m_drawOrder = new int[m_nTotalParticleCount];
-
-  initParticles();
+  // allocate memory needed; the sorting buffers only if we sort
+  m_particles.allocate(m_nTotalParticleCount);
+  m_drawOrder = NULL;
+  m_sortDistance = NULL;
+  if(m_sort)
+  {
+    m_sortedParticles.allocate(m_nTotalParticleCount);
+    m_drawOrder = new int[m_nTotalParticleCount];
+    m_sortDistance = new float[m_nTotalParticleCount];
+  }
 
   // create vertex and index buffers, and initialize index buffer. We can
   // create the index buffer as static since it doesn't change values; this
@@ -169,18 +179,18 @@ ParticleEffect::ParticleEffect(TiXmlElement *effectDef)
 
 ParticleEffect::~ParticleEffect()
 {
-  if(m_Particles != NULL)
-  {
-    delete[] m_Particles;
-    m_Particles = NULL;
-  }
-
   if(m_drawOrder != NULL)
   {
     delete[] m_drawOrder;
     m_drawOrder = NULL;
   }
 
+  if(m_sortDistance != NULL)
+  {
+    delete[] m_sortDistance;
+    m_sortDistance = NULL;
+  }
+
   if(m_vertBuffer != NULL)
   {
     delete m_vertBuffer;
@@ -252,30 +262,16 @@ void ParticleEffect::initProperties(TiXmlElement *effectDef)
   }
 }
 
-void ParticleEffect::initParticles()
+/// \param seed Seed for the random numbers used to create particles
+void ParticleEffect::start(unsigned int seed)
 {
-  // initialize draw order to straight through
-  for(int i=0; i<m_nTotalParticleCount; i++)
-  {
-    m_drawOrder[i] = i;
-    
-    m_Particles[i].birthed = false;
-    m_Particles[i].size = 1.0f;
-
-    m_Particles[i].vTop = m_Particles[i].uLeft = 0.0f;
-    m_Particles[i].vBottom = m_Particles[i].uRight = 1.0f;
-
-    m_Particles[i].rotation = 0.0f;
-  }
-}
+  m_random.seed(seed);
 
-void ParticleEffect::start()
-{
-  initParticles();
   m_bIsDead = false;
   m_IsDying = false;
 
   m_nLiveParticleCount = 0;
+  m_nBirthCount = 0;
   m_fEmitPartial = 1.0f;
 }
 
@@ -289,17 +285,48 @@ void ParticleEffect::update(float elapsedTime)
   killParticles();  // cull old particles
   birthParticles(); // create new particles
 
+  // Here we use v = v + gt - vdt where v is velocity, g is gravity and d is
+  // drag. This is a bad approximation but it works.
+  // We also use p = p + vt, again this is a bad approximation, but fast
+  ParticleArrays &p = m_particles;
+  float t = m_fElapsedTime;
+  float drag = m_fPIDragValue;
+
+#ifdef PARTICLEEFFECT_SSE
+  // four at a time; the arrays are padded, so the last group may include
+  // dead particles, which is harmless
+  __m128 t4 = _mm_set1_ps(t);
+  __m128 drag4 = _mm_set1_ps(drag);
+  __m128 gx = _mm_set1_ps(m_vecGravity.x);
+  __m128 gy = _mm_set1_ps(m_vecGravity.y);
+  __m128 gz = _mm_set1_ps(m_vecGravity.z);
+
+  for(int i=0; i<m_nLiveParticleCount; i+=4)
+  {
+    __m128 vx = _mm_loadu_ps(p.velX + i);
+    __m128 vy = _mm_loadu_ps(p.velY + i);
+    __m128 vz = _mm_loadu_ps(p.velZ + i);
+    vx = _mm_add_ps(vx, _mm_mul_ps(_mm_sub_ps(gx, _mm_mul_ps(vx, drag4)), t4));
+    vy = _mm_add_ps(vy, _mm_mul_ps(_mm_sub_ps(gy, _mm_mul_ps(vy, drag4)), t4));
+    vz = _mm_add_ps(vz, _mm_mul_ps(_mm_sub_ps(gz, _mm_mul_ps(vz, drag4)), t4));
+    _mm_storeu_ps(p.velX + i, vx);
+    _mm_storeu_ps(p.velY + i, vy);
+    _mm_storeu_ps(p.velZ + i, vz);
+    _mm_storeu_ps(p.posX + i, _mm_add_ps(_mm_loadu_ps(p.posX + i), _mm_mul_ps(vx, t4)));
+    _mm_storeu_ps(p.posY + i, _mm_add_ps(_mm_loadu_ps(p.posY + i), _mm_mul_ps(vy, t4)));
+    _mm_storeu_ps(p.posZ + i, _mm_add_ps(_mm_loadu_ps(p.posZ + i), _mm_mul_ps(vz, t4)));
+  }
+#else
   for(int i=0; i<m_nLiveParticleCount; i++)
   {
-    Particle *part = &(m_Particles[m_drawOrder[i]]);
-
-    // Here we use v = v + gt - vdt where v is velocity, g is gravity and d is
-    // drag. This is a bad approximation but it works.
-    // We also use p = p + vt, again this is a bad approximation, but fast
-    part->velocity +=
-      (m_vecGravity - part->velocity * part->drag) * m_fElapsedTime;
-    part->position += part->velocity * m_fElapsedTime;
+    p.velX[i] += (m_vecGravity.x - p.velX[i] * drag) * t;
+    p.velY[i] += (m_vecGravity.y - p.velY[i] * drag) * t;
+    p.velZ[i] += (m_vecGravity.z - p.velZ[i] * drag) * t;
+    p.posX[i] += p.velX[i] * t;
+    p.posY[i] += p.velY[i] * t;
+    p.posZ[i] += p.velZ[i] * t;
   }
+#endif
 
   // call additional update functions
   for(UpdateFuncIter iter = m_UpdateFunc.begin(); iter != m_UpdateFunc.end(); iter++)
@@ -316,17 +343,51 @@ void ParticleEffect::update(float elapsedTime)
 /// to a value of 0, reaching 0 when lifeleft reaches 0.
 void ParticleEffect::updateFade()
 {
-  Particle *part = NULL; // shorthand for the current particle
+  ParticleArrays &p = m_particles;
   int maxAlpha = (int)(255.0f * m_PIFadeMax); // precalculate max alpha
 
+#ifdef PARTICLEEFFECT_SSE
+  // Both ramps are computed for every particle and the right one selected.
+  // A zero fade in (or a fade out of one) makes its scale infinite, but that
+  // ramp is never selected then.
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 zero = _mm_setzero_ps();
+  __m128 alphaLimit = _mm_set1_ps(255.0f);
+  __m128 life = _mm_set1_ps(m_fPILife);
+  __m128 fadeIn = _mm_set1_ps(m_PIFadeIn);
+  __m128 fadeOut = _mm_set1_ps(m_PIFadeOut);
+  __m128 fadeInScale = _mm_set1_ps(255.0f * m_PIFadeMax / m_PIFadeIn);
+  __m128 fadeOutScale = _mm_set1_ps(255.0f * m_PIFadeMax / (1.0f - m_PIFadeOut));
+  __m128 fullAlpha = _mm_set1_ps((float)maxAlpha);
+  __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+
+  for(int i=0; i<m_nLiveParticleCount; i+=4)
+  {
+    // calculate percent of life lived from life left
+    __m128 percentLife = _mm_sub_ps(one, _mm_div_ps(_mm_loadu_ps(p.lifeleft + i), life));
+
+    __m128 fadingIn = _mm_cmplt_ps(percentLife, fadeIn);
+    __m128 fadingOut = _mm_andnot_ps(fadingIn, _mm_cmpgt_ps(percentLife, fadeOut));
+    __m128 alpha = _mm_or_ps(
+      _mm_and_ps(fadingIn, _mm_mul_ps(percentLife, fadeInScale)),
+      _mm_or_ps(
+        _mm_and_ps(fadingOut, _mm_mul_ps(_mm_sub_ps(one, percentLife), fadeOutScale)),
+        _mm_andnot_ps(_mm_or_ps(fadingIn, fadingOut), fullAlpha)));
+    alpha = _mm_min_ps(_mm_max_ps(alpha, zero), alphaLimit);
+
+    __m128i color = _mm_loadu_si128((__m128i*)(p.color + i));
+    color = _mm_or_si128(_mm_and_si128(color, rgbMask),
+      _mm_slli_epi32(_mm_cvttps_epi32(alpha), 24));
+    _mm_storeu_si128((__m128i*)(p.color + i), color);
+  }
+#else
   for(int i=0; i<m_nLiveParticleCount; i++)
   {
-    part = &m_Particles[m_drawOrder[i]];
     int alpha = 0;
     float percentLife = 0;
 
     // calculate percent of life lived from life left
-    percentLife = 1.0f - (part->lifeleft / m_fPILife);
+    percentLife = 1.0f - (p.lifeleft[i] / m_fPILife);
 
     if(percentLife < m_PIFadeIn) // fade in to max alpha value
     {
@@ -346,10 +407,9 @@ void ParticleEffect::updateFade()
     else if(alpha > 255)
       alpha = 255;
 
-    part->color = ((part->color & 0x00FFFFFF) | (alpha << 24));
-
-    part++;
+    p.color[i] = ((p.color[i] & 0x00FFFFFF) | (alpha << 24));
   }
+#endif
 }
 
 
@@ -358,20 +418,37 @@ void ParticleEffect::updateFade()
 /// elapsed and new rotation speed.
 void ParticleEffect::updateRotation()
 {
-  for(int i=0; i<m_nLiveParticleCount; i++)
+  ParticleArrays &p = m_particles;
+
+#ifdef PARTICLEEFFECT_SSE
+  __m128 t = _mm_set1_ps(m_fElapsedTime);
+  __m128 stopTime = _mm_set1_ps(m_PIRotationStopTime);
+  __m128 zero = _mm_setzero_ps();
+
+  for(int i=0; i<m_nLiveParticleCount; i+=4)
   {
-    Particle *part = &m_Particles[m_drawOrder[i]]; // shorthand
+    __m128 timeLeft = _mm_loadu_ps(p.rotationStopTime + i);
+    __m128 angularSpeed = _mm_mul_ps(_mm_loadu_ps(p.rotationSpeed + i),
+      _mm_div_ps(timeLeft, stopTime));
 
+    _mm_storeu_ps(p.rotation + i,
+      _mm_add_ps(_mm_loadu_ps(p.rotation + i), _mm_mul_ps(angularSpeed, t)));
+    _mm_storeu_ps(p.rotationStopTime + i, _mm_max_ps(_mm_sub_ps(timeLeft, t), zero));
+  }
+#else
+  for(int i=0; i<m_nLiveParticleCount; i++)
+  {
     float angularSpeed =
-      part->rotationSpeed * (part->rotationStopTime / m_PIRotationStopTime);
+      p.rotationSpeed[i] * (p.rotationStopTime[i] / m_PIRotationStopTime);
 
-    part->rotation += angularSpeed * m_fElapsedTime;
+    p.rotation[i] += angularSpeed * m_fElapsedTime;
 
-    part->rotationStopTime -= m_fElapsedTime;
+    p.rotationStopTime[i] -= m_fElapsedTime;
 
-    if(part->rotationStopTime < 0.0f)
-      part->rotationStopTime = 0.0f;
+    if(p.rotationStopTime[i] < 0.0f)
+      p.rotationStopTime[i] = 0.0f;
   }
+#endif
 }
 
 
@@ -430,14 +507,6 @@ void ParticleEffect::render()
 
   Vector3 vecRight = Vector3(view._11, view._21, view._31);
   Vector3 vecUp = Vector3(view._12, view._22, view._32);
-  Vector3 vecForward = Vector3(view._13, view._23, view._33);
-
-  // precalculate corners
-  Vector3 ul, ur, bl, br;
-  //ul = -vecRight + vecUp; // upper left
-  //ur = vecRight + vecUp;  // upper right
-  //bl = -vecRight - vecUp; // bottom left
-  //br = vecRight - vecUp;  // bottom right
 
   pD3DDevice->SetTexture(0, m_txtParticleTexture);
 
@@ -446,64 +515,13 @@ void ParticleEffect::render()
     return;
   }
 
-  // shorthand to the current vertex
-  RenderVertexL *vert = &((*m_vertBuffer)[0]);
-
-  // although these values are the same for all particles (except color.alpha),
-  // you could implement some randomness, at which point there would be a
-  // reason to assign to them with every iteration of the loop
-  unsigned int color;
-  float size = m_fPISize/2.0f; // half of m_fPISize in each direction
-  float tTop = 0;
-  float tBottom = 1.0f;
-  float tLeft = 0;
-  float tRight = 1.0f;
-
-  // loop through all live particles to assign proper values to the vertices
-  for (int i=0; i<m_nLiveParticleCount; i++)
-  {
-    Vector3 pos = m_Particles[m_drawOrder[i]].position;
-    color = m_Particles[m_drawOrder[i]].color;
-
-    Vector3 myUp, myRight;
-    Quaternion q;
-    q.setToRotateAboutAxis(vecForward, m_Particles[m_drawOrder[i]].rotation);
-
-    RotationMatrix r;
-    r.fromObjectToInertialQuaternion(q);
-
-    myUp = r.objectToInertial(vecUp);
-    myRight = r.objectToInertial(vecRight);
-
-    ul = -myRight + myUp; // upper left
-    ur = myRight + myUp;  // upper right
-    bl = -myRight - myUp; // bottom left
-    br = myRight - myUp;  // bottom right
-
-    vert->p = pos + ul*size;
-    vert->argb = color;
-    vert->u = tLeft;
-    vert->v = tTop;
-    vert++;
-
-    vert->p = pos + ur*size;
-    vert->argb = color;
-    vert->u = tRight;
-    vert->v = tTop;
-    vert++;
-
-    vert->p = pos + bl*size;
-    vert->argb = color;
-    vert->u = tLeft;
-    vert->v = tBottom;
-    vert++;
-
-    vert->p = pos + br*size;
-    vert->argb = color;
-    vert->u = tRight;
-    vert->v = tBottom;
-    vert++;
-  }
+  // the vertices are written straight into the locked buffer
+  static_assert(sizeof(BillboardVertex) == sizeof(RenderVertexL),
+    "BillboardVertex must match the layout of RenderVertexL");
+  BillboardVertex *vert = (BillboardVertex*)&((*m_vertBuffer)[0]);
+
+  ParticleBillboards::expand(m_particles, m_nLiveParticleCount,
+    vecRight, vecUp, m_fPISize/2.0f, vert);
 
   m_vertBuffer->unlock();
 
@@ -544,84 +562,83 @@ void ParticleEffect::birthParticles()
   if(emit > 0)
     m_fEmitPartial -= (float)emit;
 
-  for(int i=0; i < emit && m_nLiveParticleCount < m_nTotalParticleCount; i++)
+  // new particles go right after the live ones
+  int count = emit;
+  if(count > m_nTotalParticleCount - m_nLiveParticleCount)
+    count = m_nTotalParticleCount - m_nLiveParticleCount;
+
+  // if we're not recycling particles, stop once every particle has had its
+  // turn
+  if(!m_bCycleParticles && count > m_nTotalParticleCount - m_nBirthCount)
   {
-    int index = m_drawOrder[m_nLiveParticleCount];
-    if(initParticle(index))
-      m_nLiveParticleCount++; // success, so add one to our number of live ones
-    else
-      return; // if initParticle returned false, then we are done creating new
-              // particles since no more will be created (non-cycled systems)
+    count = m_nTotalParticleCount - m_nBirthCount;
+    m_IsDying = true;
   }
+
+  if(count <= 0)
+    return;
+
+  initParticles(m_nLiveParticleCount, count);
+  m_nBirthCount += count;
+  m_nLiveParticleCount += count;
 }
 
 
-/// \param i Index of the particle to initialize
-/// \return True if the particle was initialized, false otherwise
-bool ParticleEffect::initParticle(int i)
+/// All the random values are drawn from the effect's own generator, so an
+/// effect started with the same seed and updated with the same time steps
+/// produces the same particles, whichever thread updates it.
+/// \param first Index of the first particle to initialize
+/// \param count Number of particles to initialize
+void ParticleEffect::initParticles(int first, int count)
 {
-  // check bounds on i and current number of particles
-  if(
-    i < 0 || // no negative i
-    i >= m_nTotalParticleCount || // no i greater than total number of particles
-    m_nLiveParticleCount >= m_nTotalParticleCount) // current number can't exceed max
-  {
-    return false;
-  }
-
-  Particle *p = &(m_Particles[i]);
+  ParticleArrays &p = m_particles;
 
-  if(!m_bCycleParticles && p->birthed) // if we're not recycling particles
-  {
-    m_IsDying = true;
-    return false; // don't reinitialize
-  }
+  (*m_distFunc)(m_random, p.velX + first, p.velY + first, p.velZ + first, count);
 
-  // one time initializations, don't assign these values after the
-  // particle is "birthed".
-  if(!p->birthed)
+  for(int i=first; i<first+count; i++)
   {
-    p->size = m_fPISize;
-    p->drag = m_fPIDragValue;
-    p->color = m_cPIColor;
-    p->birthed = true;
+    p.velX[i] *= m_fPISpeed;
+    p.velY[i] *= m_fPISpeed;
+    p.velZ[i] *= m_fPISpeed;
+    p.posX[i] = m_vecPosition.x;
+    p.posY[i] = m_vecPosition.y;
+    p.posZ[i] = m_vecPosition.z;
+    p.lifeleft[i] = m_fPILife;
+    p.color[i] = m_cPIColor;
+    p.rotation[i] = 0.0f;
   }
 
-  p->velocity = (*m_distFunc)() * m_fPISpeed;
-  p->position = m_vecPosition;
-  p->lifeleft = m_fPILife;
-
   // call all other relevant init functions
   for(InitFuncIter iter = m_InitFunc.begin(); iter != m_InitFunc.end(); iter++)
   {
-    (*this.*(*iter))(p);
+    (*this.*(*iter))(first, count);
   }
-
-  return true;
 }
 
-/// \param p Pointer to particle to initialize
-void ParticleEffect::initParticleRotation(Particle *p)
+/// \param first Index of the first particle to initialize
+/// \param count Number of particles to initialize
+void ParticleEffect::initParticleRotation(int first, int count)
 {
-  p->rotationSpeed = (ParticleUtil::randf() - 0.5f) * m_PIRotationSpeed * 2.0f;
-  p->rotationStopTime = m_PIRotationStopTime;
+  m_random.fillUniform(m_particles.rotationSpeed + first, count);
+
+  for(int i=first; i<first+count; i++)
+  {
+    m_particles.rotationSpeed[i] = (m_particles.rotationSpeed[i] - 0.5f) * m_PIRotationSpeed * 2.0f;
+    m_particles.rotationStopTime[i] = m_PIRotationStopTime;
+  }
 }
 
 
 /// Updates particles ages and removes any particles that have expired
 void ParticleEffect::killParticles()
 {
-  // By starting from the back, we do less work. See ParticleEffect::killParticle
-  // for details.
-  for(int i=m_nLiveParticleCount-1; i>=0; i--)
-  {
-    m_Particles[m_drawOrder[i]].lifeleft -= m_fElapsedTime;
+  for(int i=0; i<m_nLiveParticleCount; i++)
+    m_particles.lifeleft[i] -= m_fElapsedTime;
 
-    if(m_Particles[m_drawOrder[i]].lifeleft < 0.0f)
-    {
-      killParticle(i);
-    }
-  }
+  // One compaction pass removes all the expired particles, so a burst of
+  // particles dying together costs the same as a single death. Survivors keep
+  // their order, so the draw order from the last sort is still nearly right.
+  m_nLiveParticleCount = m_particles.removeExpired(m_nLiveParticleCount);
 
   // if we're not cycling and there are none left
   if(m_IsDying && m_nLiveParticleCount == 0)
@@ -629,81 +646,30 @@ void ParticleEffect::killParticles()
 }
 
 
-/// Kills a particle by shifting all the particles from index to the last
-/// particle drawn forward one, then putting the killed particle index at the
-/// end of the list
-/// \param index Draw order index of the particle to kill
-/// \return True if the particle was killed, false otherwise
-bool ParticleEffect::killParticle(int index)
-{
-  if(0 <= index && index < m_nTotalParticleCount)
-  {
-    --m_nLiveParticleCount;
-
-    // if index is the last particle being drawn, we're done
-    if(index == m_nLiveParticleCount)
-      return true;
-
-    int tmp = m_drawOrder[index]; 
-
-    for(int i=index; i<m_nLiveParticleCount; i++)
-    {
-      m_drawOrder[i] = m_drawOrder[i+1];
-    }
-
-    m_drawOrder[m_nLiveParticleCount] = tmp;
-
-    return true;
-  }
-  else
-    return false;
-}
-
-
+/// Only live particles are measured and sorted.  See ParticleSorter for the
+/// algorithms that can be chosen with the mode attribute of the sort tag.
+/// The particles are then copied into drawing order, which also leaves them
+/// nearly sorted for next frame.
 void ParticleEffect::sort()
 {
   if(!m_sort)
     return;
 
-  // get distance to the camera for each particle
+  // get distance to the camera for each live particle
   Vector3 camPos = gRenderer.getCameraPos();
-  for(int i=0; i<m_nTotalParticleCount; i++)
+  for(int i=0; i<m_nLiveParticleCount; i++)
   {
     // magnitude squared saves some time since square root is expensive
-    m_Particles[i].distance =
-      (m_Particles[i].position - camPos).magnitudeSquared();
+    float dx = m_particles.posX[i] - camPos.x;
+    float dy = m_particles.posY[i] - camPos.y;
+    float dz = m_particles.posZ[i] - camPos.z;
+    m_sortDistance[i] = dx*dx + dy*dy + dz*dz;
+    m_drawOrder[i] = i;
   }
 
-  /****************************************************************************
-  *                                                                           *
-  *  Simple bubble sort here. You could implement a faster sort here but it   *
-  *  may not be worth it. Bubble sort is n*p operations, where p is the       *
-  *  number of elements out of place. Since very few particles will become    *
-  *  out of order from frame to frame, p remains very small. As long as p is  *
-  *  comparable to log(n), bubble sort will perform similarly to a            *
-  *  O(n log(n)) algorithm (eg quicksort or mergesort), but without the       *
-  *  added cpu overhead                                                       *
-  *                                                                           *
-  ****************************************************************************/
-
-  bool swapped;
-  do
-  {
-    swapped = false;
-
-    for(int i=0; i<m_nLiveParticleCount-1; i++)
-    {
-      int next = i+1;
-
-      if(m_Particles[m_drawOrder[i]].distance < m_Particles[m_drawOrder[next]].distance)
-      {
-        swap<int>(m_drawOrder[i], m_drawOrder[next]);
-
-        swapped = true;
-      }
-    }
-  }
-  while(swapped);
+  m_sorter.sort(m_sortMode, m_sortDistance, m_drawOrder, m_nLiveParticleCount);
+  m_sortedParticles.gather(m_particles, m_drawOrder, m_nLiveParticleCount);
+  m_particles.swap(m_sortedParticles);
 }
 
 
@@ -725,6 +691,10 @@ bool ParticleEffect::setEmit(TiXmlElement *prop)
 bool ParticleEffect::setSort(TiXmlElement *prop)
 {
   m_sort = (atoi(prop->Attribute("value")) != 0);
+
+  if(prop->Attribute("mode") != NULL)
+    m_sortMode = ParticleSorter::getMode(prop->Attribute("mode"));
+
   return true;
 }
 
@@ -40,12 +40,14 @@
 #include <d3dx9.h>
 #include "tinyxml/tinyxml.h"
 #include "common/Vector3.h"
+#include "common/Random.h"
 
 #include "graphics/VertexBuffer.h"
 #include "graphics/IndexBuffer.h"
 #include "graphics/VertexTypes.h"
+#include "Particle.h"
+#include "ParticleSorter.h"
 
-class Particle;
 class ParticleEngine;
 
 //-----------------------------------------------------------------------------
@@ -61,9 +63,9 @@ private:
   friend class ParticlePropertyMapper;
 
   typedef VertexBuffer<RenderVertexL> VertexLBuffer; ///< Shorthand for a lit vertex buffer
-  typedef Vector3 (*DistributionFunc)(); ///< Shorthand for a function that returns a vector
+  typedef void (*DistributionFunc)(CRandom&, float*, float*, float*, int); ///< Shorthand for a function that writes random vectors
   typedef void (ParticleEffect::*UpdateFunc)(); ///< Shorthand for a function that updates the particles
-  typedef void (ParticleEffect::*InitFunc)(Particle*); ///< Shorthand for a function that initializes the particles
+  typedef void (ParticleEffect::*InitFunc)(int, int); ///< Shorthand for a function that initializes a run of new particles
   typedef std::vector<UpdateFunc> UpdateFuncArray;
   typedef UpdateFuncArray::const_iterator UpdateFuncIter;
   typedef std::vector<InitFunc> InitFuncArray;
@@ -96,14 +98,19 @@ private:
   //------------------------------------------------------------
   /// \brief Effect properties
   //{@
-  Particle *m_Particles; ///< Pointer to particle array
-  int *m_drawOrder; ///< Array of indices determining the order to draw in
+  ParticleArrays m_particles; ///< Particle data; the live particles come first, in drawing order
+  ParticleArrays m_sortedParticles; ///< Particles are copied here in sorted order, then swapped back
+  int *m_drawOrder; ///< Scratch order of live particles used when sorting
   int m_nTotalParticleCount; ///< Max number of particles in the system
   int m_nLiveParticleCount; ///< Number of particles that are currently live
+  int m_nBirthCount; ///< Number of particles created since the effect started
   int m_nEmitRate; ///< Max number of particles to create per second
   float m_fElapsedTime; ///< Time in seconds since last update called
   float m_fEmitPartial; ///< Partial particle, stores the value until greater than 1
   bool m_sort; ///< Whether the system should sort the particles back to front
+  ParticleSorter::Mode m_sortMode; ///< Algorithm used to sort the particles
+  ParticleSorter m_sorter; ///< Sorts m_drawOrder, keeping its buffers between frames
+  float *m_sortDistance; ///< Squared camera distance of each live particle
   bool m_bCycleParticles; ///< True if particles are to be reused after they die
   Vector3 m_vecPosition; ///< System position
   Vector3 m_vecGravity; ///< System gravity
@@ -112,6 +119,7 @@ private:
   bool m_bIsDead; ///< True when all the particles are dead and we aren't cycling
   bool m_IsDying; ///< True when all particles have been created
   int m_textureHandle; ///< Handle to particle texture
+  CRandom m_random; ///< Random numbers for new particles, seeded when the effect starts
   UpdateFuncArray m_UpdateFunc;
   InitFuncArray m_InitFunc;
 
@@ -142,15 +150,13 @@ private:
   //{@
   void initIndexBuffer(); ///< Initializes the index buffer
   void initProperties(TiXmlElement *sysDef); ///< Initializes the effect values
-  void initParticles(); ///< Gives all particles an initial default value
-  void start(); ///< Prepares the effect for starting
+  void start(unsigned int seed); ///< Prepares the effect for starting
 
   void birthParticles(); ///< Creates all particles ready to be "born"
-  bool initParticle(int index); ///< Initializes the particle at the given index
-  void initParticleRotation(Particle *particle);
+  void initParticles(int first, int count); ///< Initializes a run of new particles
+  void initParticleRotation(int first, int count); ///< Initializes the rotation of a run of new particles
 
   void killParticles(); ///< Kills all particles that are too old
-  bool killParticle(int index); ///< Kills the particle at a particular index
 
   void update(float elapsedTime); ///< Updates the particles' values
   void updateFade(); ///< Updates the particles alpha values based on lifeleft
@@ -39,43 +39,26 @@
 #include <d3dx9.h>
 #include "common/Renderer.h"
 #include "common/CommonStuff.h"
-#include <list>
+#include <algorithm>
+#include <string.h>
 
 ParticleEngine gParticle;
 
-/// \brief Handles comparing two particle systems to find which is closer
-/// to the camera.
-struct myCompare
-{
-  typedef ParticleSystem* P;
-
-  /// \param x First particle system.
-  /// \param y Second particle system.
-  /// \return True is x is closer than y, false otherwise.
-  /// \remark In case of a tie, the one with the smaller ID number is 'closer'.
-  bool operator()(const P& x, const P& y) const
-  {
-    float xdist = Vector3::distanceSquared(gRenderer.getCameraPos(), x->getPosition());
-    float ydist = Vector3::distanceSquared(gRenderer.getCameraPos(), y->getPosition());
-
-    if(xdist < ydist)
-      return true;
-    else if(xdist == ydist)
-      return (x->getUID() < y->getUID());
-    else
-      return false;
-  }
-};
-
-typedef std::set<ParticleSystem*, myCompare> SystemSortedSet;
-typedef SystemSortedSet::reverse_iterator SystemSortedSetIter;
+/// Spacing between the seeds of consecutive systems; each effect of a system
+/// adds its index to the system's seed
+static const unsigned int kSeedStride = 1000003;
 
 ParticleEngine::ParticleEngine()
 {
   m_xmlDoc = NULL;
   m_xmlDefs = NULL;
+  m_workers = NULL;
+  m_bRenderListDirty = true;
+  m_nStartCount = 0;
+  m_nDropped = 0;
+  m_nStolen = 0;
 
-  srand(GetTickCount());
+  m_nSeed = GetTickCount();
 }
 
 ParticleEngine::~ParticleEngine()
@@ -112,14 +95,34 @@ void ParticleEngine::init(std::string defFile)
     std::vector<ParticleSystem*> systems;
 
     m_Systems.push_back(systems);
-    SystemCatalogIter iter = m_Systems.end();
-    iter--;
     m_TypeMap.insert(NameTypePair(systemDef->Attribute("name"), numSystemTypes));
 
     int numCopies;
     int numParticlesThisSystem = 0;
     systemDef->Attribute("numcopies", &numCopies);
 
+    // what to do when all the copies are busy
+    SystemType type;
+    type.def = systemDef;
+    type.overflow = OVERFLOW_DROP;
+    type.maxCopies = numCopies * 2;
+
+    const char *overflow = systemDef->Attribute("overflow");
+    if(overflow == NULL || strcmp(overflow, "drop") == 0)
+      type.overflow = OVERFLOW_DROP;
+    else if(strcmp(overflow, "grow") == 0)
+      type.overflow = OVERFLOW_GROW;
+    else if(strcmp(overflow, "steal-oldest") == 0)
+      type.overflow = OVERFLOW_STEAL_OLDEST;
+    else if(strcmp(overflow, "steal-farthest") == 0)
+      type.overflow = OVERFLOW_STEAL_FARTHEST;
+    else
+      ABORT("Unknown overflow policy \"%s\" for particle system %s", overflow, systemDef->Attribute("name"));
+
+    if(systemDef->Attribute("maxcopies") != NULL)
+      systemDef->Attribute("maxcopies", &type.maxCopies);
+    m_Types.push_back(type);
+
     TiXmlElement* effect = systemDef->FirstChildElement("effect");
 
     if(effect == NULL)
@@ -136,9 +139,7 @@ void ParticleEngine::init(std::string defFile)
 
     for(int i=0; i<numCopies; i++)
     {
-      ParticleSystem *sys = new ParticleSystem();
-      iter->push_back(sys);
-      sys->init(systemDef);
+      m_Types[numSystemTypes].freeSystems.push_back(addCopy(numSystemTypes));
     }
 
     systemDef = systemDef->NextSiblingElement("system");
@@ -158,29 +159,96 @@ void ParticleEngine::shutdown()
   }
 
   assert(m_UIDMap.empty());
+
+  delete m_workers;
+  m_workers = NULL;
 }
 
 
+/// With more than one update thread, every effect of every live system is
+/// handed to the worker pool, biggest first so that one large effect doesn't
+/// finish last on its own. Dead systems are only killed afterwards, on this
+/// thread, since killing changes m_UIDMap. Effects draw from their own seeded
+/// generators, so a system looks the same whichever thread updates it; the
+/// pool reseeds each worker's CRT rand() only as a fallback for other jobs.
 void ParticleEngine::updateSystems()
 {
-  UIDMapIter iter = m_UIDMap.begin();
-  while(iter != m_UIDMap.end())
-  {
-    ParticleSystem *sys = iter->second;
-    iter++;
-
-    sys->update(gRenderer.getTimeStep());
+  float dt = gRenderer.getTimeStep();
 
-    if(sys->isDead())
+  if(m_workers == NULL)
+  {
+    for(UIDMapIter iter = m_UIDMap.begin(); iter != m_UIDMap.end(); iter++)
+      iter->second->update(dt);
+  }
+  else
+  {
+    m_effectTasks.clear();
+    m_taskOrder.clear();
+    for(UIDMapIter iter = m_UIDMap.begin(); iter != m_UIDMap.end(); iter++)
     {
-      killSystem(sys->m_UID);
+      ParticleSystem *sys = iter->second;
+      for(int i=0; i<sys->m_NumEffects; i++)
+      {
+        EffectTask task;
+        task.system = sys;
+        task.effect = i;
+        m_taskOrder.push_back(TaskLoad(-sys->getEffectParticleCount(i), (int)m_effectTasks.size()));
+        m_effectTasks.push_back(task);
+      }
     }
+    std::sort(m_taskOrder.begin(), m_taskOrder.end());
+
+    UpdateJob job(*this, dt);
+    m_workers->parallelFor(job, (unsigned int)m_effectTasks.size(), 1);
+  }
+
+  // reclaim the systems that died this frame
+  m_deadSystems.clear();
+  for(UIDMapIter iter = m_UIDMap.begin(); iter != m_UIDMap.end(); iter++)
+  {
+    if(iter->second->isDead())
+      m_deadSystems.push_back(iter->first);
   }
+
+  for(int i=0; i<(int)m_deadSystems.size(); i++)
+    killSystem(m_deadSystems[i]);
+}
+
+ParticleEngine::UpdateJob::UpdateJob(ParticleEngine &engine, float dt) :
+  m_engine(engine),
+  m_dt(dt)
+{
+}
+
+void ParticleEngine::UpdateJob::run(unsigned int begin, unsigned int end, unsigned int worker)
+{
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    EffectTask &task = m_engine.m_effectTasks[m_engine.m_taskOrder[i].second];
+    task.system->updateEffect(task.effect, m_dt);
+  }
+}
+
+/// \param threadCount Total number of threads, counting the caller of
+/// render(). One updates serially; zero uses one per hardware thread.
+void ParticleEngine::setUpdateThreads(unsigned int threadCount)
+{
+  delete m_workers;
+  m_workers = threadCount == 1 ? NULL : new WorkerPool(threadCount);
+}
+
+/// \return The number of threads sharing the effect updates, counting the
+/// caller of render(). One means effects are updated serially.
+unsigned int ParticleEngine::getUpdateThreads() const
+{
+  return m_workers == NULL ? 1 : m_workers->getThreadCount();
 }
 
 
 void ParticleEngine::clear()
 {
+  m_bRenderListDirty = true;
+
   for(int i=0; i<(int)m_Systems.size(); i++)
   {
     for(int j=0; j<(int)m_Systems[i].size(); j++)
@@ -195,16 +263,76 @@ void ParticleEngine::clear()
     m_Systems[i].clear();
   }
   m_Systems.clear();
+  m_Types.clear();
+  m_TypeMap.clear();
+
+  m_nStartCount = 0;
+  m_nDropped = 0;
+  m_nStolen = 0;
+}
+
+/// The copy is owned by m_Systems but is not put on the free list.
+/// \param type Index of the system definition
+/// \return The new copy
+ParticleSystem* ParticleEngine::addCopy(int type)
+{
+  ParticleSystem *sys = new ParticleSystem();
+  sys->init(m_Types[type].def);
+  sys->m_TypeIndex = type;
+  m_Systems[type].push_back(sys);
+  return sys;
+}
+
+/// \param type Index of a system definition whose copies are all in use
+/// \return The copy to restart, or NULL if the type doesn't steal
+ParticleSystem* ParticleEngine::findVictim(int type)
+{
+  OverflowPolicy policy = m_Types[type].overflow;
+  if(policy != OVERFLOW_STEAL_OLDEST && policy != OVERFLOW_STEAL_FARTHEST)
+    return NULL;
+
+  Vector3 camPos = gRenderer.getCameraPos();
+  ParticleSystem *victim = NULL;
+  float victimScore = 0.0f;
+
+  for(int i=0; i<(int)m_Systems[type].size(); i++)
+  {
+    ParticleSystem *sys = m_Systems[type][i];
+    if(!sys->m_bInUse)
+      continue;
+
+    // older start counts and larger distances score higher
+    float score;
+    if(policy == OVERFLOW_STEAL_OLDEST)
+      score = (float)(m_nStartCount - sys->m_StartCount);
+    else
+      score = Vector3::distanceSquared(camPos, sys->getPosition());
+
+    if(victim == NULL || score > victimScore)
+    {
+      victim = sys;
+      victimScore = score;
+    }
+  }
+
+  return victim;
 }
 
 /// Killing a particle system will stop the system from being rendered
 /// \param uid ID of the system to kill
 void ParticleEngine::killSystem(unsigned int uid)
 {
+  m_bRenderListDirty = true;
+
   ParticleSystem *sys = getSystemFromUID(uid);
 
-  if(sys != NULL)
-    sys->reset();
+  if(sys == NULL)
+    return;
+
+  // put the system back on its type's free list
+  sys->reset();
+  sys->m_bInUse = false;
+  m_Types[sys->m_TypeIndex].freeSystems.push_back(sys);
 
   m_UIDMap.erase(uid);
   m_IDGenerator.releaseID(uid);
@@ -213,17 +341,18 @@ void ParticleEngine::killSystem(unsigned int uid)
 /// Kills all particle systems
 void ParticleEngine::killAll()
 {
+  m_bRenderListDirty = true;
 
-  UIDMapIter iter = m_UIDMap.begin();
-  while(iter != m_UIDMap.end())
+  for(UIDMapIter iter = m_UIDMap.begin(); iter != m_UIDMap.end(); iter++)
   {
     ParticleSystem *sys = iter->second;
-    sys->reset();     
-    iter++;    
+    sys->reset();
+    sys->m_bInUse = false;
+    m_Types[sys->m_TypeIndex].freeSystems.push_back(sys);
   }
+  m_UIDMap.clear();
 
   m_IDGenerator.clear();
-
 }
 
 /// Renders all the particle systems. Passing in false for doUpdate allows
@@ -232,27 +361,61 @@ void ParticleEngine::killAll()
 /// \param doUpdate Whether the systems should be updated before rendering
 void ParticleEngine::render(bool doUpdate)
 {
-  static SystemSortedSet sortedSystems;
-  sortedSystems.clear();
-
   if(m_UIDMap.size() == 0)
     return;
 
   if(doUpdate)
     updateSystems();
 
-  // render all systems
-  for(UIDMapIter iter = m_UIDMap.begin(); iter != m_UIDMap.end(); iter++)
+  sortSystems();
+
+  // render all systems, farthest first
+  for(int i=0; i<(int)m_renderOrder.size(); i++)
+  {
+    m_renderSystems[m_renderOrder[i].second]->render();
+  }
+}
+
+/// The render list is only rebuilt from m_UIDMap when systems have been
+/// created or killed; it is then fully sorted. Otherwise last frame's order
+/// is kept, the distances refreshed and the list insertion sorted, which is
+/// close to linear since systems and camera move little between frames.
+void ParticleEngine::sortSystems()
+{
+  Vector3 camPos = gRenderer.getCameraPos();
+
+  if(m_bRenderListDirty)
   {
-    sortedSystems.insert(iter->second);
+    m_renderSystems.clear();
+    m_renderOrder.clear();
+    for(UIDMapIter iter = m_UIDMap.begin(); iter != m_UIDMap.end(); iter++)
+    {
+      float dist = Vector3::distanceSquared(camPos, iter->second->getPosition());
+      m_renderOrder.push_back(DepthKey(-dist, (int)m_renderSystems.size()));
+      m_renderSystems.push_back(iter->second);
+    }
+    std::sort(m_renderOrder.begin(), m_renderOrder.end());
+    m_bRenderListDirty = false;
+    return;
   }
 
-  for(SystemSortedSetIter iter = sortedSystems.rbegin(); iter != sortedSystems.rend(); iter++)
+  for(int i=0; i<(int)m_renderOrder.size(); i++)
   {
-    (*iter)->render();
+    DepthKey key = m_renderOrder[i];
+    key.first = -Vector3::distanceSquared(camPos, m_renderSystems[key.second]->getPosition());
+
+    // slide the system back past the ones now nearer than it
+    int j = i;
+    for(; j > 0 && key < m_renderOrder[j-1]; j--)
+      m_renderOrder[j] = m_renderOrder[j-1];
+    m_renderOrder[j] = key;
   }
 }
 
+/// Free copies are kept on a list per system type. When the list is empty,
+/// the overflow attribute of the system definition decides whether to drop
+/// the request, make another copy (up to maxcopies), or restart the oldest
+/// or farthest copy in use.
 /// \remark Reasons for getting an invalid handle include passing in a bad
 /// effect name and trying to create more than the max number of systems.
 /// \param effectName Name of the particle effect to create
@@ -261,27 +424,41 @@ unsigned int ParticleEngine::createSystem(std::string effectName)
 {
   SystemTypeMap::const_iterator iter = m_TypeMap.find(effectName);
 
-  int catalogIndex = -1;
-
   if(iter == m_TypeMap.end())
     return -1;
-  
-  catalogIndex = iter->second;
-  
-  ParticleSystem *system = NULL;
-  for(int i=0; i< (int)m_Systems[catalogIndex].size(); i++)
+
+  int catalogIndex = iter->second;
+  SystemType &type = m_Types[catalogIndex];
+
+  if(type.freeSystems.empty())
   {
-    if(m_Systems[catalogIndex][i]->isDead())
+    if(type.overflow == OVERFLOW_GROW && (int)m_Systems[catalogIndex].size() < type.maxCopies)
+    {
+      type.freeSystems.push_back(addCopy(catalogIndex));
+    }
+    else
     {
-      system = m_Systems[catalogIndex][i];
-      break;
+      ParticleSystem *victim = findVictim(catalogIndex);
+      if(victim == NULL)
+      {
+        m_nDropped++;
+        return -1;
+      }
+
+      killSystem(victim->m_UID); // puts the victim on the free list
+      m_nStolen++;
     }
   }
 
-  if(system == NULL)
-    return -1;
+  ParticleSystem *system = type.freeSystems.back();
+  type.freeSystems.pop_back();
 
-  system->start();
+  // every start gets its own seed, so the same seed and the same sequence
+  // of requests give the same particles
+  system->start(m_nSeed + m_nStartCount * kSeedStride);
+  system->m_bInUse = true;
+  system->m_StartCount = m_nStartCount++;
+  m_bRenderListDirty = true;
   unsigned int uid = m_IDGenerator.generateID();
   system->m_UID = uid;
   m_UIDMap.insert(UIDIndexPair(uid, system));
@@ -289,6 +466,15 @@ unsigned int ParticleEngine::createSystem(std::string effectName)
   return uid; // this value will be used as the handle
 }
 
+/// Systems started from now on take their random numbers from this seed.
+/// Together with clear(), which restarts the count of started systems, this
+/// makes particle effects repeat exactly, for instance when replaying.
+/// \param seed Seed for the particle random numbers
+void ParticleEngine::setSeed(unsigned int seed)
+{
+  m_nSeed = seed;
+}
+
 /// \param uid ID of the system to move
 /// \param pos Position of the system
 void ParticleEngine::setSystemPos(unsigned int uid, Vector3 pos)
@@ -321,12 +507,23 @@ std::string ParticleEngine::getSystemName(unsigned int uid)
 /// \param numSys Address of an int to store the current number of systems
 /// \param numPart Address of an int to store the current number of particles
 /// in all systems
+/// \param numDropped Address of an int to store the number of systems not
+/// created because every copy was busy, since the engine was initialized
+/// \param numStolen Address of an int to store the number of systems
+/// restarted to make room for new ones, since the engine was initialized
 /// \return The number of particles in all systems
-int ParticleEngine::getPerformanceData(int *numSys, int *numPart)
+int ParticleEngine::getPerformanceData(int *numSys, int *numPart,
+  int *numDropped, int *numStolen)
 {
   if(numSys != NULL)
     *numSys = (int)m_UIDMap.size();
 
+  if(numDropped != NULL)
+    *numDropped = m_nDropped;
+
+  if(numStolen != NULL)
+    *numStolen = m_nStolen;
+
   // loop through all the systems and add up the total number of particles
   int parts = 0;
   
@@ -36,9 +36,9 @@
 #include <string>
 #include <hash_map>
 #include <vector>
-#include <set>
 #include "Particle.h"
 #include "common/Vector3.h"
+#include "common/WorkerPool.h"
 #include "generators/IDGenerator.h"
 
 class ParticleSystem;
@@ -80,15 +80,44 @@ public:
   unsigned int createSystem(std::string effectName); ///< Create a new system
 
   void setSystemPos(unsigned int sysID, Vector3 pos); ///< Set a system's position
+  void setSeed(unsigned int seed); ///< Sets the seed for systems started from now on
 
   std::string getSystemName(unsigned int sysID); ///< Get the definition name of a system
 
   /// \brief Gets the engine performance data
-  int getPerformanceData(int *numSystems, int *numParticles);
+  int getPerformanceData(int *numSystems, int *numParticles,
+    int *numDropped=NULL, int *numStolen=NULL);
+
+  void setUpdateThreads(unsigned int threadCount); ///< Sets how many threads update the effects
+  unsigned int getUpdateThreads() const; ///< Gets how many threads update the effects
 
 private:
+  /// \brief What createSystem does when every copy of a system is in use
+  enum OverflowPolicy
+  {
+    OVERFLOW_DROP, ///< Create nothing
+    OVERFLOW_GROW, ///< Make another copy, up to maxcopies
+    OVERFLOW_STEAL_OLDEST, ///< Restart the copy that was started first
+    OVERFLOW_STEAL_FARTHEST ///< Restart the copy farthest from the camera
+  };
+
+  /// \brief Allocation state of one system definition
+  struct SystemType
+  {
+    TiXmlElement *def; ///< XML tag containing the system definition
+    SystemArray freeSystems; ///< Copies not in use, ready to be started
+    OverflowPolicy overflow; ///< What to do when freeSystems is empty
+    int maxCopies; ///< Most copies OVERFLOW_GROW may make
+  };
+
   SystemCatalog m_Systems; ///< Catalog of all systems possible
   SystemTypeMap m_TypeMap;
+  std::vector<SystemType> m_Types; ///< Free lists and policies, indexed like m_Systems
+
+  unsigned int m_nStartCount; ///< Number of systems started, used to find the oldest and to seed them
+  unsigned int m_nSeed; ///< Seed that the seeds of started systems are derived from
+  int m_nDropped; ///< Systems not created because every copy was in use
+  int m_nStolen; ///< Systems restarted to make room for a new one
 
   IDGenerator m_IDGenerator; ///< ID generator for the systems
   UIDMap m_UIDMap; ///< Map of UID's to particle systems
@@ -97,7 +126,45 @@ private:
   TiXmlElement* m_xmlDefs; ///< Definition node in the particle xml file
   unsigned int m_nLastTimeUpdated; ///< Time of last engine update
 
+  /// \brief One effect of a live system, waiting to be updated
+  struct EffectTask
+  {
+    ParticleSystem *system; ///< System owning the effect
+    int effect; ///< Index of the effect within the system
+  };
+
+  /// \brief Minus the live particles of an effect, paired with its task index
+  typedef std::pair<int, int> TaskLoad;
+
+  /// \brief Updates a slice of m_effectTasks.
+  class UpdateJob : public WorkerPool::Job
+  {
+    public:
+      UpdateJob(ParticleEngine &engine, float dt);
+      virtual void run(unsigned int begin, unsigned int end, unsigned int worker);
+    private:
+      ParticleEngine &m_engine; ///< Engine whose effects are updated
+      float m_dt; ///< Time step passed to the effects
+  };
+  friend class UpdateJob;
+
+  WorkerPool *m_workers; ///< Threads for updating effects, or NULL to update serially
+  std::vector<EffectTask> m_effectTasks; ///< Effects to update this frame
+  std::vector<TaskLoad> m_taskOrder; ///< Tasks from most to fewest particles
+  std::vector<unsigned int> m_deadSystems; ///< Systems found dead after the update
+
+  /// \brief Minus the squared camera distance of a system, paired with its
+  /// index in m_renderSystems, so that sorting puts the farthest first
+  typedef std::pair<float, int> DepthKey;
+
+  SystemArray m_renderSystems; ///< Live systems, as of the last rebuild
+  std::vector<DepthKey> m_renderOrder; ///< Drawing order of m_renderSystems
+  bool m_bRenderListDirty; ///< True if systems were created or killed since the last sort
+
   void updateSystems(); ///< Updates all particle systems
+  ParticleSystem* addCopy(int type); ///< Makes a new copy of a system definition
+  ParticleSystem* findVictim(int type); ///< Picks the copy to steal
+  void sortSystems(); ///< Sorts the live systems from back to front
   ParticleSystem* getSystemFromUID(unsigned int uid); ///< Finds the index mapped to the uid
 };
 //-----------------------------------------------------------------------------
@@ -0,0 +1,166 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file ParticleSorter.cpp
+/// \brief Code for the ParticleSorter class.
+
+#include <string.h>
+#include "ParticleSorter.h"
+
+/// \param name One of "bubble", "insertion" or "radix"
+/// \return Associated mode.  Insertion sort is assumed for unknown names.
+ParticleSorter::Mode ParticleSorter::getMode(const char* name)
+{
+  if(name != NULL)
+  {
+    if(strcmp(name, "bubble") == 0) return SORT_BUBBLE;
+    if(strcmp(name, "radix") == 0) return SORT_RADIX;
+  }
+  return SORT_INSERTION;
+}
+
+/// \param mode Algorithm to use
+/// \param distance Squared distance to the camera of each particle, indexed
+/// by particle index
+/// \param order Particle indices, sorted in place so that the farthest
+/// particle comes first
+/// \param count Number of entries in order to sort
+void ParticleSorter::sort(Mode mode, const float* distance, int* order, int count)
+{
+  if(count < 2)
+    return;
+
+  switch(mode)
+  {
+    case SORT_BUBBLE: bubbleSort(distance, order, count); break;
+    case SORT_RADIX: radixSort(distance, order, count); break;
+    default: insertionSort(distance, order, count); break;
+  }
+}
+
+/// Bubble sort is n*p operations, where p is the number of elements out of
+/// place.  That is fine while few particles change places from frame to
+/// frame, but degrades to n^2 when the camera turns.
+void ParticleSorter::bubbleSort(const float* distance, int* order, int count)
+{
+  bool swapped;
+  do
+  {
+    swapped = false;
+
+    for(int i=0; i<count-1; i++)
+    {
+      if(distance[order[i]] < distance[order[i+1]])
+      {
+        int tmp = order[i];
+        order[i] = order[i+1];
+        order[i+1] = tmp;
+
+        swapped = true;
+      }
+    }
+  }
+  while(swapped);
+}
+
+/// Each particle only moves as far as it is out of place, so a nearly
+/// sorted order costs one pass.
+void ParticleSorter::insertionSort(const float* distance, int* order, int count)
+{
+  for(int i=1; i<count; i++)
+  {
+    int index = order[i];
+    float d = distance[index];
+    int j = i - 1;
+    while(j >= 0 && distance[order[j]] < d)
+    {
+      order[j+1] = order[j];
+      j--;
+    }
+    order[j+1] = index;
+  }
+}
+
+/// Squared distances are never negative, so their bit patterns compare the
+/// same way as the floats do.  Flipping the bits turns far to near into
+/// ascending order, which three stable 11-bit counting passes then produce.
+void ParticleSorter::radixSort(const float* distance, int* order, int count)
+{
+  const int kBits = 11;
+  const unsigned int kMask = (1 << kBits) - 1;
+
+  m_keys.resize(count);
+  m_keyScratch.resize(count);
+  m_orderScratch.resize(count);
+
+  unsigned int* keys = &m_keys[0];
+  unsigned int* keysOut = &m_keyScratch[0];
+  int* orderIn = order;
+  int* orderOut = &m_orderScratch[0];
+
+  for(int i=0; i<count; i++)
+  {
+    unsigned int bits;
+    memcpy(&bits, &distance[order[i]], sizeof(bits));
+    keys[i] = ~bits;
+  }
+
+  for(int shift=0; shift<32; shift+=kBits)
+  {
+    unsigned int offsets[kMask + 1];
+    memset(offsets, 0, sizeof(offsets));
+    for(int i=0; i<count; i++)
+      offsets[(keys[i] >> shift) & kMask]++;
+
+    // every key has the same digit, nothing would move
+    if(offsets[(keys[0] >> shift) & kMask] == (unsigned int)count)
+      continue;
+
+    unsigned int total = 0;
+    for(unsigned int d=0; d<=kMask; d++)
+    {
+      unsigned int n = offsets[d];
+      offsets[d] = total;
+      total += n;
+    }
+
+    for(int i=0; i<count; i++)
+    {
+      unsigned int slot = offsets[(keys[i] >> shift) & kMask]++;
+      keysOut[slot] = keys[i];
+      orderOut[slot] = orderIn[i];
+    }
+
+    unsigned int* tmpKeys = keys; keys = keysOut; keysOut = tmpKeys;
+    int* tmpOrder = orderIn; orderIn = orderOut; orderOut = tmpOrder;
+  }
+
+  if(orderIn != order)
+    memcpy(order, orderIn, count * sizeof(int));
+}
@@ -0,0 +1,82 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file ParticleSorter.h
+/// \brief Interface for the ParticleSorter class.
+
+#ifndef __PARTICLESORTER_H_INCLUDED__
+#define __PARTICLESORTER_H_INCLUDED__
+
+#include <vector>
+
+//-----------------------------------------------------------------------------
+/// \brief Sorts a particle draw order from back to front
+///
+/// The draw order holds particle indices; the keys are squared distances to
+/// the camera, looked up by particle index.  All modes are stable and give
+/// the same order, so the mode only changes how long sorting takes:
+///   - bubble: repeated passes until nothing moves; O(n^2) when the camera
+///     turns quickly.
+///   - insertion: one pass that moves each particle back as far as it needs
+///     to go; O(n) when the order barely changed since last frame.
+///   - radix: three counting passes over the key bits; O(n) whatever the
+///     previous order was.
+/// The sorter keeps scratch buffers between calls, so each effect owns one.
+class ParticleSorter
+{
+public:
+  /// \brief Sorting algorithms
+  enum Mode
+  {
+    SORT_BUBBLE,    ///< Bubble sort
+    SORT_INSERTION, ///< Insertion sort, exploits frame to frame coherence
+    SORT_RADIX      ///< LSD radix sort on the float key bits
+  };
+
+  /// \brief Returns the mode for the given string
+  static Mode getMode(const char* name);
+
+  /// \brief Sorts order[0..count-1] by descending key
+  void sort(Mode mode, const float* distance, int* order, int count);
+
+  /// \name Algorithms
+  //@{
+  static void bubbleSort(const float* distance, int* order, int count);
+  static void insertionSort(const float* distance, int* order, int count);
+  void radixSort(const float* distance, int* order, int count);
+  //@}
+
+private:
+  std::vector<unsigned int> m_keys; ///< Radix keys, in draw order
+  std::vector<unsigned int> m_keyScratch; ///< Radix keys, other buffer
+  std::vector<int> m_orderScratch; ///< Draw order, other buffer
+};
+//-----------------------------------------------------------------------------
+
+#endif
@@ -42,6 +42,10 @@ ParticleSystem::ParticleSystem()
   // initialize members
   m_Effect = NULL;
   m_NumEffects = 0;
+  m_UID = 0;
+  m_TypeIndex = -1;
+  m_bInUse = false;
+  m_StartCount = 0;
   m_Position = Vector3::kZeroVector;
   m_Name = "";
 }
@@ -114,11 +118,13 @@ void ParticleSystem::reset()
     m_Effect[i]->m_bIsDead = true;
 }
 
-void ParticleSystem::start()
+/// \param seed Seed for the random numbers of the first effect; the others
+/// use the following values
+void ParticleSystem::start(unsigned int seed)
 {
   for(int i=0; i<m_NumEffects; i++)
   {
-    m_Effect[i]->start();
+    m_Effect[i]->start(seed + i);
   }
 }
 
@@ -127,11 +133,20 @@ void ParticleSystem::update(float elapsedTime)
 {
   for(int i=0; i<m_NumEffects; i++)
   {
-    m_Effect[i]->setPosition(m_Position);
-    m_Effect[i]->update(elapsedTime);
+    updateEffect(i, elapsedTime);
   }
 }
 
+/// Effects only touch their own particles, so different effects may be
+/// updated on different threads at the same time.
+/// \param index Index of the effect to update
+/// \param elapsedTime Time in seconds since the last update call was made
+void ParticleSystem::updateEffect(int index, float elapsedTime)
+{
+  m_Effect[index]->setPosition(m_Position);
+  m_Effect[index]->update(elapsedTime);
+}
+
 void ParticleSystem::render()
 {
   for(int i=0; i<m_NumEffects; i++)
@@ -167,3 +182,10 @@ int ParticleSystem::getParticleCount()
   return retval;
 }
 
+/// \param index Index of the effect
+/// \return The number of live particles in the effect
+int ParticleSystem::getEffectParticleCount(int index)
+{
+  return m_Effect[index]->getParticleCount();
+}
+
@@ -65,9 +65,11 @@ private:
   void init(TiXmlElement *sysDef); ///< Initialize the system
   void clear(); ///< Clears the system data
   void reset(); ///< Resets the system to initialized state
-  void start(); ///< Sets the effects to alive
+  void start(unsigned int seed); ///< Sets the effects to alive
 
   void update(float elapsedTime); ///< Updates the particles
+  void updateEffect(int index, float elapsedTime); ///< Updates the particles of one effect
+  int getEffectParticleCount(int index); ///< Returns the number of particles in one effect
   void render(); ///< Renders all effects in this system
 
   bool isDead(); ///< Tests whether the system is dead (no live particles)
@@ -84,6 +86,9 @@ private:
 
   ParticleEffect **m_Effect; ///< Pointer to the effects
   unsigned int m_UID; ///< Unique handle to this system
+  int m_TypeIndex; ///< Index of the system definition in the engine's catalog
+  bool m_bInUse; ///< True from creation until the engine reclaims the system
+  unsigned int m_StartCount; ///< Value of the engine's start counter when this was started
   int m_NumEffects; ///< Number of effects
   Vector3 m_Position; ///< Position of the system
   std::string m_Name; ///< Name of the system
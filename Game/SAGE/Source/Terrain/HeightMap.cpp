@@ -44,10 +44,7 @@ extern CRandom Random; // Extern the random number generator
 /// map size will be side * side.
 HeightMap::HeightMap(int side):m_nSide(side)
 {
-  // Create 2D array
-  m_fHeight = new float*[m_nSide];
-  for(int i=0; i<m_nSide; i++)
-    m_fHeight[i] = new float [m_nSide];
+  m_fHeight = new float[m_nSide*m_nSide];
 
   // Set the height to zero
   Clear();
@@ -82,21 +79,19 @@ HeightMap::HeightMap(const char* fileName, float maxHeight, bool defaultDirector
 
 	m_nSide = bitmap.xSize() + 1;
 
-	m_fHeight = new float*[m_nSide];
-	for(int i=0; i<m_nSide; i++)
-	 m_fHeight[i] = new float [m_nSide];	 
+	m_fHeight = new float[m_nSide*m_nSide];
 	
 	for (int y = 0 ;y < m_nSide - 1; y++)
 		for (int x = 0 ;x < m_nSide - 1; x++)
 		{
-			m_fHeight[y][x] = ((float)(0x000000FF & bitmap.getPix(x,y)) / 256.0f) * maxHeight;
+			m_fHeight[y*m_nSide + x] = ((float)(0x000000FF & bitmap.getPix(x,y)) / 256.0f) * maxHeight;
 		}
 
   // Add skirt
   for (int x = 0; x < m_nSide; x++)
   {
-    m_fHeight[m_nSide - 1][x] = m_fHeight[m_nSide - 2][x];
-    m_fHeight[x][m_nSide - 1] = m_fHeight[x][m_nSide - 2];
+    m_fHeight[(m_nSide - 1)*m_nSide + x] = m_fHeight[(m_nSide - 2)*m_nSide + x];
+    m_fHeight[x*m_nSide + m_nSide - 1] = m_fHeight[x*m_nSide + m_nSide - 2];
   }
 	
 } // End of function
@@ -105,16 +100,13 @@ HeightMap::HeightMap(const char* fileName, float maxHeight, bool defaultDirector
 HeightMap::~HeightMap()
 {
   // delete allocated array
-  for(int i=0; i<m_nSide; i++)
-    delete [] m_fHeight[i];
-  delete m_fHeight;  
+  delete [] m_fHeight;  
   m_fHeight = NULL;
 }
 
 // resets all heights to zero
 void HeightMap::Clear()
 { 
-  for (int i = 0 ; i < m_nSide ; ++i)
-	  for (int j = 0 ; j < m_nSide ; ++j) 
-		  m_fHeight[i][j] = 0.0f;
+  for (int i = 0 ; i < m_nSide*m_nSide ; ++i)
+	  m_fHeight[i] = 0.0f;
 }
\ No newline at end of file
@@ -45,9 +45,14 @@ public:
   HeightMap(const char* fileName, float maxHeight, bool defaultDirectory = true); ///< Constructor
   ~HeightMap(void); ///< Destructor
   void Clear(); ///< Reset all heights to zero
+
+  /// \brief Height at a grid point.
+  float getHeight(int row, int col) const {return m_fHeight[row*m_nSide + col];}
+  int getSide() const {return m_nSide;} ///< Number of entries on a side
  
 private:
-  float** m_fHeight; ///< Two dimensional array of height
+  /// \brief Heights stored row-major in one block, m_nSide entries per row.
+  float* m_fHeight;
   int m_nSide; ///< Number of entries on a side
 };
 
@@ -0,0 +1,179 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file HeightQuadtree.cpp
+/// \brief Code for the HeightQuadtree class.
+
+#include "HeightQuadtree.h"
+#include "HeightMap.h"
+
+/// Builds the pyramid from the heights in a height map.
+/// \param heightMap Height map to summarize.  It is not referenced after
+/// construction.
+HeightQuadtree::HeightQuadtree(const HeightMap& heightMap):
+m_nCells(heightMap.getSide() - 1),
+m_nLevels(1)
+{
+  for(int side = m_nCells; side > 1; side = (side + 1) / 2)
+    m_nLevels++;
+  m_levels = new Level[m_nLevels];
+
+  // Level 0 from the four corners of each cell
+  Level& cells = m_levels[0];
+  cells.side = m_nCells;
+  cells.minHeight = new float[m_nCells*m_nCells];
+  cells.maxHeight = new float[m_nCells*m_nCells];
+  for(int i = 0; i < m_nCells; i++)
+    for(int j = 0; j < m_nCells; j++)
+    {
+      float h[4] = {heightMap.getHeight(i, j), heightMap.getHeight(i, j + 1),
+        heightMap.getHeight(i + 1, j), heightMap.getHeight(i + 1, j + 1)};
+      float lo = h[0], hi = h[0];
+      for(int k = 1; k < 4; k++)
+      {
+        if(h[k] < lo) lo = h[k];
+        if(h[k] > hi) hi = h[k];
+      }
+      cells.minHeight[i*m_nCells + j] = lo;
+      cells.maxHeight[i*m_nCells + j] = hi;
+    }
+
+  // Each level above from up to 2x2 nodes of the one below
+  for(int level = 1; level < m_nLevels; level++)
+  {
+    const Level& below = m_levels[level - 1];
+    Level& l = m_levels[level];
+    l.side = (below.side + 1) / 2;
+    l.minHeight = new float[l.side*l.side];
+    l.maxHeight = new float[l.side*l.side];
+    for(int i = 0; i < l.side; i++)
+      for(int j = 0; j < l.side; j++)
+      {
+        float lo = below.minHeight[2*i*below.side + 2*j];
+        float hi = below.maxHeight[2*i*below.side + 2*j];
+        for(int r = 2*i; r <= 2*i + 1 && r < below.side; r++)
+          for(int c = 2*j; c <= 2*j + 1 && c < below.side; c++)
+          {
+            if(below.minHeight[r*below.side + c] < lo) lo = below.minHeight[r*below.side + c];
+            if(below.maxHeight[r*below.side + c] > hi) hi = below.maxHeight[r*below.side + c];
+          }
+        l.minHeight[i*l.side + j] = lo;
+        l.maxHeight[i*l.side + j] = hi;
+      }
+  }
+}
+
+HeightQuadtree::~HeightQuadtree()
+{
+  for(int level = 0; level < m_nLevels; level++)
+  {
+    delete [] m_levels[level].minHeight;
+    delete [] m_levels[level].maxHeight;
+  }
+  delete [] m_levels; m_levels = NULL;
+}
+
+float HeightQuadtree::getMinHeight() const
+{
+  return m_levels[m_nLevels - 1].minHeight[0];
+}
+
+float HeightQuadtree::getMaxHeight() const
+{
+  return m_levels[m_nLevels - 1].maxHeight[0];
+}
+
+/// \param row0 First row of cells
+/// \param col0 First column of cells
+/// \param row1 Last row of cells
+/// \param col1 Last column of cells
+/// \param y Height to test against
+/// \return True if no cell in the rectangle reaches y.  An empty rectangle
+/// is trivially below.
+bool HeightQuadtree::isBelow(int row0, int col0, int row1, int col1, float y) const
+{
+  return isBelow(m_nLevels - 1, 0, 0, row0, col0, row1, col1, y);
+}
+
+/// The cells are appended as row * getCellsPerSide() + col, in no
+/// particular order.  Cells that stay below y cannot touch anything at or
+/// above it, so callers only need exact tests on the cells returned.
+/// \param row0 First row of cells
+/// \param col0 First column of cells
+/// \param row1 Last row of cells
+/// \param col1 Last column of cells
+/// \param y Height to test against
+/// \param cells Receives the cells whose highest corner is at least y
+void HeightQuadtree::findCells(int row0, int col0, int row1, int col1, float y, std::vector<int>& cells) const
+{
+  findCells(m_nLevels - 1, 0, 0, row0, col0, row1, col1, y, cells);
+}
+
+bool HeightQuadtree::isBelow(int level, int row, int col, int row0, int col0, int row1, int col1, float y) const
+{
+  // Skip nodes outside the rectangle
+  int first = 1 << level;
+  if((row + 1)*first <= row0 || row*first > row1 || (col + 1)*first <= col0 || col*first > col1)
+    return true;
+
+  const Level& l = m_levels[level];
+  if(l.maxHeight[row*l.side + col] < y)
+    return true;
+  if(level == 0)
+    return false;
+
+  const Level& below = m_levels[level - 1];
+  for(int r = 2*row; r <= 2*row + 1 && r < below.side; r++)
+    for(int c = 2*col; c <= 2*col + 1 && c < below.side; c++)
+      if(!isBelow(level - 1, r, c, row0, col0, row1, col1, y))
+        return false;
+  return true;
+}
+
+void HeightQuadtree::findCells(int level, int row, int col, int row0, int col0, int row1, int col1, float y, std::vector<int>& cells) const
+{
+  // Skip nodes outside the rectangle
+  int first = 1 << level;
+  if((row + 1)*first <= row0 || row*first > row1 || (col + 1)*first <= col0 || col*first > col1)
+    return;
+
+  const Level& l = m_levels[level];
+  if(l.maxHeight[row*l.side + col] < y)
+    return;
+  if(level == 0)
+  {
+    cells.push_back(row*m_nCells + col);
+    return;
+  }
+
+  const Level& below = m_levels[level - 1];
+  for(int r = 2*row; r <= 2*row + 1 && r < below.side; r++)
+    for(int c = 2*col; c <= 2*col + 1 && c < below.side; c++)
+      findCells(level - 1, r, c, row0, col0, row1, col1, y, cells);
+}
@@ -0,0 +1,85 @@
+/*
+----o0o=================================================================o0o----
+* Copyright (c) 2006, Ian Parberry
+* All rights reserved.
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the University of North Texas nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+----o0o=================================================================o0o----
+*/
+
+/// \file HeightQuadtree.h
+/// \brief Declares class HeightQuadtree
+
+#ifndef __HEIGHTQUADTREE_H_INCLUDED__
+#define __HEIGHTQUADTREE_H_INCLUDED__
+
+#include <vector>
+
+class HeightMap;
+
+/// \class HeightQuadtree
+/// \brief Min/max height pyramid over the cells of a height map.
+///
+/// Level 0 holds the lowest and highest corner of every cell; each level
+/// above merges 2x2 nodes of the one below, up to a single root node.  Cell
+/// (row, col) spans height map entries row..row+1 and col..col+1, so the
+/// triangles of a cell never rise above its level 0 maximum.  Queries take
+/// an inclusive rectangle of cells and descend only into nodes that overlap
+/// it and reach the given height, so a query well above the ground is
+/// answered by the root alone.
+class HeightQuadtree
+{
+public:
+  HeightQuadtree(const HeightMap& heightMap); ///< Constructor
+  ~HeightQuadtree(); ///< Destructor
+
+  int getCellsPerSide() const {return m_nCells;} ///< Number of cells on a side
+  float getMinHeight() const; ///< Lowest height in the whole map
+  float getMaxHeight() const; ///< Highest height in the whole map
+
+  /// \brief Tells whether every cell in the rectangle stays below a height.
+  bool isBelow(int row0, int col0, int row1, int col1, float y) const;
+
+  /// \brief Appends the cells in the rectangle that reach a height.
+  void findCells(int row0, int col0, int row1, int col1, float y, std::vector<int>& cells) const;
+
+private:
+  /// \brief One level of the pyramid, stored row-major.
+  struct Level
+  {
+    int side; ///< Nodes on a side
+    float* minHeight; ///< Lowest height under each node
+    float* maxHeight; ///< Highest height under each node
+  };
+
+  int m_nCells; ///< Cells on a side at level 0
+  int m_nLevels; ///< Number of levels, including the root
+  Level* m_levels; ///< Levels from the cells (0) up to the root
+
+  /// \brief Recursive part of isBelow().
+  bool isBelow(int level, int row, int col, int row0, int col0, int row1, int col1, float y) const;
+  /// \brief Recursive part of findCells().
+  void findCells(int level, int row, int col, int row0, int col0, int row1, int col1, float y, std::vector<int>& cells) const;
+};
+
+#endif
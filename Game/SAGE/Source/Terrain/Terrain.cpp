@@ -37,7 +37,12 @@
 #include "common/random.h"
 #include "tinyxml/tinyxml.h"
 #include "directorymanager/directorymanager.h"
-#include <list>
+#include <float.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define TERRAIN_SSE
+#include <emmintrin.h>
+#endif
 
 extern CRandom Random; // random number generator
 
@@ -153,6 +158,7 @@ Terrain::~Terrain()
     delete [] m_pSubmesh[i];
   }
   delete [] m_pSubmesh;
+  delete m_pQuadtree;
   delete m_pHeightMap;
   for(int i=0; i<m_nSubmeshRatio; i++)
     delete [] m_pSubmeshLODLevel[i];
@@ -243,6 +249,7 @@ void Terrain::parseXML(const char* xmlFileName)
   
   //height map
   m_pHeightMap = new HeightMap(heightMapFileName.c_str(), m_maxHeight);
+  m_pQuadtree = new HeightQuadtree(*m_pHeightMap);
   
 }
 
@@ -377,26 +384,89 @@ float Terrain::getHeight(float x, float z)
   // Compute the grid square in
   int row = (int)x;
   int col = (int)z;
-  int square = row * (m_nVPS - 1) + col;
   
   // Compute the offset within the square
   float xoffset = x - row;
   float zoffset = z - col;
 
-  int index = xoffset > zoffset ? square: square + m_nNumQuads;
-
-  float h0,h1,h2; //heights of vertices in triangle
-  
-  RenderTri* t = &m_triangles[index];
-
-  h0 = m_vertices[t->index[0]].p.y;
-  h1 = m_vertices[t->index[1]].p.y;
-  h2 = m_vertices[t->index[2]].p.y; 
+  // Corner heights straight from the height map, which holds the same values
+  // as the vertices, without going through the triangle list
+  const float* h = m_pHeightMap->m_fHeight + row*m_nVPS + col;
+  float h00 = h[0], h01 = h[1], h10 = h[m_nVPS], h11 = h[m_nVPS + 1];
 
   if (xoffset > zoffset)  // In bottom left triangle
-    return h0 + xoffset*(h2-h0) + zoffset*(h1-h2);
+    return h00 + xoffset*(h10-h00) + zoffset*(h11-h10);
   else // In top right triangle
-    return h2 + (1.0f-xoffset)*(h1-h2) + (1.0f-zoffset)*(h0-h1);
+    return h11 + (1.0f-xoffset)*(h01-h11) + (1.0f-zoffset)*(h00-h01);
+}
+
+/// Samples the terrain at many points at once.  Four points are interpolated
+/// per SSE operation; the corner heights are still fetched one point at a
+/// time.  Points outside the terrain get a height of zero, as with getHeight().
+/// \param xs X coordinates in world space
+/// \param zs Z coordinates in world space
+/// \param out Receives the height at each (xs[i], zs[i])
+/// \param n Number of points
+void Terrain::getHeights(const float* xs, const float* zs, float* out, int n)
+{
+  int i = 0;
+
+#ifdef TERRAIN_SSE
+  const float* heights = m_pHeightMap->m_fHeight;
+  const __m128 offset = _mm_set1_ps(m_fOriginOffset);
+  const __m128 negOffset = _mm_set1_ps(-m_fOriginOffset);
+  const __m128 delta = _mm_set1_ps(m_fDelta);
+  const __m128 one = _mm_set1_ps(1.0f);
+  int rows[4], cols[4];
+  float h00[4], h01[4], h10[4], h11[4];
+
+  for(; i + 4 <= n; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(xs + i);
+    __m128 z = _mm_loadu_ps(zs + i);
+
+    // Same bounds test as isPointWithinBounds(); lanes outside sample the
+    // first square and are zeroed at the end
+    __m128 inside = _mm_and_ps(
+      _mm_and_ps(_mm_cmpge_ps(x, negOffset), _mm_cmple_ps(x, offset)),
+      _mm_and_ps(_mm_cmpge_ps(z, negOffset), _mm_cmple_ps(z, offset)));
+
+    x = _mm_and_ps(inside, _mm_div_ps(_mm_add_ps(x, offset), delta));
+    z = _mm_and_ps(inside, _mm_div_ps(_mm_add_ps(z, offset), delta));
+
+    __m128i row = _mm_cvttps_epi32(x);
+    __m128i col = _mm_cvttps_epi32(z);
+    __m128 xoffset = _mm_sub_ps(x, _mm_cvtepi32_ps(row));
+    __m128 zoffset = _mm_sub_ps(z, _mm_cvtepi32_ps(col));
+
+    _mm_storeu_si128((__m128i*)rows, row);
+    _mm_storeu_si128((__m128i*)cols, col);
+    for(int k = 0; k < 4; k++)
+    {
+      const float* h = heights + rows[k]*m_nVPS + cols[k];
+      h00[k] = h[0]; h01[k] = h[1];
+      h10[k] = h[m_nVPS]; h11[k] = h[m_nVPS + 1];
+    }
+    __m128 a = _mm_loadu_ps(h00), b = _mm_loadu_ps(h01);
+    __m128 c = _mm_loadu_ps(h10), d = _mm_loadu_ps(h11);
+
+    // Both triangles, then pick per lane
+    __m128 bottomLeft = _mm_add_ps(a, _mm_add_ps(
+      _mm_mul_ps(xoffset, _mm_sub_ps(c, a)),
+      _mm_mul_ps(zoffset, _mm_sub_ps(d, c))));
+    __m128 topRight = _mm_add_ps(d, _mm_add_ps(
+      _mm_mul_ps(_mm_sub_ps(one, xoffset), _mm_sub_ps(b, d)),
+      _mm_mul_ps(_mm_sub_ps(one, zoffset), _mm_sub_ps(a, b))));
+    __m128 useBottomLeft = _mm_cmpgt_ps(xoffset, zoffset);
+    __m128 result = _mm_or_ps(_mm_and_ps(useBottomLeft, bottomLeft),
+      _mm_andnot_ps(useBottomLeft, topRight));
+
+    _mm_storeu_ps(out + i, _mm_and_ps(inside, result));
+  }
+#endif
+
+  for(; i < n; i++)
+    out[i] = getHeight(xs[i], zs[i]);
 }
 
 //get normal of terrain at (x,z)
@@ -502,6 +572,45 @@ void Terrain::setCameraPos(const Vector3& p)
       }
 }
 
+// Clips the parametric line start + t*delta to [0, extent] along one axis,
+// narrowing [tEnter, tExit].  Returns false if nothing of it is left.
+static bool clipToSlab(float start, float delta, float extent, float& tEnter, float& tExit)
+{
+  if(delta == 0.0f)
+    return start >= 0.0f && start <= extent;
+  float t0 = -start / delta;
+  float t1 = (extent - start) / delta;
+  if(t0 > t1) { float temp = t0; t0 = t1; t1 = temp; }
+  if(t0 > tEnter) tEnter = t0;
+  if(t1 < tExit) tExit = t1;
+  return tEnter <= tExit;
+}
+
+// Two-sided ray-triangle test (Moller-Trumbore).  On a hit, t is the
+// fraction of delta at which the ray meets the triangle.
+static bool rayTriangle(const Vector3& org, const Vector3& delta,
+  const Vector3& v0, const Vector3& v1, const Vector3& v2, float& t)
+{
+  Vector3 e1 = v1 - v0, e2 = v2 - v0;
+  Vector3 p = Vector3::crossProduct(delta, e2);
+  float det = e1 * p;
+  if(fabs(det) < 1e-12f) return false; // parallel
+  float invDet = 1.0f / det;
+  Vector3 s = org - v0;
+  float u = (s * p) * invDet;
+  if(u < 0.0f || u > 1.0f) return false;
+  Vector3 q = Vector3::crossProduct(s, e1);
+  float v = (delta * q) * invDet;
+  if(v < 0.0f || u + v > 1.0f) return false;
+  t = (e2 * q) * invDet;
+  return t >= 0.0f && t <= 1.0f;
+}
+
+/// Walks the height map cells under the ray in order (2D DDA) and tests the
+/// two triangles of each cell exactly, so the first cell with a hit holds
+/// the nearest one.  Cells whose four corners are all below the ray are
+/// skipped without a triangle test.  A ray that enters the terrain bounds
+/// below the surface intersects at its entry point.
 /// \param pos Position of the starting point of the ray.
 /// \param dir Direction and magnitude of the ray.
 /// \param outPos Position in world space on the terrain that the ray
@@ -509,60 +618,218 @@ void Terrain::setCameraPos(const Vector3& p)
 /// \return True if the ray intersects the terrain.
 bool Terrain::rayIntersect(Vector3 pos, Vector3 dir, Vector3& outPos)
 {
-  std::list<RenderTri*> markedTris;
-  float mag = dir.magnitude();
-  int numSteps = 300;
-  float delta = mag / numSteps; //m_fDelta;
-  dir.normalize();
-  dir *= delta;
+  // Work in grid units, where cell (row, col) spans [row, row+1] x [col, col+1]
+  float gx = (pos.x + m_fOriginOffset) / m_fDelta;
+  float gz = (pos.z + m_fOriginOffset) / m_fDelta;
+  float dx = dir.x / m_fDelta;
+  float dz = dir.z / m_fDelta;
+  float extent = 2.0f * m_fOriginOffset / m_fDelta; // same area as isPointWithinBounds
+  int cells = (int)extent;
+  if(cells < 1) return false;
+
+  // Clip the segment to the terrain's bounds
+  float tEnter = 0.0f, tExit = 1.0f;
+  if(!clipToSlab(gx, dx, extent, tEnter, tExit) ||
+     !clipToSlab(gz, dz, extent, tEnter, tExit))
+    return false;
 
-  
-  bool foundFirstInBounds = false;
-  int lastIndexAdded = -1;
-  bool doesIntersect = false;
-  Vector3 curPos = pos;
+  // Done if the quadtree shows the ground under the clipped segment is lower
+  // than the whole segment
+  int row0, col0, row1, col1;
+  Vector3 enter = pos + dir * tEnter, exit = pos + dir * tExit;
+
+  // Rounding can leave the clipped entry point just outside the bounds,
+  // where getHeight() returns 0, so pull it back onto the terrain
+  float edge = m_fOriginOffset;
+  if(enter.x < -edge) enter.x = -edge; else if(enter.x > edge) enter.x = edge;
+  if(enter.z < -edge) enter.z = -edge; else if(enter.z > edge) enter.z = edge;
+
+  Vector3 low = enter, high = exit;
+  if(low.x > high.x) { low.x = exit.x; high.x = enter.x; }
+  if(low.y > high.y) { low.y = exit.y; high.y = enter.y; }
+  if(low.z > high.z) { low.z = exit.z; high.z = enter.z; }
+  if(getCellRect(low.x, low.z, high.x, high.z, row0, col0, row1, col1) &&
+     m_pQuadtree->isBelow(row0, col0, row1, col1, low.y))
+    return false;
 
-  for(int i=0; i<numSteps; i++)
+  if(enter.y < getHeight(enter.x, enter.z))
   {
-    curPos += dir;
-    if(isPointWithinBounds(curPos.x, curPos.x))
-    {
-      foundFirstInBounds = true;
-      int index = getTriangleIndex(curPos.x, curPos.z);
-
-      if(index == lastIndexAdded) // don't do same triangle twice
-        continue;
-
-      markedTris.push_back(&m_triangles[index]);
+    outPos = enter;
+    outPos.y = getHeight(enter.x, enter.z);
+    return true;
+  }
 
-      if(getHeight(curPos.x, curPos.z) > curPos.y)
-      {
-        doesIntersect = true;
-        outPos.x = curPos.x;
-        outPos.z = curPos.z;
-        outPos.y = getHeight(curPos.x, curPos.z);
-        break;
-      }
-      
-      if(index % 2 == 1) // index is odd, add first half
-      {
-        markedTris.push_back(&m_triangles[index-1]);
-        lastIndexAdded = index - 1;
-      }
-      else // index is even, add second half
+  // Set up the traversal from the cell the ray enters
+  int row = (int)(gx + dx * tEnter);
+  int col = (int)(gz + dz * tEnter);
+  if(row < 0) row = 0; else if(row > cells - 1) row = cells - 1;
+  if(col < 0) col = 0; else if(col > cells - 1) col = cells - 1;
+  int stepRow = dx > 0.0f ? 1 : -1;
+  int stepCol = dz > 0.0f ? 1 : -1;
+  float tDeltaRow = dx != 0.0f ? fabs(1.0f / dx) : FLT_MAX;
+  float tDeltaCol = dz != 0.0f ? fabs(1.0f / dz) : FLT_MAX;
+  float tNextRow = dx != 0.0f ? ((dx > 0.0f ? row + 1 : row) - gx) / dx : FLT_MAX;
+  float tNextCol = dz != 0.0f ? ((dz > 0.0f ? col + 1 : col) - gz) / dz : FLT_MAX;
+
+  const float* heights = m_pHeightMap->m_fHeight;
+  float t = tEnter;
+  for(;;)
+  {
+    float tLeave = tNextRow < tNextCol ? tNextRow : tNextCol;
+    if(tLeave > tExit) tLeave = tExit;
+
+    const float* h = heights + row*m_nVPS + col;
+    float h00 = h[0], h01 = h[1], h10 = h[m_nVPS], h11 = h[m_nVPS + 1];
+    float top = h00;
+    if(h01 > top) top = h01;
+    if(h10 > top) top = h10;
+    if(h11 > top) top = h11;
+    float y0 = pos.y + dir.y * t, y1 = pos.y + dir.y * tLeave;
+
+    if(y0 <= top || y1 <= top)
+    {
+      Vector3 v[4];
+      getCellCorners(row, col, v);
+      float tHit = FLT_MAX, tTri;
+      if(rayTriangle(pos, dir, v[0], v[3], v[2], tTri)) tHit = tTri;
+      if(rayTriangle(pos, dir, v[0], v[1], v[3], tTri) && tTri < tHit) tHit = tTri;
+      if(tHit != FLT_MAX)
       {
-        markedTris.push_back(&m_triangles[index+1]);
-        lastIndexAdded = index + 1;
+        outPos = pos + dir * tHit;
+        return true;
       }
     }
+
+    if(tLeave >= tExit)
+      return false;
+
+    // Step into the next cell
+    if(tNextRow < tNextCol)
+    {
+      row += stepRow;
+      t = tNextRow;
+      tNextRow += tDeltaRow;
+    }
     else
     {
-      if(foundFirstInBounds) // we were in the terrain, and now we're not
-        break;
+      col += stepCol;
+      t = tNextCol;
+      tNextCol += tDeltaCol;
     }
+    if(row < 0 || row >= cells || col < 0 || col >= cells)
+      return false;
+  }
+}
+
+// Closest point to p on triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+static Vector3 closestPointOnTriangle(const Vector3& p,
+  const Vector3& a, const Vector3& b, const Vector3& c)
+{
+  Vector3 ab = b - a, ac = c - a, ap = p - a;
+  float d1 = ab * ap, d2 = ac * ap;
+  if(d1 <= 0.0f && d2 <= 0.0f) return a;
+
+  Vector3 bp = p - b;
+  float d3 = ab * bp, d4 = ac * bp;
+  if(d3 >= 0.0f && d4 <= d3) return b;
+
+  float vc = d1*d4 - d3*d2;
+  if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    return a + ab * (d1 / (d1 - d3));
+
+  Vector3 cp = p - c;
+  float d5 = ab * cp, d6 = ac * cp;
+  if(d6 >= 0.0f && d5 <= d6) return c;
+
+  float vb = d5*d2 - d1*d6;
+  if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    return a + ac * (d2 / (d2 - d6));
+
+  float va = d3*d6 - d5*d4;
+  if(va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+  float denom = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/// The test is against the highest corner of each cell under the box, so a
+/// box close to a slope may be reported as not above it even though it
+/// clears the surface.  Beyond its bounds the terrain counts as height zero,
+/// as in getHeight().
+/// \param box Box in world space
+/// \return True if the bottom of the box is above the terrain everywhere
+/// under it.
+bool Terrain::isBoxAboveTerrain(const AABB3& box)
+{
+  if(box.min.y <= 0.0f && !(isPointWithinBounds(box.min.x, box.min.z) &&
+     isPointWithinBounds(box.max.x, box.max.z)))
+    return false;
+
+  int row0, col0, row1, col1;
+  if(!getCellRect(box.min.x, box.min.z, box.max.x, box.max.z, row0, col0, row1, col1))
+    return true;
+  return m_pQuadtree->isBelow(row0, col0, row1, col1, box.min.y);
+}
+
+/// Only cells that reach the bottom of the sphere get exact sphere-triangle
+/// tests.  Parts of the sphere beyond the terrain's bounds are not tested.
+/// \param center Center of the sphere in world space
+/// \param radius Radius of the sphere
+/// \return True if the sphere touches the terrain, or its center is under it.
+bool Terrain::sphereIntersect(const Vector3& center, float radius)
+{
+  if(isPointWithinBounds(center.x, center.z) && center.y < getHeight(center.x, center.z))
+    return true;
+
+  int row0, col0, row1, col1;
+  if(!getCellRect(center.x - radius, center.z - radius,
+       center.x + radius, center.z + radius, row0, col0, row1, col1))
+    return false;
+
+  m_queryCells.clear();
+  m_pQuadtree->findCells(row0, col0, row1, col1, center.y - radius, m_queryCells);
+
+  float radiusSquared = radius * radius;
+  int cellsPerSide = m_pQuadtree->getCellsPerSide();
+  for(unsigned int i = 0; i < m_queryCells.size(); i++)
+  {
+    Vector3 v[4];
+    getCellCorners(m_queryCells[i] / cellsPerSide, m_queryCells[i] % cellsPerSide, v);
+    if((closestPointOnTriangle(center, v[0], v[3], v[2]) - center).magnitudeSquared() <= radiusSquared ||
+       (closestPointOnTriangle(center, v[0], v[1], v[3]) - center).magnitudeSquared() <= radiusSquared)
+      return true;
   }
+  return false;
+}
+
+/// \param start Start of the segment in world space
+/// \param end End of the segment in world space
+/// \param outPos Receives the first point on the terrain along the segment
+/// \return True if the segment intersects the terrain.
+bool Terrain::segmentIntersect(const Vector3& start, const Vector3& end, Vector3& outPos)
+{
+  return rayIntersect(start, end - start, outPos);
+}
 
-  return doesIntersect;
+/// Casts many rays at once, such as line of sight checks or bullets against
+/// the ground.  Each ray is handled as in the single ray version.
+/// \param pos Starting points of the rays.
+/// \param dir Direction and magnitude of each ray.
+/// \param n Number of rays.
+/// \param outHit Receives true for each ray that intersects the terrain.
+/// \param outPos Receives the intersection point of each ray that hits.
+/// \return Number of rays that intersect the terrain.
+int Terrain::rayIntersect(const Vector3* pos, const Vector3* dir, int n,
+  bool* outHit, Vector3* outPos)
+{
+  int hits = 0;
+  for(int i = 0; i < n; i++)
+  {
+    outHit[i] = rayIntersect(pos[i], dir[i], outPos[i]);
+    if(outHit[i]) hits++;
+  }
+  return hits;
 }
 
 /// \param x X coordinate in world space
@@ -579,6 +846,43 @@ bool Terrain::isPointWithinBounds(float x, float z)
 }
 
 
+// Converts a footprint in world space to the inclusive range of cells under
+// it, clipped to the area inside isPointWithinBounds().
+/// \return False if the footprint misses the terrain.
+bool Terrain::getCellRect(float minX, float minZ, float maxX, float maxZ,
+  int& row0, int& col0, int& row1, int& col1)
+{
+  float extent = 2.0f * m_fOriginOffset / m_fDelta;
+  float gx0 = (minX + m_fOriginOffset) / m_fDelta, gx1 = (maxX + m_fOriginOffset) / m_fDelta;
+  float gz0 = (minZ + m_fOriginOffset) / m_fDelta, gz1 = (maxZ + m_fOriginOffset) / m_fDelta;
+  if(gx1 < 0.0f || gx0 > extent || gz1 < 0.0f || gz0 > extent)
+    return false;
+
+  int last = (int)extent - 1;
+  row0 = gx0 > 0.0f ? (int)gx0 : 0;
+  col0 = gz0 > 0.0f ? (int)gz0 : 0;
+  row1 = gx1 < extent ? (int)gx1 : last;
+  col1 = gz1 < extent ? (int)gz1 : last;
+  if(row0 > last) row0 = last;
+  if(col0 > last) col0 = last;
+  if(row1 > last) row1 = last;
+  if(col1 > last) col1 = last;
+  return true;
+}
+
+// Gets the corners of cell (row, col) in world space
+/// \param corners Receives (row, col), (row, col+1), (row+1, col) and
+/// (row+1, col+1), in that order.
+void Terrain::getCellCorners(int row, int col, Vector3* corners)
+{
+  const float* h = m_pHeightMap->m_fHeight + row*m_nVPS + col;
+  float x = row*m_fDelta - m_fOriginOffset, z = col*m_fDelta - m_fOriginOffset;
+  corners[0] = Vector3(x, h[0], z);
+  corners[1] = Vector3(x, h[1], z + m_fDelta);
+  corners[2] = Vector3(x + m_fDelta, h[m_nVPS], z);
+  corners[3] = Vector3(x + m_fDelta, h[m_nVPS + 1], z + m_fDelta);
+}
+
 // Calculates the blending weights of textures based on a height
 /// One blending weight is given to each vertex for each texture.  The weight
 /// that each texture is rendered at is calculated based on the height of the 
@@ -769,7 +1073,7 @@ void Terrain::setTerrainFromHeightMap()
 	  for (int j = 0 ; j < m_nVPS ; ++j) 
 	  {
 		  v = &m_vertices[i*m_nVPS+j];
-		  v->p.y = m_pHeightMap->m_fHeight[i][j];		  
+		  v->p.y = m_pHeightMap->getHeight(i, j);		  
 		  calculateWeightsAtPoint(v->p.y,v->Weights1,v->Weights2);		                
 	  }
 }
@@ -33,8 +33,11 @@
 #ifndef __TERRAIN_H_INCLUDED__
 #define __TERRAIN_H_INCLUDED__
 
+#include <vector>
 #include "common/renderer.h"
+#include "common/AABB3.h"
 #include "HeightMap.h"
+#include "HeightQuadtree.h"
 #include "graphics/effect.h"
 #include "terrainsubmesh.h"
 #include "common/vector3.h"
@@ -70,6 +73,8 @@ public:
   void clearNormals(); ///< Sets all normals to the up vector
   void initNormals(); ///< Calculates the normals from the heights  
   float getHeight(float x, float z); ///< Get height of terrain at (x,z)
+  /// \brief Get heights of terrain at n points (xs[i], zs[i])
+  void getHeights(const float* xs, const float* zs, float* out, int n);
   Vector3 getNormal(float x, float z); ///< Get normal of terrain at (x,z)
   
 
@@ -79,9 +84,23 @@ public:
   void setCameraPos(const Vector3& p); 
   /// \brief Tells if and where a ray intersects the terrain.
   bool rayIntersect(Vector3 pos, Vector3 dir, Vector3& outPos);
+  /// \brief Tells which of n rays intersect the terrain, and where.
+  int rayIntersect(const Vector3* pos, const Vector3* dir, int n, bool* outHit, Vector3* outPos);
   /// \brief Checks to see if a point is over or under the terrain.
   bool isPointWithinBounds(float x, float z);
 
+  /// \name Range Queries
+  /// Answered from a min/max height quadtree, so objects well above the
+  /// ground are rejected after a single node test.
+  //@{
+  /// \brief Tells if a box is above the terrain everywhere under it.
+  bool isBoxAboveTerrain(const AABB3& box);
+  /// \brief Tells if a sphere touches or is under the terrain.
+  bool sphereIntersect(const Vector3& center, float radius);
+  /// \brief Tells if and where a segment intersects the terrain.
+  bool segmentIntersect(const Vector3& start, const Vector3& end, Vector3& outPos);
+  //@}
+
 private:  
   int m_nSide; ///< Number of quads per side
   int m_nSubmeshSide; ///< Number of quads per submesh side
@@ -97,6 +116,8 @@ private:
   bool m_bCrackRepair; ///< True for crack repair in distance LOD
   int m_nCurrentLOD; ///< Current LOD level
   HeightMap* m_pHeightMap; ///< Height map
+  HeightQuadtree* m_pQuadtree; ///< Min/max heights over m_pHeightMap
+  std::vector<int> m_queryCells; ///< Scratch list of cells for range queries
   /// \brief Array of arrays of all the submeshes.  This is needed because
   /// of multiple levels of detail.
   TerrainSubmesh*** m_pSubmesh;
@@ -137,7 +158,12 @@ private:
   /// \brief Calculates the blending weights of textures based on a height
   void calculateWeightsAtPoint(float height, DWORD& outWeight1, DWORD& outWeight2);  
   /// \brief Returns the row and column of the location (x, z)
-  void getSubmeshIndex(float x, float z,int& row, int& col);  
+  void getSubmeshIndex(float x, float z,int& row, int& col);
+  /// \brief Gets the range of cells under a footprint in world space.
+  bool getCellRect(float minX, float minZ, float maxX, float maxZ,
+    int& row0, int& col0, int& row1, int& col1);
+  /// \brief Gets the world space corners of a cell.
+  void getCellCorners(int row, int col, Vector3* corners);  
   void initMeshVertices(); ///< Sets mesh vertices to a grid 
   void initMeshTriangles(); ///< Sets up the triangle list m_triangles
   /// \brief Calculates the normals of every triangle in the triangle list m_triangles